@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <flash>
+
+namespace firmware {
+namespace step_motor {
+
+/// PWM duty of the four coil ends at one position of the electrical cycle
+struct CoilDuty {
+    uint8_t ap;
+    uint8_t an;
+    uint8_t bp;
+    uint8_t bn;
+};
+
+enum class DriveMode : uint8_t {
+    WAVE,     // one coil at a time, 4 steps per cycle
+    FULL,     // two coils at a time, 4 steps per cycle, more torque
+    HALF,     // alternating one and two coils, 8 steps per cycle
+    MICRO_4,  // sine / cosine currents, 16 steps per cycle
+    MICRO_8,  // 32 steps per cycle
+    MICRO_16, // 64 steps per cycle
+};
+
+namespace __details {
+constexpr double pi = 3.14159265358979323846;
+
+/// sin(x) by its Taylor series after reducing x to [-pi, pi], for tables built at compile time
+constexpr double sine(double x) noexcept {
+    while (x > pi) x -= 2 * pi;
+    while (x < -pi) x += 2 * pi;
+    double term = x, sum = x;
+    for (int k = 1; k < 12; k++) {
+        term *= -x * x / ((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr uint8_t duty(double v) noexcept { return v <= 0 ? 0 : static_cast<uint8_t>(v * 255 + 0.5); }
+
+template <size_t L>
+struct phase_table {
+    CoilDuty at[L];
+};
+
+/// L positions per electrical cycle, coil A follows the cosine and coil B the sine, so position 0 is A+ alone
+template <size_t L>
+constexpr phase_table<L> sine_table() noexcept {
+    phase_table<L> t{};
+    for (size_t i = 0; i < L; i++) {
+        double a = sine(2 * pi * i / L + pi / 2);
+        double b = sine(2 * pi * i / L);
+        t.at[i]  = { duty(a), duty(-a), duty(b), duty(-b) };
+    }
+    return t;
+}
+
+/// the classic half-step sequence: even positions energise one coil end, odd positions the two around it
+constexpr phase_table<8> half_table() noexcept {
+    phase_table<8> t{};
+    for (uint8_t i = 0; i < 8; i++) {
+        // coil end k (A+, B+, A-, B-) sits at position 2k and stays on one position either side
+        auto on = [i](uint8_t k) -> uint8_t { return ((i - 2 * k + 1) & 7) <= 2 ? 255 : 0; };
+        t.at[i] = { on(0), on(2), on(1), on(3) };
+    }
+    return t;
+}
+
+constexpr uint8_t SINE_POSITIONS = 64; // MICRO_16 over the four full steps of a cycle
+
+inline constexpr phase_table<SINE_POSITIONS> sine_positions MSD_FLASH = sine_table<SINE_POSITIONS>();
+inline constexpr phase_table<8> half_positions MSD_FLASH              = half_table();
+} // namespace __details
+
+/*
+ * Walks the coil duty tables of a DriveMode. A step is one masked index addition, the duties of
+ * all four coil ends come out of the flash table at the new index: no branch per coil, and the
+ * finer modes cost the same per step as full steps.
+ *
+ * WAVE, FULL and HALF walk the 8 position half-step table with a stride of 2 (WAVE on the even
+ * positions, FULL on the odd ones) or 1; the MICRO modes walk the 64 position sine table with a
+ * stride of 16 / microsteps.
+ */
+class PhaseSequencer {
+    private:
+    const CoilDuty* m_table;
+    uint8_t m_mask;   // table length - 1, lengths are powers of two
+    uint8_t m_stride; // table positions per step
+    uint8_t m_index;
+    DriveMode m_mode;
+
+    public:
+    PhaseSequencer() noexcept
+    : m_table(__details::half_positions.at), m_mask(7), m_stride(2), m_index(0), m_mode(DriveMode::WAVE) {}
+
+    /// @brief switch tables at the nearest position of the new mode to the current electrical angle
+    /// FULL has no position where WAVE and HALF energise a single coil, the rotor moves half a step
+    void set_mode(DriveMode mode) noexcept {
+        uint8_t unit  = __details::SINE_POSITIONS / (m_mask + 1);
+        uint8_t angle = m_index * unit; // in 1/64 of the cycle
+        uint8_t offset = 0;
+        switch (mode) {
+        case DriveMode::WAVE: m_table = __details::half_positions.at, m_mask = 7, m_stride = 2; break;
+        case DriveMode::FULL: m_table = __details::half_positions.at, m_mask = 7, m_stride = 2, offset = 1; break;
+        case DriveMode::HALF: m_table = __details::half_positions.at, m_mask = 7, m_stride = 1; break;
+        case DriveMode::MICRO_4: m_table = __details::sine_positions.at, m_mask = 63, m_stride = 4; break;
+        case DriveMode::MICRO_8: m_table = __details::sine_positions.at, m_mask = 63, m_stride = 2; break;
+        case DriveMode::MICRO_16: m_table = __details::sine_positions.at, m_mask = 63, m_stride = 1; break;
+        }
+        m_mode = mode;
+        unit   = __details::SINE_POSITIONS / (m_mask + 1);
+        int pos   = angle / unit - offset + m_stride / 2;
+        pos       = (pos < 0 ? 0 : pos / m_stride) * m_stride + offset;
+        m_index   = static_cast<uint8_t>(pos & m_mask);
+    }
+
+    DriveMode mode() const noexcept { return m_mode; }
+
+    void forward() noexcept { m_index = (m_index + m_stride) & m_mask; }
+    void backward() noexcept { m_index = (m_index - m_stride) & m_mask; }
+
+    /// duties at the current position
+    CoilDuty current() const noexcept { return msd::flash_load(m_table + m_index); }
+
+    /// current position in the table of the mode
+    uint8_t index() const noexcept { return m_index; }
+
+    /// steps per electrical cycle, four full steps
+    uint8_t steps_per_cycle() const noexcept { return static_cast<uint8_t>((m_mask + 1) / m_stride); }
+};
+
+} // namespace step_motor
+} // namespace firmware
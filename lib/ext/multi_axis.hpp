@@ -0,0 +1,144 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "speed_ramp.hpp"
+
+namespace firmware {
+namespace step_motor {
+
+/*
+ * Coordinated straight-line moves of N axes from one timer interrupt.
+ *
+ * The axis with the most steps (the major axis) is timed by a SpeedRamp and steps on every
+ * interrupt. Every other axis runs a Bresenham error term against it: add its delta, step
+ * when the sum reaches the major delta. That is one add and one compare per axis per
+ * interrupt, no division, and every axis is within half a step of the ideal line at all times,
+ * so all of them start and arrive together.
+ */
+/// @tparam N  number of axes
+/// @tparam Timer  same requirements as for RampDriver, see firmware::timer1
+template <size_t N, typename Timer>
+class MultiAxisDriver {
+    static_assert(N > 0, "at least one axis");
+
+    private:
+    SpeedRamp m_ramp;
+    uint32_t m_major;       // steps of the longest axis
+    uint32_t m_delta[N];    // |steps| per axis
+    uint32_t m_error[N];    // Bresenham accumulator per axis
+    int32_t m_position[N];
+    int8_t m_dir[N];
+    TimerDelay m_delay;
+
+    // the ISR writes the state behind the compiler's back
+    static void barrier() noexcept { __asm__ __volatile__("" ::: "memory"); }
+
+    void setup(const int32_t (&steps)[N]) noexcept {
+        m_major = 0;
+        for (size_t i = 0; i < N; i++) {
+            m_dir[i]   = steps[i] < 0 ? -1 : 1;
+            m_delta[i] = static_cast<uint32_t>(steps[i] < 0 ? -steps[i] : steps[i]);
+            if (m_delta[i] > m_major) m_major = m_delta[i];
+        }
+        // start half way so steps land on the nearest major step instead of trailing it
+        for (size_t i = 0; i < N; i++) m_error[i] = m_major / 2;
+    }
+
+    void start(uint32_t first) noexcept {
+        barrier();
+        if (first) Timer::start(m_delay.start(first));
+    }
+
+    public:
+    MultiAxisDriver() noexcept : m_major(0) {
+        for (size_t i = 0; i < N; i++) {
+            m_delta[i]    = 0;
+            m_error[i]    = 0;
+            m_position[i] = 0;
+            m_dir[i]      = 1;
+        }
+    }
+
+    /// @brief start a coordinated move and return, the ISR emits the steps
+    /// @param steps  signed steps per axis
+    /// @param speed, accel, decel  along the major axis, in steps/s and steps/s^2
+    void move(const int32_t (&steps)[N], uint16_t speed, uint16_t accel, uint16_t decel) noexcept {
+        Timer::stop();
+        setup(steps);
+        start(m_ramp.plan(m_major, speed, accel, decel, Timer::frequency));
+    }
+
+    /// @brief start one segment of a path, entering and leaving at the given major axis speeds
+    /// safe to call from the ISR's completion hook to chain segments without stopping
+    void move(const int32_t (&steps)[N], uint16_t entry, uint16_t speed, uint16_t exit, uint16_t accel) noexcept {
+        Timer::stop();
+        setup(steps);
+        start(m_ramp.plan(m_major, entry, speed, exit, accel, Timer::frequency));
+    }
+
+    /// @brief timer compare ISR body, step(axis, forward) drives one motor
+    template <typename StepFn>
+    void isr(StepFn&& step) {
+        if (!m_ramp.is_running()) {
+            Timer::stop();
+            return;
+        }
+        if (m_delay.waiting()) {
+            Timer::set_period(m_delay.rest());
+            return;
+        }
+        for (size_t i = 0; i < N; i++) {
+            m_error[i] += m_delta[i];
+            if (m_error[i] < m_major) continue;
+            m_error[i] -= m_major;
+            step(static_cast<uint8_t>(i), m_dir[i] > 0);
+            m_position[i] += m_dir[i];
+        }
+        uint32_t next = m_ramp.next();
+        if (next) Timer::set_period(m_delay.start(next));
+        else Timer::stop();
+    }
+
+    /// @brief halt every axis at once, without deceleration
+    void stop() noexcept {
+        Timer::stop();
+        m_ramp.stop();
+        barrier();
+    }
+
+    RampState state() const noexcept {
+        barrier();
+        return m_ramp.state();
+    }
+    bool is_running() const noexcept { return state() != RampState::STOP; }
+
+    int32_t position(size_t axis) const noexcept {
+        bool enabled = Timer::mask();
+        barrier();
+        int32_t p = m_position[axis];
+        Timer::unmask(enabled);
+        return p;
+    }
+
+    void set_position(size_t axis, int32_t p) noexcept {
+        bool enabled     = Timer::mask();
+        m_position[axis] = p;
+        Timer::unmask(enabled);
+    }
+
+    /// steps left on the major axis
+    uint32_t steps_left() const noexcept {
+        bool enabled = Timer::mask();
+        barrier();
+        uint32_t n = m_ramp.steps_left();
+        Timer::unmask(enabled);
+        return n;
+    }
+
+    static constexpr size_t axes() noexcept { return N; }
+};
+
+} // namespace step_motor
+} // namespace firmware
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "microstep.hpp"
+#include "speed_ramp.hpp"
+
+namespace firmware {
+namespace step_motor {
+
+/*
+ * StepMotor with its coil pins bound at compile time.
+ *
+ * AP, AN, BP and BN are pin types with static dwrite(bool) and awrite(uint8_t), such as
+ * firmware::pins<PIN, PinMode::OUTPUT>. The pin numbers live in the type, so the object holds
+ * no pin state and every coil write inlines into the pin's own write, a port access for
+ * firmware::pins instead of a call through digitalWrite with a runtime pin number.
+ *
+ * Timer runs the non-blocking moves as for RampDriver. One motor moves per timer, whatever its
+ * type: step() stops the motor or group holding the timer, see TimerOwner; PinStepMotor binds
+ * Timer1.
+ */
+template <typename AP, typename AN, typename BP, typename BN, typename Timer>
+class BasicPinStepMotor {
+    private:
+    PhaseSequencer m_phase;
+    RampDriver<Timer> m_driver;
+    uint16_t m_speed; // steps/s
+    uint16_t m_accel; // steps/s^2, 0 for none
+    uint8_t m_power;
+    bool m_is_enable_power;
+
+    static inline BasicPinStepMotor* s_active = nullptr;
+
+    static void on_timer() {
+        s_active->m_driver.isr([](bool forward) { s_active->step_once(forward); });
+    }
+
+    static void release() noexcept {
+        if (s_active) s_active->stop();
+    }
+
+    uint8_t scale(uint8_t duty) const noexcept { return static_cast<uint8_t>((uint16_t(duty) * m_power + 255) >> 8); }
+
+    public:
+    BasicPinStepMotor() noexcept : m_speed(1), m_accel(0), m_power(255), m_is_enable_power(false) {
+        AP::init(), AN::init(), BP::init(), BN::init();
+    }
+
+    ~BasicPinStepMotor() noexcept {
+        if (s_active == this) stop(), s_active = nullptr;
+    }
+
+    BasicPinStepMotor(const BasicPinStepMotor&)            = delete;
+    BasicPinStepMotor& operator=(const BasicPinStepMotor&) = delete;
+
+    void enable_power() noexcept { m_is_enable_power = true; }
+    void disable_power() noexcept { m_is_enable_power = false; }
+
+    void set_power(uint8_t power) noexcept { m_power = power; }
+    uint8_t get_power() const noexcept { return m_power; }
+
+    /// speed in steps/s
+    void set_speed(uint16_t speed) noexcept { m_speed = speed ? speed : 1; }
+    /// acceleration and deceleration of step() in steps/s^2, 0 starts and stops at full speed
+    void set_acceleration(uint16_t accel) noexcept { m_accel = accel; }
+
+    /// @brief drive mode of every following step; the MICRO modes need enable_power() for PWM
+    void set_mode(DriveMode mode) noexcept {
+        m_phase.set_mode(mode);
+        state_open();
+    }
+    DriveMode get_mode() const noexcept { return m_phase.mode(); }
+
+    /// @brief start a trapezoidal move and return at once, the timer ISR emits the steps
+    void step(int32_t s) {
+        if (s == 0) return;
+        TimerOwner<Timer>::claim(&release, &on_timer);
+        s_active = this;
+        m_driver.move(s, m_speed, m_accel, m_accel);
+    }
+
+    /// halt at once, without deceleration
+    void stop() noexcept { m_driver.stop(); }
+
+    // status, safe to poll while the ISR runs
+    bool is_moving() const noexcept { return m_driver.is_running(); }
+    RampState get_motion_state() const noexcept { return m_driver.state(); }
+    int32_t get_position() const noexcept { return m_driver.position(); }
+    uint32_t get_steps_left() const noexcept { return m_driver.steps_left(); }
+
+    /// advance one step without waiting
+    void step_once(bool forward) noexcept {
+        if (forward) {
+            m_phase.forward();
+        } else {
+            m_phase.backward();
+        }
+        state_open();
+    }
+
+    /// release every coil
+    void state_close() noexcept {
+        if (m_is_enable_power) {
+            AP::awrite(0), AN::awrite(0), BP::awrite(0), BN::awrite(0);
+        } else {
+            AP::dwrite(false), AN::dwrite(false), BP::dwrite(false), BN::dwrite(false);
+        }
+    }
+
+    /// energise the coils for the current position, duties scaled by the power setting
+    void state_open() noexcept {
+        CoilDuty d = m_phase.current();
+        if (m_is_enable_power) {
+            AP::awrite(scale(d.ap)), AN::awrite(scale(d.an)), BP::awrite(scale(d.bp)), BN::awrite(scale(d.bn));
+        } else {
+            AP::dwrite(d.ap >= 128), AN::dwrite(d.an >= 128), BP::dwrite(d.bp >= 128), BN::dwrite(d.bn >= 128);
+        }
+    }
+};
+
+} // namespace step_motor
+} // namespace firmware
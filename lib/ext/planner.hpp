@@ -0,0 +1,184 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <queue>
+
+namespace firmware {
+namespace step_motor {
+
+/// one planned segment as the step driver runs it, speeds along the major axis
+template <size_t N>
+struct Motion {
+    int32_t steps[N];
+    uint16_t entry; // steps/s
+    uint16_t speed;
+    uint16_t exit;
+    uint16_t accel; // steps/s^2
+};
+
+/*
+ * Lookahead planner for straight segments in step space, in the manner of Grbl's planner.
+ *
+ * Every buffered segment (a block) carries the square of its entry speed. Squares keep the
+ * passes free of square roots: a block of length s can change v^2 by at most 2 a s. Speeds,
+ * lengths and acceleration are along the path, the Euclidean norm of the per-axis steps.
+ *
+ * A new block enters at most at its junction speed with the block before it (junction
+ * deviation: how fast the corner can be taken so the path stays within `deviation` steps of
+ * the corner under the acceleration limit) and leaves at zero, the buffer may run dry after it.
+ * Then a reverse pass raises entry speeds as far as the new room to decelerate allows, and a
+ * forward pass caps them by what acceleration can reach. Both passes stop at m_planned, the
+ * last block whose entry speed can no longer improve, so a push only touches the blocks that
+ * its arrival can change.
+ *
+ * The front block's entry speed is fixed: it is the exit speed of the segment already running.
+ */
+template <size_t N, size_t Depth = 16>
+class Planner {
+    public:
+    struct block {
+        int32_t steps[N];
+        uint32_t major;     // steps of the longest axis
+        float length;       // steps along the path
+        float nominal_sq;   // requested speed^2
+        float max_entry_sq; // junction and nominal limit
+        float entry_sq;     // planned entry speed^2
+    };
+
+    private:
+    msd::queue<block, Depth> m_blocks;
+    size_t m_planned; // blocks up to this index are optimal
+    float m_accel;    // steps/s^2 along the path
+    float m_deviation;
+    float m_prev_unit[N]; // direction of the newest block
+
+    static float min(float a, float b) noexcept { return a < b ? a : b; }
+
+    /// largest speed^2 through the corner between the newest block and one along unit
+    float junction_sq(const float (&unit)[N]) const noexcept {
+        float cos_theta = 0; // cosine of the angle between the direction in and the reverse of the direction out
+        for (size_t i = 0; i < N; i++) cos_theta -= m_prev_unit[i] * unit[i];
+        if (cos_theta > 0.999999f) return 0;     // straight back
+        if (cos_theta < -0.999999f) return 1e30f; // straight on, only nominal speeds limit
+        float sin_half = sqrtf(0.5f * (1.0f - cos_theta));
+        return m_accel * m_deviation * sin_half / (1.0f - sin_half);
+    }
+
+    void recalculate() noexcept {
+        size_t last = m_blocks.size() - 1;
+        if (last == 0) return; // only the locked front block
+
+        // reverse: the newest block must be able to stop
+        block* next = &m_blocks[last];
+        next->entry_sq = min(next->max_entry_sq, 2 * m_accel * next->length);
+        for (size_t i = last - 1; i > m_planned; i--) {
+            block& cur = m_blocks[i];
+            if (cur.entry_sq == cur.max_entry_sq) break; // already as fast as it may be, nothing before it changes
+            cur.entry_sq = min(cur.max_entry_sq, next->entry_sq + 2 * m_accel * cur.length);
+            next         = &cur;
+        }
+
+        // forward: cap by acceleration from the optimal prefix, blocks limited that way are optimal too
+        for (size_t i = m_planned; i < last; i++) {
+            block& cur = m_blocks[i];
+            block& nxt = m_blocks[i + 1];
+            if (cur.entry_sq < nxt.entry_sq) {
+                float reach = cur.entry_sq + 2 * m_accel * cur.length;
+                if (reach < nxt.entry_sq) {
+                    nxt.entry_sq = reach;
+                    m_planned    = i + 1;
+                }
+            }
+            if (nxt.entry_sq == nxt.max_entry_sq) m_planned = i + 1;
+        }
+    }
+
+    public:
+    /// @param accel  acceleration along the path in steps/s^2
+    /// @param deviation  junction deviation in steps, larger corners faster
+    explicit Planner(uint16_t accel = 1000, float deviation = 1.0f) noexcept : m_planned(0), m_accel(accel), m_deviation(deviation) {
+        for (size_t i = 0; i < N; i++) m_prev_unit[i] = 0;
+    }
+
+    void configure(uint16_t accel, float deviation) noexcept {
+        m_accel     = accel;
+        m_deviation = deviation;
+    }
+
+    /// @brief append a segment and replan, false when the buffer is full or the segment is empty
+    /// @param speed  requested speed along the path in steps/s
+    bool push(const int32_t (&steps)[N], uint16_t speed) noexcept {
+        if (m_blocks.full() || speed == 0) return false;
+
+        block b;
+        float len_sq = 0;
+        b.major      = 0;
+        for (size_t i = 0; i < N; i++) {
+            b.steps[i] = steps[i];
+            uint32_t d = static_cast<uint32_t>(steps[i] < 0 ? -steps[i] : steps[i]);
+            if (d > b.major) b.major = d;
+            len_sq += static_cast<float>(steps[i]) * steps[i];
+        }
+        if (b.major == 0) return false;
+        b.length     = sqrtf(len_sq);
+        b.nominal_sq = static_cast<float>(speed) * speed;
+
+        float unit[N];
+        for (size_t i = 0; i < N; i++) unit[i] = steps[i] / b.length;
+
+        if (m_blocks.empty()) {
+            b.max_entry_sq = 0; // whatever ran before has been told to stop
+            m_planned      = 0;
+        } else {
+            b.max_entry_sq = min(junction_sq(unit), min(b.nominal_sq, m_blocks.back().nominal_sq));
+        }
+        b.entry_sq = b.max_entry_sq;
+        for (size_t i = 0; i < N; i++) m_prev_unit[i] = unit[i];
+
+        m_blocks.push_back(b);
+        recalculate();
+        return true;
+    }
+
+    /// @brief take the front segment for execution, its exit speed is now fixed
+    bool pop(Motion<N>& m) noexcept {
+        if (m_blocks.empty()) return false;
+        const block& b = m_blocks.front();
+        float exit_sq  = m_blocks.size() > 1 ? m_blocks[1].entry_sq : 0;
+
+        // the driver counts in steps of the major axis
+        float scale = b.major / b.length;
+        for (size_t i = 0; i < N; i++) m.steps[i] = b.steps[i];
+        m.entry = static_cast<uint16_t>(sqrtf(b.entry_sq) * scale + 0.5f);
+        m.speed = static_cast<uint16_t>(sqrtf(b.nominal_sq) * scale + 0.5f);
+        m.exit  = static_cast<uint16_t>(sqrtf(exit_sq) * scale + 0.5f);
+        m.accel = static_cast<uint16_t>(m_accel * scale + 0.5f);
+        if (m.speed == 0) m.speed = 1;
+
+        m_blocks.pop_front();
+        if (m_planned) m_planned--;
+        return true;
+    }
+
+    void clear() noexcept {
+        m_blocks.clear();
+        m_planned = 0;
+    }
+
+    /// i-th buffered block from the front
+    const block& operator[](size_t i) const noexcept { return m_blocks[i]; }
+
+    /// blocks whose entry speed is final
+    size_t planned() const noexcept { return m_planned; }
+
+    size_t size() const noexcept { return m_blocks.size(); }
+    bool empty() const noexcept { return m_blocks.empty(); }
+    bool full() const noexcept { return m_blocks.full(); }
+    static constexpr size_t capacity() noexcept { return Depth; }
+};
+
+} // namespace step_motor
+} // namespace firmware
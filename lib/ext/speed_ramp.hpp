@@ -0,0 +1,351 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace firmware {
+namespace step_motor {
+
+enum class RampState : uint8_t {
+    STOP,
+    ACCEL,
+    RUN,
+    DECEL,
+};
+
+namespace __details {
+/// floor(sqrt(v)), bit by bit; planning only, never in the ISR
+inline uint32_t isqrt(uint64_t v) noexcept {
+    uint64_t r   = 0;
+    uint64_t bit = uint64_t(1) << 62;
+    while (bit > v) bit >>= 2;
+    while (bit != 0) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return static_cast<uint32_t>(r);
+}
+} // namespace __details
+
+/*
+ * Trapezoidal speed profile after D. Austin, "Generate stepper-motor speed profiles in real time"
+ * (2005), in the form of Atmel AVR446.
+ *
+ * plan() does the divisions and the square root once per move. After that every step costs
+ * one integer recurrence, c_n = c_{n-1} - (2 c_{n-1} + rest) / (4 n + 1), with the remainder
+ * carried over so the rounding error does not accumulate. n runs up while accelerating and
+ * from -(steps to stop) back to 0 while decelerating, which mirrors the same curve.
+ */
+class SpeedRamp {
+    private:
+    RampState m_state;
+    uint32_t m_steps;            // length of the move
+    uint32_t m_step_count;       // steps emitted so far
+    uint32_t m_decel_start;      // step that begins deceleration
+    int32_t m_decel_val;         // -(steps needed to stop)
+    int32_t m_accel_count;       // n of the recurrence
+    int32_t m_rest;              // remainder carried between updates
+    uint32_t m_delay;            // ticks to the next step
+    uint32_t m_min_delay;        // ticks per step at cruise speed
+    uint32_t m_last_accel_delay; // where deceleration picks up after cruising
+
+    /// one step of the recurrence, n already advanced
+    uint32_t recurrence() noexcept {
+        int32_t den = 4 * m_accel_count + 1;
+        int32_t num = 2 * static_cast<int32_t>(m_delay) + m_rest;
+        m_rest      = num % den;
+        return static_cast<uint32_t>(static_cast<int32_t>(m_delay) - num / den);
+    }
+
+    uint32_t finish() noexcept {
+        m_state = RampState::STOP;
+        m_rest  = 0;
+        return 0;
+    }
+
+    public:
+    SpeedRamp() noexcept
+    : m_state(RampState::STOP), m_steps(0), m_step_count(0), m_decel_start(0), m_decel_val(0), m_accel_count(0), m_rest(0),
+      m_delay(0), m_min_delay(0), m_last_accel_delay(0) {}
+
+    /// @brief plan a move from standstill
+    /// @param steps  length of the move
+    /// @param speed  cruise speed in steps/s
+    /// @param accel  acceleration in steps/s^2, 0 starts at cruise speed
+    /// @param decel  deceleration in steps/s^2, 0 stops dead from cruise speed
+    /// @param timer_hz  tick rate the delays are counted in
+    /// @return ticks before the first step, 0 when there is nothing to do
+    uint32_t plan(uint32_t steps, uint16_t speed, uint16_t accel, uint16_t decel, uint32_t timer_hz) noexcept {
+        m_steps       = steps;
+        m_step_count  = 0;
+        m_accel_count = 0;
+        m_rest        = 0;
+        if (steps == 0 || speed == 0) return finish();
+
+        m_min_delay = timer_hz / speed;
+        if (m_min_delay == 0) m_min_delay = 1;
+
+        // first interval c0 = 0.676 * f * sqrt(2 / a), the 0.676 corrects the error of the recurrence at n = 1
+        uint64_t f = timer_hz;
+        m_delay    = accel ? static_cast<uint32_t>(uint64_t(__details::isqrt(2 * f * f / accel)) * 676 / 1000) : 0;
+
+        if (decel == 0) {
+            m_decel_val = 0;
+            m_decel_start = steps; // never reached, the last step ends the move
+        } else {
+            // steps to reach cruise speed, and where accel and decel would meet if it is never reached
+            uint32_t max_s_lim = accel ? static_cast<uint32_t>(uint32_t(speed) * speed / (2UL * accel)) : 0;
+            uint32_t accel_lim = accel ? static_cast<uint32_t>(uint64_t(steps) * decel / (uint32_t(accel) + decel)) : 0;
+            if (max_s_lim == 0) max_s_lim = 1;
+            if (accel_lim == 0) accel_lim = 1;
+
+            if (accel && accel_lim <= max_s_lim) {
+                m_decel_val = static_cast<int32_t>(accel_lim) - static_cast<int32_t>(steps);
+            } else {
+                // from cruise speed, v^2 / 2d steps
+                m_decel_val = -static_cast<int32_t>(uint32_t(speed) * speed / (2UL * decel));
+            }
+            if (m_decel_val == 0) m_decel_val = -1;
+            if (static_cast<uint32_t>(-m_decel_val) > steps) m_decel_val = -static_cast<int32_t>(steps);
+            m_decel_start = steps - static_cast<uint32_t>(-m_decel_val);
+        }
+
+        if (m_delay <= m_min_delay) {
+            m_delay            = m_min_delay;
+            m_last_accel_delay = m_min_delay;
+            m_state            = RampState::RUN;
+        } else {
+            m_state = RampState::ACCEL;
+        }
+        return m_delay;
+    }
+
+    /// @brief plan a move that starts and ends moving, for chaining segments of a path
+    /// @param entry  speed at the first step in steps/s
+    /// @param exit  speed at the last step in steps/s, a move too short to slow down to it ends faster
+    /// @param accel  acceleration and deceleration in steps/s^2, 0 runs the whole move at speed
+    /// @return ticks before the first step, 0 when there is nothing to do
+    uint32_t plan(uint32_t steps, uint16_t entry, uint16_t speed, uint16_t exit, uint16_t accel, uint32_t timer_hz) noexcept {
+        if (accel == 0 || speed == 0) return plan(steps, speed, 0, 0, timer_hz);
+        if (entry > speed) entry = speed;
+        if (exit > speed) exit = speed;
+
+        m_steps      = steps;
+        m_step_count = 0;
+        m_rest       = 0;
+        if (steps == 0) return finish();
+
+        m_min_delay = timer_hz / speed;
+        if (m_min_delay == 0) m_min_delay = 1;
+
+        // position of each speed on the curve from standstill, v^2 / 2a steps
+        uint32_t n_entry  = static_cast<uint32_t>(uint32_t(entry) * entry / (2UL * accel));
+        uint32_t n_exit   = static_cast<uint32_t>(uint32_t(exit) * exit / (2UL * accel));
+        uint32_t n_cruise = static_cast<uint32_t>(uint32_t(speed) * speed / (2UL * accel));
+        uint32_t accel_len = n_cruise - n_entry;
+        uint32_t decel_len = n_cruise - n_exit;
+        if (uint64_t(accel_len) + decel_len > steps) {
+            // cruise speed is never reached, the ramps meet at the peak
+            uint64_t peak = (uint64_t(steps) + n_entry + n_exit) / 2;
+            accel_len     = peak > n_entry ? static_cast<uint32_t>(peak - n_entry) : 0;
+            if (accel_len > steps) accel_len = steps;
+            decel_len = steps - accel_len;
+        }
+
+        // pick the recurrence up where the entry speed sits on it
+        uint64_t f    = timer_hz;
+        m_accel_count = static_cast<int32_t>(n_entry);
+        m_delay       = entry ? timer_hz / entry : static_cast<uint32_t>(uint64_t(__details::isqrt(2 * f * f / accel)) * 676 / 1000);
+        // deceleration runs down from the peak, which is above n_exit + decel_len when the move is too short to slow down fully
+        m_decel_val   = decel_len ? -static_cast<int32_t>(n_entry + accel_len) : 0;
+        m_decel_start = steps - decel_len;
+
+        if (m_delay <= m_min_delay) {
+            m_delay            = m_min_delay;
+            m_last_accel_delay = m_min_delay;
+            m_state            = decel_len == steps ? RampState::DECEL : RampState::RUN;
+        } else {
+            m_state = decel_len == steps ? RampState::DECEL : RampState::ACCEL;
+        }
+        if (m_state == RampState::DECEL) m_accel_count = m_decel_val;
+        return m_delay;
+    }
+
+    /// @brief account for the step just emitted
+    /// @return ticks until the next step, 0 once the move is complete
+    uint32_t next() noexcept {
+        if (m_state == RampState::STOP) return 0;
+        if (++m_step_count >= m_steps) return finish();
+
+        uint32_t delay = m_delay;
+        switch (m_state) {
+        case RampState::ACCEL:
+            m_accel_count++;
+            delay = recurrence();
+            if (m_step_count >= m_decel_start) {
+                m_accel_count = m_decel_val;
+                m_state       = RampState::DECEL;
+            } else if (delay <= m_min_delay) {
+                m_last_accel_delay = delay;
+                delay              = m_min_delay;
+                m_rest             = 0;
+                m_state            = RampState::RUN;
+            }
+            break;
+        case RampState::RUN:
+            if (m_step_count >= m_decel_start) {
+                m_accel_count = m_decel_val;
+                delay         = m_last_accel_delay;
+                m_state       = RampState::DECEL;
+            }
+            break;
+        case RampState::DECEL:
+            m_accel_count++;
+            if (m_accel_count < 0) delay = recurrence();
+            break;
+        default: break;
+        }
+        m_delay = delay;
+        return delay;
+    }
+
+    /// @brief abandon the move at once
+    void stop() noexcept { finish(); }
+
+    RampState state() const noexcept { return m_state; }
+    bool is_running() const noexcept { return m_state != RampState::STOP; }
+
+    uint32_t steps_done() const noexcept { return m_step_count; }
+    uint32_t steps_left() const noexcept { return m_steps - m_step_count; }
+    uint32_t min_delay() const noexcept { return m_min_delay; }
+};
+
+
+/// @brief a step delay as 16-bit timer periods. A delay past 0xFFFF ticks, a slow speed or the
+/// first step of a gentle ramp, is counted out over several compare interrupts that emit no
+/// step, so the timing holds at any speed instead of being clamped.
+class TimerDelay {
+    private:
+    uint32_t m_wait; // ticks left after the period running now
+
+    public:
+    TimerDelay() noexcept : m_wait(0) {}
+
+    /// @brief the period to run first for a delay of ticks; the rest is left over at least
+    /// 0x8000, so no period is too short for the ISR to keep up with
+    uint16_t start(uint32_t ticks) noexcept {
+        uint32_t now = ticks;
+        if (now > 0xFFFF) now = ticks - 0x8000 > 0xFFFF ? 0xFFFF : ticks - 0x8000;
+        m_wait = ticks - now;
+        return static_cast<uint16_t>(now);
+    }
+
+    /// @brief whether the compare interrupt now due only ends a part of the delay
+    bool waiting() const noexcept { return m_wait != 0; }
+    /// @brief the period to run next while waiting()
+    uint16_t rest() noexcept { return start(m_wait); }
+};
+
+/// @brief the one user of a Timer, whatever its type: every motor and group bound to the same
+/// timer shares its interrupt, so claim() stops the current user through the release hook it
+/// registered before attaching the new handler
+template <typename Timer>
+class TimerOwner {
+    private:
+    static inline void (*s_release)() = nullptr;
+
+    public:
+    static void claim(void (*release)(), void (*handler)()) noexcept {
+        if (s_release) s_release();
+        s_release = release;
+        Timer::attach(handler);
+    }
+};
+
+/// @brief runs a SpeedRamp from a timer compare interrupt
+/// @tparam Timer  `static constexpr uint32_t frequency`, and static start(uint16_t), set_period(uint16_t),
+///                stop(), bool mask(), unmask(bool); see firmware::timer1
+template <typename Timer>
+class RampDriver {
+    private:
+    SpeedRamp m_ramp;
+    int32_t m_position;
+    TimerDelay m_delay;
+    int8_t m_dir;
+
+    // the ISR writes the state behind the compiler's back
+    static void barrier() noexcept { __asm__ __volatile__("" ::: "memory"); }
+
+    public:
+    RampDriver() noexcept : m_position(0), m_dir(1) {}
+
+    /// @brief start a move and return, the ISR emits the steps; negative steps run backward
+    void move(int32_t steps, uint16_t speed, uint16_t accel, uint16_t decel) noexcept {
+        Timer::stop();
+        m_dir          = steps < 0 ? -1 : 1;
+        uint32_t first = m_ramp.plan(static_cast<uint32_t>(steps < 0 ? -steps : steps), speed, accel, decel, Timer::frequency);
+        barrier();
+        if (first) Timer::start(m_delay.start(first));
+    }
+
+    /// @brief timer compare ISR body, step(forward) drives the coils
+    template <typename StepFn>
+    void isr(StepFn&& step) {
+        if (!m_ramp.is_running()) {
+            Timer::stop();
+            return;
+        }
+        if (m_delay.waiting()) {
+            Timer::set_period(m_delay.rest());
+            return;
+        }
+        step(m_dir > 0);
+        m_position += m_dir;
+        uint32_t next = m_ramp.next();
+        if (next) Timer::set_period(m_delay.start(next));
+        else Timer::stop();
+    }
+
+    /// @brief halt at once, without deceleration
+    void stop() noexcept {
+        Timer::stop();
+        m_ramp.stop();
+        barrier();
+    }
+
+    RampState state() const noexcept {
+        barrier();
+        return m_ramp.state(); // one byte, no need to mask
+    }
+    bool is_running() const noexcept { return state() != RampState::STOP; }
+
+    int32_t position() const noexcept {
+        bool enabled = Timer::mask();
+        barrier();
+        int32_t p = m_position;
+        Timer::unmask(enabled);
+        return p;
+    }
+
+    uint32_t steps_left() const noexcept {
+        bool enabled = Timer::mask();
+        barrier();
+        uint32_t n = m_ramp.steps_left();
+        Timer::unmask(enabled);
+        return n;
+    }
+
+    void set_position(int32_t p) noexcept {
+        bool enabled = Timer::mask();
+        m_position   = p;
+        Timer::unmask(enabled);
+    }
+};
+
+} // namespace step_motor
+} // namespace firmware
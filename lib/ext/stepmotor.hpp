@@ -1,55 +1,25 @@
 #pragma once
 
 #ifdef __AVR__
+#include <arduino/timer/timer.hpp>
 #include <avr-log.hpp>
 #include <avr-pins.hpp>
 #endif
 
-namespace firmware {
-namespace step_motor {
-
-enum class State {
-    AP = 1,
-    AN = 3,
-    BP = 2,
-    BN = 4,
-};
+#include <scheduler>
 
-class StepMotorStateController {
-    private:
-    step_motor::State m_state;
-
-    public:
-    StepMotorStateController() noexcept : m_state(State::AP) {}
-    virtual ~StepMotorStateController() noexcept = default;
-
-    step_motor::State get_state() const { return m_state; }
-    void set_state(step_motor::State state) { m_state = state; }
-
-    void forward() {
-        switch (m_state) {
-        case State::AP: m_state = State::BP; break;
-        case State::BP: m_state = State::AN; break;
-        case State::AN: m_state = State::BN; break;
-        case State::BN: m_state = State::AP; break;
-        default: break;
-        }
-    }
+#include "microstep.hpp"
+#include "multi_axis.hpp"
+#include "pin_stepmotor.hpp"
+#include "planner.hpp"
+#include "speed_ramp.hpp"
 
-    void backward() {
-        switch (m_state) {
-        case State::BN: m_state = State::AN; break;
-        case State::AN: m_state = State::BP; break;
-        case State::BP: m_state = State::AP; break;
-        case State::AP: m_state = State::BN; break;
-        default: break;
-        }
-    }
-};
+namespace firmware {
+namespace step_motor {
 
 class StepMotor {
     private:
-    StepMotorStateController m_smsc;
+    PhaseSequencer m_phase;
 
     avr::pins m_ap;
     avr::pins m_an;
@@ -60,14 +30,33 @@ class StepMotor {
     bool m_is_enable_power;
 
     uint16_t m_delay;
+    uint16_t m_speed; // steps/s
+    uint16_t m_accel; // steps/s^2, 0 for none
+
+    // Timer1 drives one motor or group at a time, see TimerOwner. Its CTC step timing takes
+    // the timer from analogWrite(): D9 and D10 give no PWM while a move runs, so the coils'
+    // enable_power() duty needs pins on Timer0 or Timer2 (D3, D5, D6, D11)
+    RampDriver<firmware::timer1> m_driver;
+    static inline StepMotor* s_active = nullptr;
+
+    static void on_timer() {
+        s_active->m_driver.isr([](bool forward) { s_active->step_once(forward); });
+    }
+
+    static void release() noexcept {
+        if (s_active) s_active->stop();
+    }
 
     public:
     StepMotor(const avr::pins& ap, const avr::pins& an, const avr::pins& bp, const avr::pins& bn) noexcept
-    : m_ap(ap), m_an(an), m_bp(bp), m_bn(bn), m_is_enable_power(false) {}
-    virtual ~StepMotor() noexcept = default;
+    : m_ap(ap), m_an(an), m_bp(bp), m_bn(bn), m_is_enable_power(false), m_delay(0), m_speed(1), m_accel(0) {}
+    virtual ~StepMotor() noexcept {
+        if (s_active == this) stop(), s_active = nullptr;
+    }
 
     StepMotor(const StepMotor& other)
-    : m_ap(other.m_ap), m_an(other.m_an), m_bp(other.m_bp), m_bn(other.m_bn), m_is_enable_power(other.m_is_enable_power) {}
+    : m_ap(other.m_ap), m_an(other.m_an), m_bp(other.m_bp), m_bn(other.m_bn), m_is_enable_power(other.m_is_enable_power),
+      m_delay(other.m_delay), m_speed(other.m_speed), m_accel(other.m_accel) {}
 
     void enable_power() { m_is_enable_power = true; }
     void disable_power() { m_is_enable_power = false; }
@@ -75,44 +64,185 @@ class StepMotor {
     void set_power(uint8_t power) { m_power = power; }
     uint8_t get_power() { return m_power; }
 
-    void set_speed(uint32_t spm) { m_delay = 60000 / spm; }
+    void set_speed(uint32_t spm) {
+        m_delay = 60000 / spm;
+        m_speed = spm < 60 ? 1 : static_cast<uint16_t>(spm / 60);
+    }
+
+    /// acceleration and deceleration of step() in steps/s^2, 0 starts and stops at full speed
+    void set_acceleration(uint16_t accel) { m_accel = accel; }
 
+    uint16_t get_delay() const noexcept { return m_delay; }
+
+    /// @brief start a trapezoidal move and return at once, the Timer1 ISR emits the steps
     void step(int16_t s) {
         auto& log = avr::logger::instance();
         log.debug("step motor rotating %d steps begin", s);
         if (s == 0) return;
-        for (uint16_t i = 0; i < static_cast<uint16_t>(abs(s)); i++) {
-            state_close();
+        TimerOwner<firmware::timer1>::claim(&release, &on_timer);
+        s_active = this;
+        m_driver.move(s, m_speed, m_accel, m_accel);
+    }
 
-            if (s > 0) {
-                m_smsc.forward();
-            } else {
-                m_smsc.backward();
-            }
+    /// halt at once, without deceleration
+    void stop() noexcept { m_driver.stop(); }
 
-            state_open();
+    // status, safe to poll while the ISR runs
+    bool is_moving() const noexcept { return m_driver.is_running(); }
+    RampState get_motion_state() const noexcept { return m_driver.state(); }
+    int32_t get_position() const noexcept { return m_driver.position(); }
+    uint32_t get_steps_left() const noexcept { return m_driver.steps_left(); }
 
-            delay(m_delay);
+    /// @brief drive mode of every following step; the MICRO modes need enable_power() for PWM
+    void set_mode(DriveMode mode) noexcept {
+        m_phase.set_mode(mode);
+        state_open();
+    }
+    DriveMode get_mode() const noexcept { return m_phase.mode(); }
+
+    /// advance one step without waiting
+    void step_once(bool forward) noexcept {
+        if (forward) {
+            m_phase.forward();
+        } else {
+            m_phase.backward();
         }
-        log.debug("step motor rotating %d steps eng", s);
+        state_open();
     }
 
+    /// release every coil
     void state_close() noexcept {
-        switch (m_smsc.get_state()) {
-        case State::AP: m_is_enable_power ? m_ap.writea(0) : m_ap.writed(false); break;
-        case State::AN: m_is_enable_power ? m_an.writea(0) : m_an.writed(false); break;
-        case State::BP: m_is_enable_power ? m_bp.writea(0) : m_bp.writed(false); break;
-        case State::BN: m_is_enable_power ? m_bn.writea(0) : m_bn.writed(false); break;
+        if (m_is_enable_power) {
+            m_ap.writea(0), m_an.writea(0), m_bp.writea(0), m_bn.writea(0);
+        } else {
+            m_ap.writed(false), m_an.writed(false), m_bp.writed(false), m_bn.writed(false);
         }
     }
 
+    /// energise the coils for the current position, duties scaled by the power setting
     void state_open() noexcept {
-        switch (m_smsc.get_state()) {
-        case State::AP: m_is_enable_power ? m_ap.writea(m_power) : m_ap.writed(true); break;
-        case State::AN: m_is_enable_power ? m_an.writea(m_power) : m_an.writed(true); break;
-        case State::BP: m_is_enable_power ? m_bp.writea(m_power) : m_bp.writed(true); break;
-        case State::BN: m_is_enable_power ? m_bn.writea(m_power) : m_bn.writed(true); break;
+        CoilDuty d = m_phase.current();
+        if (m_is_enable_power) {
+            m_ap.writea(scale(d.ap)), m_an.writea(scale(d.an)), m_bp.writea(scale(d.bp)), m_bn.writea(scale(d.bn));
+        } else {
+            m_ap.writed(d.ap >= 128), m_an.writed(d.an >= 128), m_bp.writed(d.bp >= 128), m_bn.writed(d.bn >= 128);
+        }
+    }
+
+    private:
+    uint8_t scale(uint8_t duty) const noexcept { return static_cast<uint8_t>((uint16_t(duty) * m_power + 255) >> 8); }
+};
+
+/// @brief StepMotor on four firmware::pins types, no pin state and direct port writes, moves on Timer1.
+/// Timer1 in CTC mode for the steps means no analogWrite() on D9/D10: keep the PWM coil pins off them.
+template <typename AP, typename AN, typename BP, typename BN>
+using PinStepMotor = BasicPinStepMotor<AP, AN, BP, BN, firmware::timer1>;
+
+/// @brief N motors moving together on straight lines, all stepped from the Timer1 ISR
+/// Timer1 serves one StepMotor, PinStepMotor or group at a time: a move stops whichever held it.
+/// Segments queued with queue_move() run back to back at the planner's junction speeds.
+template <size_t N, size_t Depth = 16>
+class StepMotorGroup {
+    private:
+    StepMotor* m_motors[N];
+    uint16_t m_speed; // steps/s of the longest axis
+    uint16_t m_accel;
+    MultiAxisDriver<N, firmware::timer1> m_driver;
+    Planner<N, Depth> m_planner;
+    static inline StepMotorGroup* s_active = nullptr;
+
+    static void on_timer() {
+        s_active->m_driver.isr([](uint8_t axis, bool forward) { s_active->m_motors[axis]->step_once(forward); });
+        if (!s_active->m_driver.is_running()) s_active->start_next();
+    }
+
+    void start_next() noexcept {
+        Motion<N> m;
+        if (m_planner.pop(m)) m_driver.move(m.steps, m.entry, m.speed, m.exit, m.accel);
+    }
+
+    static void release() noexcept {
+        if (s_active) s_active->stop();
+    }
+
+    void activate() {
+        for (auto* m : m_motors) m->stop();
+        TimerOwner<firmware::timer1>::claim(&release, &on_timer);
+        s_active = this;
+    }
+
+    public:
+    explicit StepMotorGroup(StepMotor* const (&motors)[N]) noexcept : m_speed(1), m_accel(0) {
+        for (size_t i = 0; i < N; i++) m_motors[i] = motors[i];
+    }
+    ~StepMotorGroup() noexcept {
+        if (s_active == this) stop(), s_active = nullptr;
+    }
+
+    void set_speed(uint16_t steps_per_s) { m_speed = steps_per_s ? steps_per_s : 1; }
+
+    /// acceleration of move() along the major axis, and of queued paths along the path
+    void set_acceleration(uint16_t accel) {
+        m_accel = accel;
+        m_planner.configure(accel ? accel : 1, 1.0f);
+    }
+
+    /// @brief start a coordinated move and return at once, every axis arrives together; drops queued segments
+    void move(const int32_t (&steps)[N]) {
+        activate();
+        m_planner.clear();
+        m_driver.move(steps, m_speed, m_accel, m_accel);
+    }
+
+    /// @brief buffer a path segment at speed steps/s along the path, false while the lookahead is full
+    bool queue_move(const int32_t (&steps)[N], uint16_t speed) {
+        bool enabled = firmware::timer1::mask();
+        bool ok      = m_planner.push(steps, speed);
+        firmware::timer1::unmask(enabled);
+        return ok;
+    }
+
+    /// @brief run the queued segments, the ISR chains them until the buffer is empty
+    void start() {
+        if (is_moving()) return;
+        activate();
+        start_next();
+    }
+
+    /// halt at once and drop queued segments
+    void stop() noexcept {
+        m_driver.stop();
+        m_planner.clear();
+    }
+
+    bool is_moving() const noexcept { return m_driver.is_running(); }
+    RampState get_motion_state() const noexcept { return m_driver.state(); }
+    int32_t get_position(size_t axis) const noexcept { return m_driver.position(axis); }
+    uint32_t get_steps_left() const noexcept { return m_driver.steps_left(); }
+};
+
+/// @brief constant speed move through a scheduler, for when Timer1 is busy elsewhere
+class StepTask : public msd::task {
+    private:
+    StepMotor& m_motor;
+    int16_t m_steps;
+    uint16_t m_done;
+
+    public:
+    explicit StepTask(StepMotor& motor) noexcept : m_motor(motor), m_steps(0), m_done(0) {}
+
+    /// steps for the next spawn, negative runs backward
+    void set_steps(int16_t s) noexcept { m_steps = s; }
+    /// steps taken so far in the current move
+    uint16_t done() const noexcept { return m_done; }
+
+    msd::task_status run() override {
+        MSD_TASK_BEGIN();
+        for (m_done = 0; m_done < static_cast<uint16_t>(abs(m_steps)); m_done++) {
+            m_motor.step_once(m_steps > 0);
+            MSD_TASK_AWAIT_TICKS(m_motor.get_delay() * 1000UL);
         }
+        MSD_TASK_END();
     }
 };
 } // namespace step_motor
@@ -0,0 +1,17 @@
+#ifdef ARDUINO
+
+#include "adc.hpp"
+
+#include <Arduino.h>
+
+namespace firmware {
+
+namespace __details {
+void __adc_started() noexcept {}
+} // namespace __details
+
+} // namespace firmware
+
+ISR(ADC_vect) { firmware::adc::on_conversion(); }
+
+#endif // ARDUINO
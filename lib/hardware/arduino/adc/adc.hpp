@@ -0,0 +1,222 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ring_buffer>
+
+#include "../pins/pins.hpp"
+
+#ifndef FIRMWARE_ADC_BUFFER
+#define FIRMWARE_ADC_BUFFER 64
+#endif
+
+namespace firmware {
+
+/// ADC clock is F_CPU / div, a conversion takes 13 of them; it is specified up to 200 kHz for 10 bits
+enum class AdcPrescaler : uint8_t {
+    DIV_2   = 1,
+    DIV_4   = 2,
+    DIV_8   = 3,
+    DIV_16  = 4,
+    DIV_32  = 5,
+    DIV_64  = 6,
+    DIV_128 = 7,
+};
+
+/// what starts a conversion, the ADTS bits of ADCSRB
+enum class AdcTrigger : uint8_t {
+    FREE_RUNNING = 0, // the next one starts as soon as one ends
+    TIMER0_COMPA = 3,
+    TIMER0_OVF   = 4,
+    TIMER1_COMPB = 5,
+    TIMER1_OVF   = 6,
+    TIMER1_CAPT  = 7,
+};
+
+enum class AdcReference : uint8_t {
+    AREF         = 0,
+    AVCC         = 1,
+    INTERNAL_1V1 = 3,
+};
+
+namespace __details {
+constexpr uint8_t ADCL_ADDR   = 0x78;
+constexpr uint8_t ADCH_ADDR   = 0x79;
+constexpr uint8_t ADCSRA_ADDR = 0x7A;
+constexpr uint8_t ADCSRB_ADDR = 0x7B;
+constexpr uint8_t ADMUX_ADDR  = 0x7C;
+constexpr uint8_t DIDR0_ADDR  = 0x7E;
+constexpr uint8_t TIFR0_ADDR  = 0x35;
+constexpr uint8_t TIFR1_ADDR  = 0x36;
+
+// ADCSRA bits
+constexpr uint8_t ADEN  = 0x80;
+constexpr uint8_t ADSC  = 0x40;
+constexpr uint8_t ADATE = 0x20;
+constexpr uint8_t ADIF  = 0x10;
+constexpr uint8_t ADIE  = 0x08;
+
+#ifdef __AVR__
+/// defined next to ISR(ADC_vect), calling it pulls the vector into the link
+void __adc_started() noexcept;
+#else
+/// the channel the simulated converter is sampling
+inline uint8_t __adc_latched = 0;
+/// writing ADSC latches ADMUX for the first conversion
+inline void __adc_started() noexcept { __adc_latched = io_registers[ADMUX_ADDR] & 0x0F; }
+#endif
+} // namespace __details
+
+/*
+ * Interrupt-driven ADC: the converter walks a list of channels on its own, either free running
+ * or started by a timer event, and the conversion-complete ISR pushes each result into a
+ * lock-free ring buffer. The main loop drains whole batches with read(), so sampling never
+ * waits on it and it never busy-waits on a conversion the way analogRead() does.
+ *
+ * Each sample is a uint16_t holding the channel in the top 4 bits and the 10-bit result below,
+ * see channel() and value(). When the buffer is full the new sample is dropped and counted in
+ * overruns().
+ *
+ * ADMUX is latched when a conversion starts. In free-running mode the next conversion has
+ * already started on the old ADMUX when the ISR runs, so a channel written there applies one
+ * conversion later; the ISR keeps that one-deep pipeline and tags every sample with the channel
+ * it was really taken on. The very first channel is sampled twice while the pipeline fills.
+ * Triggered conversions start after the ISR, so ADMUX applies to the next one directly.
+ */
+struct adc {
+    static constexpr size_t capacity      = FIRMWARE_ADC_BUFFER;
+    static constexpr uint8_t max_channels = 8;
+
+    /// @brief start sampling channels[0..count) round robin, at most max_channels
+    /// with a timer trigger the timer itself is set up by the caller
+    static void start(const uint8_t* channels, uint8_t count, AdcPrescaler prescaler = AdcPrescaler::DIV_128,
+                      AdcTrigger trigger = AdcTrigger::FREE_RUNNING, AdcReference ref = AdcReference::AVCC) noexcept {
+        using namespace __details;
+        stop();
+        if (count == 0) return;
+        if (count > max_channels) count = max_channels;
+
+        uint8_t didr = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            s_channels[i] = static_cast<uint8_t>(channels[i] & 0x0F);
+            if (s_channels[i] < 6) didr = static_cast<uint8_t>(didr | (1 << s_channels[i]));
+        }
+        s_count      = count;
+        s_ref        = static_cast<uint8_t>(static_cast<uint8_t>(ref) << 6);
+        s_free       = trigger == AdcTrigger::FREE_RUNNING;
+        s_converting = 0;
+        s_pending    = 0;
+        s_overruns   = 0;
+        s_samples.clear();
+
+        switch (trigger) {
+        case AdcTrigger::TIMER0_COMPA: s_flag_reg = TIFR0_ADDR, s_flag = 0x02; break;
+        case AdcTrigger::TIMER0_OVF: s_flag_reg = TIFR0_ADDR, s_flag = 0x01; break;
+        case AdcTrigger::TIMER1_COMPB: s_flag_reg = TIFR1_ADDR, s_flag = 0x04; break;
+        case AdcTrigger::TIMER1_OVF: s_flag_reg = TIFR1_ADDR, s_flag = 0x01; break;
+        case AdcTrigger::TIMER1_CAPT: s_flag_reg = TIFR1_ADDR, s_flag = 0x20; break;
+        default: s_flag_reg = 0, s_flag = 0; break;
+        }
+
+        // digital input buffers off on the analog pins, they only waste current there
+        __reg_write<DIDR0_ADDR>(didr);
+        __reg_write<ADMUX_ADDR>(static_cast<uint8_t>(s_ref | s_channels[0]));
+        __reg_write<ADCSRB_ADDR>(static_cast<uint8_t>(trigger));
+        uint8_t sra = static_cast<uint8_t>(ADEN | ADATE | ADIF | ADIE | static_cast<uint8_t>(prescaler));
+        if (s_free) sra |= ADSC;
+        __reg_write<ADCSRA_ADDR>(sra);
+        __adc_started();
+    }
+
+    /// @brief stop converting, buffered samples stay readable
+    static void stop() noexcept {
+        __details::__reg_write<__details::ADCSRA_ADDR>(__details::ADIF);
+    }
+
+    /// @brief copy up to max of the oldest samples to out
+    /// @return how many were copied
+    static size_t read(uint16_t* out, size_t max) noexcept { return s_samples.pop(out, max); }
+    /// @brief take one sample, false when none is waiting
+    static bool read(uint16_t& out) noexcept { return s_samples.pop(out); }
+
+    static size_t available() noexcept { return s_samples.size(); }
+
+    /// @brief samples dropped on a full buffer since start()
+    static uint16_t overruns() noexcept {
+        uint8_t sreg = __details::__irq_save();
+        uint16_t n   = s_overruns;
+        __details::__irq_restore(sreg);
+        return n;
+    }
+
+    static constexpr uint8_t channel(uint16_t sample) noexcept { return static_cast<uint8_t>(sample >> 12); }
+    static constexpr uint16_t value(uint16_t sample) noexcept { return sample & 0x03FF; }
+
+    /// @brief the conversion-complete ISR body
+    static void on_conversion() noexcept {
+        using namespace __details;
+        uint8_t lo      = __reg_read<ADCL_ADDR>(); // ADCL first, it locks ADCH until read
+        uint8_t hi      = __reg_read<ADCH_ADDR>();
+        uint16_t sample = static_cast<uint16_t>((s_channels[s_converting] << 12) | (hi & 0x03) << 8 | lo);
+        if (!s_samples.push(sample)) s_overruns++;
+
+        uint8_t next = static_cast<uint8_t>(s_pending + 1 == s_count ? 0 : s_pending + 1);
+        if (s_free) {
+            // the conversion running now started on s_pending, ADMUX set here applies after it
+            s_converting = s_pending;
+            s_pending    = next;
+        } else {
+            s_converting = next;
+            s_pending    = next;
+            // the trigger starts a conversion on a rising flag, clear it for the next event
+            if (s_flag_reg == TIFR0_ADDR) __reg_write<TIFR0_ADDR>(s_flag);
+            else if (s_flag_reg == TIFR1_ADDR) __reg_write<TIFR1_ADDR>(s_flag);
+        }
+        if (s_count > 1) __reg_write<ADMUX_ADDR>(static_cast<uint8_t>(s_ref | s_channels[next]));
+    }
+
+    private:
+    static inline msd::ring_buffer<uint16_t, capacity> s_samples;
+    static inline uint8_t s_channels[max_channels] = {};
+    static inline uint8_t s_count              = 0;
+    static inline uint8_t s_ref                = 0;
+    static inline bool s_free                  = true;
+    static inline uint8_t s_converting         = 0; // list index of the result the next ISR reads
+    static inline uint8_t s_pending            = 0; // list index ADMUX holds
+    static inline uint8_t s_flag_reg           = 0;
+    static inline uint8_t s_flag               = 0;
+    static inline volatile uint16_t s_overruns = 0;
+};
+
+#ifndef __AVR__
+/*
+ * Native stand-in for the converter, driven by the tests: convert() runs one conversion of
+ * signal(channel) with the latching of the real hardware, fills ADCL / ADCH and calls the ISR
+ * body when ADIE is set.
+ */
+struct adc_sim {
+    static void convert(uint16_t (*signal)(uint8_t channel)) noexcept {
+        using namespace __details;
+        uint8_t sra = io_registers[ADCSRA_ADDR];
+        if (!(sra & ADEN)) return;
+        bool free_running = (sra & ADATE) && (io_registers[ADCSRB_ADDR] & 0x07) == 0;
+        // a triggered conversion starts now, on whatever ADMUX holds
+        if (!free_running) __adc_latched = io_registers[ADMUX_ADDR] & 0x0F;
+
+        uint16_t v                = static_cast<uint16_t>(signal(__adc_latched) & 0x03FF);
+        io_registers[ADCL_ADDR]   = static_cast<uint8_t>(v);
+        io_registers[ADCH_ADDR]   = static_cast<uint8_t>(v >> 8);
+        io_registers[ADCSRA_ADDR] = static_cast<uint8_t>(sra | ADIF);
+        // a free-running converter starts the next one before the ISR can touch ADMUX
+        if (free_running) __adc_latched = io_registers[ADMUX_ADDR] & 0x0F;
+
+        if (sra & ADIE) {
+            io_registers[ADCSRA_ADDR] &= static_cast<uint8_t>(~ADIF);
+            adc::on_conversion();
+        }
+    }
+};
+#endif
+
+} // namespace firmware
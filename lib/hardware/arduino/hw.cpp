@@ -1,3 +1,5 @@
+#ifdef ARDUINO
+
 #include "hw.hpp"
 
 #include <Arduino.h>
@@ -10,4 +12,6 @@ void setup() {}
 void loop() {
     entry();
     while (1);
-}
\ No newline at end of file
+}
+
+#endif // ARDUINO
@@ -1,5 +1,11 @@
 #pragma once
 
+#include "adc/adc.hpp"
+#include "interrupts/interrupts.hpp"
 #include "logger/logger.hpp"
+#include "pins/debouncer.hpp"
+#include "pins/pin_group.hpp"
 #include "pins/pins.hpp"
+#include "pwm/pwm.hpp"
+#include "timer/timer.hpp"
 #include "wiring/wiring.hpp"
\ No newline at end of file
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <flash>
+#include <type_traits>
+
+#include "../pins/pins.hpp"
+
+namespace firmware {
+
+/// when INT0 / INT1 fire, the ISCn bits of EICRA
+enum class InterruptSense : uint8_t {
+    LOW     = 0,
+    CHANGE  = 1,
+    FALLING = 2,
+    RISING  = 3,
+};
+
+namespace __details {
+constexpr uint8_t PCIFR_ADDR = 0x3B;
+constexpr uint8_t EIFR_ADDR  = 0x3C;
+constexpr uint8_t EIMSK_ADDR = 0x3D;
+constexpr uint8_t PCICR_ADDR = 0x68;
+constexpr uint8_t EICRA_ADDR = 0x69;
+
+/// PCMSKn of the port whose PINx is at pinr, and its enable bit in PCICR / PCIFR
+constexpr uint8_t __pcmsk_register(uint8_t pinr) noexcept { return pinr == PINB_ADDR ? 0x6B : pinr == PINC_ADDR ? 0x6C : 0x6D; }
+constexpr uint8_t __pcie_bit(uint8_t pinr) noexcept { return pinr == PINB_ADDR ? 0x01 : pinr == PINC_ADDR ? 0x02 : 0x04; }
+
+/// what a binding listens to
+enum class __irq_source : uint8_t { PIN_CHANGE, INT0, INT1 };
+
+/// position change for (previous AB << 2 | current AB), A leading B is forward; 0 for no move and for a lost step
+inline constexpr int8_t __quadrature_step[16] MSD_FLASH = { 0, -1, 1, 0, 1, 0, 0, -1, -1, 0, 0, 1, 0, 1, -1, 0 };
+/// the four transitions where both channels changed at once, the ones that lose a step
+constexpr uint16_t __quadrature_lost = 0x1248;
+} // namespace __details
+
+/*
+ * Interrupt bindings, each one a type naming its pins and handler at compile time. They are
+ * collected by firmware::interrupts<...>, which generates the dispatch code of every vector.
+ */
+
+/// @brief Handler(level) on every change of Pin, through its port's pin-change interrupt
+template <typename Pin, void (*Handler)(bool)>
+struct on_change {
+    static_assert(__details::__has_port(Pin::number), "pin change interrupts exist on D0-D13 and A0-A5");
+    static constexpr __details::__irq_source source = __details::__irq_source::PIN_CHANGE;
+    static constexpr uint8_t pinr                   = __details::__pin_register(Pin::number);
+    static constexpr uint8_t mask                   = __details::__pin_mask(Pin::number);
+
+    static void init() noexcept { Pin::init(); }
+    __attribute__((always_inline)) static void fire(uint8_t now) noexcept { Handler(now & mask); }
+};
+
+/// @brief Handler() when Pin goes high
+template <typename Pin, void (*Handler)()>
+struct on_rise : on_change<Pin, nullptr> {
+    __attribute__((always_inline)) static void fire(uint8_t now) noexcept {
+        if (now & on_change<Pin, nullptr>::mask) Handler();
+    }
+};
+
+/// @brief Handler() when Pin goes low
+template <typename Pin, void (*Handler)()>
+struct on_fall : on_change<Pin, nullptr> {
+    __attribute__((always_inline)) static void fire(uint8_t now) noexcept {
+        if (!(now & on_change<Pin, nullptr>::mask)) Handler();
+    }
+};
+
+/// @brief Handler() from INT0 (D2) or INT1 (D3), the edge chosen in hardware
+template <typename Pin, InterruptSense Sense, void (*Handler)()>
+struct on_external {
+    static_assert(Pin::number == 2 || Pin::number == 3, "external interrupts are on D2 (INT0) and D3 (INT1)");
+    static constexpr __details::__irq_source source = Pin::number == 2 ? __details::__irq_source::INT0 : __details::__irq_source::INT1;
+    static constexpr uint8_t pinr                   = __details::PIND_ADDR;
+    static constexpr uint8_t mask                   = __details::__pin_mask(Pin::number);
+    static constexpr uint8_t eimsk                  = Pin::number == 2 ? 0x01 : 0x02;
+    static constexpr uint8_t eicra                  = static_cast<uint8_t>(static_cast<uint8_t>(Sense) << (Pin::number == 2 ? 0 : 2));
+
+    static void init() noexcept { Pin::init(); }
+    __attribute__((always_inline)) static void fire(uint8_t) noexcept { Handler(); }
+};
+
+/*
+ * Quadrature encoder on two pins of one port, counted on every edge of both channels (4 counts
+ * a line). The previous and current levels index a 16-entry table of -1 / 0 / +1, so an edge is
+ * a shift, a mask, a table load and an add, with no branch. A transition where both channels
+ * changed between two interrupts is a lost step; it counts 0 and is tallied in errors().
+ */
+template <typename PinA, typename PinB>
+struct quadrature {
+    static_assert(__details::__pin_register(PinA::number) == __details::__pin_register(PinB::number),
+                  "both channels on one port, read together");
+
+    static constexpr __details::__irq_source source = __details::__irq_source::PIN_CHANGE;
+    static constexpr uint8_t pinr                   = __details::__pin_register(PinA::number);
+    static constexpr uint8_t mask                   = __details::__pin_mask(PinA::number) | __details::__pin_mask(PinB::number);
+
+    private:
+    static constexpr uint8_t bit_of(uint8_t m) noexcept {
+        uint8_t b = 0;
+        while ((1 << b) != m) b++;
+        return b;
+    }
+    static constexpr uint8_t m_bit_a = bit_of(__details::__pin_mask(PinA::number));
+    static constexpr uint8_t m_bit_b = bit_of(__details::__pin_mask(PinB::number));
+
+    static inline uint8_t s_state          = 0; // previous AB << 2 | current AB
+    static inline volatile int32_t s_count = 0;
+    static inline volatile uint16_t s_lost = 0;
+
+    __attribute__((always_inline)) static uint8_t levels(uint8_t port) noexcept {
+        return static_cast<uint8_t>(((port >> m_bit_a) & 1) << 1 | ((port >> m_bit_b) & 1));
+    }
+
+    public:
+    static void init() noexcept {
+        PinA::init();
+        PinB::init();
+        s_state = levels(__details::__reg_read<pinr>());
+    }
+
+    __attribute__((always_inline)) static void fire(uint8_t now) noexcept {
+        uint8_t state = static_cast<uint8_t>((s_state << 2 | levels(now)) & 0x0F);
+        s_state       = state;
+        s_count       = s_count + msd::flash_load(__details::__quadrature_step + state);
+        s_lost        = static_cast<uint16_t>(s_lost + ((__details::__quadrature_lost >> state) & 1));
+    }
+
+    /// @brief counts since start, 4 a line
+    static int32_t position() noexcept {
+        uint8_t sreg = __details::__irq_save();
+        int32_t p    = s_count;
+        __details::__irq_restore(sreg);
+        return p;
+    }
+    static void set_position(int32_t p) noexcept {
+        uint8_t sreg = __details::__irq_save();
+        s_count      = p;
+        __details::__irq_restore(sreg);
+    }
+
+    /// @brief transitions too fast to tell the direction of
+    static uint16_t errors() noexcept {
+        uint8_t sreg = __details::__irq_save();
+        uint16_t e   = s_lost;
+        __details::__irq_restore(sreg);
+        return e;
+    }
+};
+
+/*
+ * A table of interrupt bindings, with no handler array in RAM: every binding is a type, so the
+ * vector bodies are generated per port at compile time and call the handlers directly.
+ *
+ * A pin-change vector reads its port once, XORs it with the last reading, and calls each binding
+ * of that port whose pins are among the changed bits. Pulses shorter than the ISR latency can be
+ * missed, as with any pin-change interrupt; use on_external for those.
+ *
+ *     using irq = firmware::interrupts<firmware::on_fall<limit, &stop_axis>, firmware::quadrature<enc_a, enc_b>>;
+ *     FIRMWARE_PIN_CHANGE_ISR(irq)   // in one .cpp
+ *     irq::init();
+ */
+template <typename... Bindings>
+class interrupts {
+    template <uint8_t PINR>
+    static constexpr uint8_t m_port_mask =
+        static_cast<uint8_t>((0 | ... | (Bindings::source == __details::__irq_source::PIN_CHANGE && Bindings::pinr == PINR ? Bindings::mask : 0)));
+
+    template <uint8_t PINR>
+    static inline uint8_t s_last = 0;
+
+    template <typename B, uint8_t PINR>
+    __attribute__((always_inline)) static void dispatch(uint8_t now, uint8_t changed) noexcept {
+        if constexpr (B::source == __details::__irq_source::PIN_CHANGE && B::pinr == PINR) {
+            if (changed & B::mask) B::fire(now);
+        }
+    }
+
+    template <typename B, __details::__irq_source S>
+    __attribute__((always_inline)) static void dispatch_external() noexcept {
+        if constexpr (B::source == S) B::fire(0);
+    }
+
+    template <uint8_t PINR>
+    static void enable_port() noexcept {
+        constexpr uint8_t mask = m_port_mask<PINR>;
+        if constexpr (mask != 0) {
+            s_last<PINR> = __details::__reg_read<PINR>();
+            __details::__reg_set<__details::__pcmsk_register(PINR)>(mask);
+            __details::__reg_write<__details::PCIFR_ADDR>(__details::__pcie_bit(PINR)); // drop a stale flag
+            __details::__reg_set<__details::PCICR_ADDR>(__details::__pcie_bit(PINR));
+        }
+    }
+
+    template <typename B>
+    static void enable_external() noexcept {
+        if constexpr (B::source != __details::__irq_source::PIN_CHANGE) {
+            __details::__reg_clear<__details::EIMSK_ADDR>(B::eimsk);
+            uint8_t shift = B::eimsk == 0x01 ? 0 : 2;
+            uint8_t eicra = __details::__reg_read<__details::EICRA_ADDR>();
+            __details::__reg_write<__details::EICRA_ADDR>(static_cast<uint8_t>((eicra & ~(0x03 << shift)) | B::eicra));
+            __details::__reg_write<__details::EIFR_ADDR>(B::eimsk);
+            __details::__reg_set<__details::EIMSK_ADDR>(B::eimsk);
+        }
+    }
+
+    public:
+    /// pin-change pins of PORTB, PORTC and PORTD, PCMSK0 to PCMSK2
+    static constexpr uint8_t mask_b = m_port_mask<__details::PINB_ADDR>;
+    static constexpr uint8_t mask_c = m_port_mask<__details::PINC_ADDR>;
+    static constexpr uint8_t mask_d = m_port_mask<__details::PIND_ADDR>;
+
+    /// @brief configure every pin, take the current levels as the last state and unmask the vectors
+    static void init() noexcept {
+        (Bindings::init(), ...);
+        enable_port<__details::PINB_ADDR>();
+        enable_port<__details::PINC_ADDR>();
+        enable_port<__details::PIND_ADDR>();
+        (enable_external<Bindings>(), ...);
+    }
+
+    /// @brief the PCINTn vector body of the port whose PINx is at PINR
+    template <uint8_t PINR>
+    __attribute__((always_inline)) static void on_port() noexcept {
+        if constexpr (m_port_mask<PINR> != 0) {
+            uint8_t now     = __details::__reg_read<PINR>();
+            uint8_t changed = static_cast<uint8_t>((now ^ s_last<PINR>) & m_port_mask<PINR>);
+            s_last<PINR>    = now;
+            (dispatch<Bindings, PINR>(now, changed), ...);
+        }
+    }
+
+    /// @brief the INT0 / INT1 vector bodies
+    __attribute__((always_inline)) static void on_int0() noexcept { (dispatch_external<Bindings, __details::__irq_source::INT0>(), ...); }
+    __attribute__((always_inline)) static void on_int1() noexcept { (dispatch_external<Bindings, __details::__irq_source::INT1>(), ...); }
+};
+
+} // namespace firmware
+
+/// the three pin-change vectors of an interrupts table, in exactly one translation unit
+#define FIRMWARE_PIN_CHANGE_ISR(table)                                    \
+    ISR(PCINT0_vect) { table::on_port<firmware::__details::PINB_ADDR>(); } \
+    ISR(PCINT1_vect) { table::on_port<firmware::__details::PINC_ADDR>(); } \
+    ISR(PCINT2_vect) { table::on_port<firmware::__details::PIND_ADDR>(); }
+
+/// the INT0 and INT1 vectors of an interrupts table, in exactly one translation unit
+#define FIRMWARE_EXTERNAL_ISR(table)         \
+    ISR(INT0_vect) { table::on_int0(); } \
+    ISR(INT1_vect) { table::on_int1(); }
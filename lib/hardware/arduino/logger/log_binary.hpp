@@ -0,0 +1,255 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <type_traits>
+
+#include "log_level.hpp"
+
+/*
+ * Deferred binary logging: the device sends a 16-bit id of the format string and the raw
+ * arguments, the host puts the text back together (see log_decoder.hpp).
+ *
+ * One frame is one line:
+ *
+ *     0x10 | level, id (LE16), millis() (varint), arguments..., '\n'
+ *
+ * Arguments are encoded by their conversion in the format, never by the C++ type: %d / %i as a
+ * zigzag varint, %u %x %X %o %c as a varint, %f %e %g as a 4-byte float, %s as a varint length
+ * and the bytes. A 0x0A or 0x7D inside the frame is sent as 0x7D, byte ^ 0x20, so the '\n' at
+ * the end is the only one: frames and text lines share the link, log_buffer drops them whole,
+ * and the decoder resynchronises on the next line after a lost byte. Each frame carries the
+ * absolute time rather than the time since the one before, so a lost or dropped frame, or a
+ * capture started after boot, does not shift the time of the frames that follow.
+ *
+ * The format strings themselves go to their own section and never reach flash. On AVR the
+ * section is not allocated, it stays in the ELF; tools/log_table.py copies it out after the
+ * build and the decoder reads it back as the string table.
+ */
+
+#ifndef FIRMWARE_LOG_FRAME
+#define FIRMWARE_LOG_FRAME 48
+#endif
+
+#ifdef __AVR__
+// no "a" flag: kept in the ELF, left out of the image
+#define FIRMWARE_LOG_SECTION ".pushsection .fwlog,\"\",@progbits"
+#else
+// allocated, so native tests find the table between __start_fwlog and __stop_fwlog
+#define FIRMWARE_LOG_SECTION ".pushsection fwlog,\"a\",@progbits"
+#endif
+
+namespace firmware {
+
+namespace __details {
+
+/// what a conversion sends, two bits an argument in the kinds word
+enum __log_kind : uint8_t {
+    LOG_UNSIGNED = 0,
+    LOG_SIGNED   = 1,
+    LOG_FLOAT    = 2,
+    LOG_STRING   = 3,
+    LOG_INVALID  = 4,
+};
+
+constexpr uint8_t LOG_FRAME_MARK = 0x10; // | level, below any printable first byte of a text line
+constexpr uint8_t LOG_ESCAPE     = 0x7D;
+constexpr size_t LOG_MAX_ARGS    = 16;
+
+/// @brief FNV-1a of the format, folded to 16 bits
+constexpr uint16_t __log_id(const char* fmt) noexcept {
+    uint32_t h = 2166136261u;
+    while (*fmt) h = (h ^ static_cast<uint8_t>(*fmt++)) * 16777619u;
+    return static_cast<uint16_t>((h >> 16) ^ (h & 0xFFFF));
+}
+
+/// @brief skip one conversion after its '%': flags, width, precision, length
+/// @return the conversion character, *fmt left on it
+constexpr char __log_conversion(const char*& fmt) noexcept {
+    while (*fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#' || *fmt == '0') fmt++;
+    while (*fmt >= '0' && *fmt <= '9') fmt++;
+    if (*fmt == '.') {
+        fmt++;
+        while (*fmt >= '0' && *fmt <= '9') fmt++;
+    }
+    while (*fmt == 'h' || *fmt == 'l' || *fmt == 'L' || *fmt == 'z' || *fmt == 'j' || *fmt == 't') fmt++;
+    return *fmt;
+}
+
+constexpr __log_kind __log_kind_of(char conv) noexcept {
+    switch (conv) {
+    case 'd':
+    case 'i': return LOG_SIGNED;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+    case 'c': return LOG_UNSIGNED;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G': return LOG_FLOAT;
+    case 's': return LOG_STRING;
+    default: return LOG_INVALID; // '*' widths and %p / %n are not sent
+    }
+}
+
+/// @brief the kinds of the arguments of fmt, two bits each, first argument lowest
+constexpr uint32_t __log_kinds(const char* fmt) noexcept {
+    uint32_t kinds = 0;
+    uint8_t n      = 0;
+    for (; *fmt; fmt++) {
+        if (*fmt != '%') continue;
+        if (*++fmt == '%') continue;
+        kinds |= static_cast<uint32_t>(__log_kind_of(__log_conversion(fmt)) & 3) << (2 * n++);
+        if (!*fmt) break;
+    }
+    return kinds;
+}
+
+/// @brief the number of arguments fmt takes, or LOG_MAX_ARGS + 1 for a conversion that is not sent
+constexpr size_t __log_count(const char* fmt) noexcept {
+    size_t n = 0;
+    for (; *fmt; fmt++) {
+        if (*fmt != '%') continue;
+        if (*++fmt == '%') continue;
+        if (__log_kind_of(__log_conversion(fmt)) == LOG_INVALID) return LOG_MAX_ARGS + 1;
+        n++;
+        if (!*fmt) break;
+    }
+    return n;
+}
+
+/// the class of conversion an argument type can stand for
+template <typename T>
+constexpr __log_kind __log_class() noexcept {
+    using U = msd::decay_t<T>;
+    if constexpr (msd::is_integral<U>::value) return LOG_UNSIGNED; // either of the integer conversions
+    else if constexpr (msd::is_floating_point<U>::value) return LOG_FLOAT;
+    else if constexpr (msd::is_same<U, const char*>::value || msd::is_same<U, char*>::value) return LOG_STRING;
+    else return LOG_INVALID;
+}
+
+template <typename... Args> struct __log_args {};
+/// never called: decltype(__log_sig(args...)) names the argument types of a macro's arguments
+template <typename... Args> __log_args<Args...> __log_sig(Args...);
+
+/// @brief whether args can be sent for fmt: the same count, each one of the right class
+template <typename... Args>
+constexpr bool __log_check(const char* fmt, __log_args<Args...>) noexcept {
+    if (__log_count(fmt) != sizeof...(Args)) return false;
+    const uint32_t kinds   = __log_kinds(fmt);
+    const __log_kind cls[] = { __log_class<Args>()..., LOG_INVALID };
+    for (size_t i = 0; i < sizeof...(Args); i++) {
+        __log_kind want = static_cast<__log_kind>(kinds >> (2 * i) & 3);
+        if (want == LOG_SIGNED) want = LOG_UNSIGNED;
+        if (cls[i] != want) return false;
+    }
+    return true;
+}
+
+} // namespace __details
+
+/*
+ * One binary frame being built, escaped as it goes. A frame that does not fit is not sent:
+ * encode() returns false. Only %s arguments can make a frame long, keep them short.
+ */
+class log_frame {
+    static_assert(FIRMWARE_LOG_FRAME >= 8 && FIRMWARE_LOG_FRAME <= 255, "FIRMWARE_LOG_FRAME must be 8 to 255");
+
+    private:
+    uint8_t m_data[FIRMWARE_LOG_FRAME];
+    uint8_t m_size;
+    bool m_overflow;
+
+    void put(uint8_t b) noexcept {
+        if (b == '\n' || b == __details::LOG_ESCAPE) {
+            if (m_size + 2 >= FIRMWARE_LOG_FRAME) return void(m_overflow = true);
+            m_data[m_size++] = __details::LOG_ESCAPE;
+            b ^= 0x20;
+        } else if (m_size + 1 >= FIRMWARE_LOG_FRAME) {
+            return void(m_overflow = true);
+        }
+        m_data[m_size++] = b;
+    }
+
+    void varint(uint32_t v) noexcept {
+        while (v >= 0x80) {
+            put(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        put(static_cast<uint8_t>(v));
+    }
+
+    template <uint8_t Kind, typename T>
+    void arg(T v) noexcept {
+        if constexpr (Kind == __details::LOG_STRING) {
+            size_t len = strlen(v);
+            varint(static_cast<uint32_t>(len));
+            for (size_t i = 0; i < len; i++) put(static_cast<uint8_t>(v[i]));
+        } else if constexpr (Kind == __details::LOG_FLOAT) {
+            float f = static_cast<float>(v);
+            uint8_t bytes[4];
+            memcpy(bytes, &f, 4);
+            for (uint8_t b : bytes) put(b);
+        } else if constexpr (Kind == __details::LOG_SIGNED) {
+            int32_t s = static_cast<int32_t>(v);
+            varint((static_cast<uint32_t>(s) << 1) ^ static_cast<uint32_t>(s >> 31));
+        } else {
+            varint(static_cast<uint32_t>(v));
+        }
+    }
+
+    template <uint32_t Kinds, size_t... I, typename... Args>
+    void args(msd::index_sequence<I...>, Args... a) noexcept {
+        (arg<(Kinds >> (2 * I) & 3)>(a), ...);
+    }
+
+    public:
+    log_frame() noexcept : m_size(0), m_overflow(false) {}
+
+    /// @brief encode a whole frame, Kinds from __log_kinds() of the format, ms the millis() it was sent at
+    /// @return false when it did not fit
+    template <uint32_t Kinds, typename... Args>
+    bool encode(uint8_t level, uint16_t id, uint32_t ms, Args... a) noexcept {
+        static_assert(sizeof...(Args) <= __details::LOG_MAX_ARGS, "at most 16 arguments");
+        m_size     = 0;
+        m_overflow = false;
+        put(static_cast<uint8_t>(__details::LOG_FRAME_MARK | (level & 0x07)));
+        put(static_cast<uint8_t>(id));
+        put(static_cast<uint8_t>(id >> 8));
+        varint(ms);
+        args<Kinds>(msd::index_sequence_for<Args...>{}, a...);
+        m_data[m_size++] = '\n'; // put() always leaves room for it
+        return !m_overflow;
+    }
+
+    const uint8_t* data() const noexcept { return m_data; }
+    size_t size() const noexcept { return m_size; }
+};
+
+} // namespace firmware
+
+/*
+ * Log through any target with a log_binary<Kinds, Id>(level, args...) member, the format and
+ * the argument types checked at compile time. fmt must be one string literal: the assembler
+ * writes it to the log section as it is, a call site inlined twice writing it twice. A level
+ * below FIRMWARE_LOG_LEVEL leaves nothing but the checks, at any optimisation level.
+ */
+#define FIRMWARE_LOG_BIN_TO(target, level, fmt, ...)                                                                  \
+    do {                                                                                                              \
+        static_assert(firmware::__details::__log_check(fmt, decltype(firmware::__details::__log_sig(__VA_ARGS__)){}), \
+                      "log format and arguments disagree");                                                           \
+        if constexpr (firmware::is_compiled(level)) {                                                                 \
+            asm(FIRMWARE_LOG_SECTION "\n\t.asciz " #fmt "\n\t.popsection");                                          \
+            (target).template log_binary<firmware::__details::__log_kinds(fmt), firmware::__details::__log_id(fmt)>(  \
+            level, ##__VA_ARGS__);                                                                                    \
+        }                                                                                                             \
+    } while (0)
+
+/// @brief binary log through the logger: FIRMWARE_LOG_BIN(firmware::Level::WARN, "motor %u stalled", axis);
+#define FIRMWARE_LOG_BIN(level, fmt, ...) FIRMWARE_LOG_BIN_TO(firmware::logger::instance(), level, fmt, ##__VA_ARGS__)
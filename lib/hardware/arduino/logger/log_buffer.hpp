@@ -0,0 +1,191 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../pins/pins.hpp"
+
+namespace firmware {
+
+/// what a full log buffer does with a message that does not fit
+enum class LogOverflow : uint8_t {
+    DROP_NEWEST, // keep what is queued, lose the new message
+    DROP_OLDEST, // discard whole queued messages until the new one fits
+    BLOCK,       // wait for the drain to make room, as the synchronous logger does
+};
+
+/*
+ * Byte ring holding whole log messages between the code that logs and whatever drains them to
+ * the UART. write() copies a message in and returns; read() hands out bytes in order, in as
+ * many pieces as the drain likes. A message is only published once it is entirely in, and the
+ * overflow policies drop whole messages; the one exception is DROP_OLDEST cutting the rest of a
+ * message the drain has already started on.
+ *
+ * The indices are 16-bit, so every index update runs with interrupts masked; the reader may
+ * be the main loop or an ISR, and so may the writers of write(), which takes the whole message
+ * in one masked step. Messages must end in '\n', which is where DROP_OLDEST cuts.
+ */
+template <size_t N>
+class log_buffer {
+    static_assert(N >= 16 && N <= 0x8000 && (N & (N - 1)) == 0, "N must be a power of two, 16 to 32768");
+
+    private:
+    char m_data[N];
+    volatile uint16_t m_head; // one past the last published byte
+    volatile uint16_t m_tail; // next byte to read
+    volatile uint16_t m_dropped;
+    uint16_t m_pending; // bytes appended past m_head, not yet committed
+    bool m_failed;      // the message being appended was dropped
+    LogOverflow m_policy;
+    void (*m_wait)();
+
+    uint16_t used() const noexcept { return static_cast<uint16_t>(m_head - m_tail); }
+
+    /// advance the tail past the oldest message, interrupts masked by the caller
+    void drop_oldest() noexcept {
+        uint16_t tail = m_tail;
+        while (tail != m_head && m_data[tail++ & (N - 1)] != '\n') {}
+        m_tail = tail;
+    }
+
+    /// make room for len more bytes past head and pending, as the policy says
+    /// @return false when there is none, interrupts masked by the caller through sreg
+    bool make_room(size_t len, uint8_t& sreg) noexcept {
+        while (N - used() - m_pending < len) {
+            if (m_policy == LogOverflow::DROP_OLDEST && used() != 0) {
+                drop_oldest();
+                m_dropped = static_cast<uint16_t>(m_dropped + 1);
+            } else if (m_policy == LogOverflow::BLOCK && m_wait && used() != 0) {
+                __details::__irq_restore(sreg);
+                m_wait();
+                sreg = __details::__irq_save();
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    public:
+    static constexpr size_t capacity = N;
+
+    log_buffer() noexcept
+    : m_head(0), m_tail(0), m_dropped(0), m_pending(0), m_failed(false), m_policy(LogOverflow::DROP_NEWEST), m_wait(nullptr) {}
+
+    log_buffer(const log_buffer&)            = delete;
+    log_buffer& operator=(const log_buffer&) = delete;
+
+    /// @brief the overflow policy; BLOCK calls wait() until there is room, a drain step that must make progress
+    void set_policy(LogOverflow policy, void (*wait)() = nullptr) noexcept {
+        m_policy = policy;
+        m_wait   = wait;
+    }
+    LogOverflow policy() const noexcept { return m_policy; }
+
+    /// @brief queue one whole message
+    /// @return false when it was dropped, on a full buffer or for being longer than the buffer
+    bool write(const char* msg, size_t len) noexcept {
+        if (len > N) {
+            m_dropped = static_cast<uint16_t>(m_dropped + 1);
+            return false;
+        }
+
+        uint8_t sreg = __details::__irq_save();
+        if (N - used() < len) {
+            if (m_policy == LogOverflow::DROP_OLDEST) {
+                while (N - used() < len) {
+                    drop_oldest();
+                    m_dropped = static_cast<uint16_t>(m_dropped + 1);
+                }
+            } else if (m_policy == LogOverflow::BLOCK && m_wait) {
+                while (N - used() < len) {
+                    __details::__irq_restore(sreg);
+                    m_wait();
+                    sreg = __details::__irq_save();
+                }
+            } else {
+                m_dropped = static_cast<uint16_t>(m_dropped + 1);
+                __details::__irq_restore(sreg);
+                return false;
+            }
+        }
+        // copied and published in one masked step, so an ISR writing its own message cannot
+        // land in the middle of this one
+        uint16_t head = m_head;
+        for (size_t i = 0; i < len; i++) m_data[(head + i) & (N - 1)] = msg[i];
+        m_head = static_cast<uint16_t>(head + len);
+        __details::__irq_restore(sreg);
+        return true;
+    }
+
+    /*
+     * A message streamed in pieces, for a formatter writing straight into the buffer:
+     * begin(), any number of append(), then commit(). Nothing is visible to read() before
+     * commit(), and a message that runs out of room is dropped whole, with the same policies
+     * as write(). One writer at a time: the message in progress is shared state, so it is not
+     * for code an ISR that logs can interrupt, nor to be mixed with write() from an ISR.
+     */
+    void begin() noexcept {
+        m_pending = 0;
+        m_failed  = false;
+    }
+    void append(const char* piece, size_t len) noexcept {
+        if (m_failed) return;
+        if (len > N - m_pending) return void(m_failed = true);
+
+        uint8_t sreg = __details::__irq_save();
+        bool room    = make_room(len, sreg);
+        uint16_t at  = static_cast<uint16_t>(m_head + m_pending);
+        __details::__irq_restore(sreg);
+        if (!room) return void(m_failed = true);
+
+        for (size_t i = 0; i < len; i++) m_data[(at + i) & (N - 1)] = piece[i];
+        m_pending = static_cast<uint16_t>(m_pending + len);
+    }
+    void put(char c) noexcept { append(&c, 1); }
+    /// @return false when the message was dropped
+    bool commit() noexcept {
+        uint8_t sreg = __details::__irq_save();
+        if (m_failed) m_dropped = static_cast<uint16_t>(m_dropped + 1);
+        else m_head = static_cast<uint16_t>(m_head + m_pending);
+        __details::__irq_restore(sreg);
+        m_pending = 0;
+        return !m_failed;
+    }
+
+    /// @brief take up to max queued bytes
+    /// @return how many were copied to out
+    size_t read(char* out, size_t max) noexcept {
+        uint8_t sreg  = __details::__irq_save();
+        uint16_t tail = m_tail;
+        size_t n      = used();
+        if (n > max) n = max;
+        for (size_t i = 0; i < n; i++) out[i] = m_data[(tail + i) & (N - 1)];
+        m_tail = static_cast<uint16_t>(tail + n);
+        __details::__irq_restore(sreg);
+        return n;
+    }
+
+    size_t size() const noexcept {
+        uint8_t sreg = __details::__irq_save();
+        size_t n     = used();
+        __details::__irq_restore(sreg);
+        return n;
+    }
+    bool empty() const noexcept { return size() == 0; }
+
+    /// @brief messages lost to overflow
+    uint16_t dropped() const noexcept {
+        uint8_t sreg = __details::__irq_save();
+        uint16_t n   = m_dropped;
+        __details::__irq_restore(sreg);
+        return n;
+    }
+    void reset_dropped() noexcept {
+        uint8_t sreg = __details::__irq_save();
+        m_dropped    = 0;
+        __details::__irq_restore(sreg);
+    }
+};
+
+} // namespace firmware
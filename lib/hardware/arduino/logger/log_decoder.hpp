@@ -0,0 +1,181 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "log_binary.hpp"
+
+namespace firmware {
+
+/*
+ * Host side of the binary log: turns frames back into the lines the text logger prints,
+ * "[s.mmm][LEVEL]message". Not for the device, it formats with the host's snprintf.
+ *
+ * The string table is the raw log section, NUL-terminated formats with zero padding between
+ * them. Two formats with one id can not be told apart; load() counts them in collisions() and
+ * the later one is ignored, rewording either message fixes it.
+ */
+class log_decoder {
+    public:
+    static constexpr size_t max_formats = 1024;
+
+    private:
+    struct entry {
+        uint16_t id;
+        const char* fmt;
+    };
+    entry m_entries[max_formats];
+    size_t m_count;
+    size_t m_collisions;
+
+    /// reads one frame, already unescaped
+    struct reader {
+        const uint8_t* p;
+        const uint8_t* end;
+        bool ok;
+
+        uint8_t byte() noexcept {
+            if (p == end) return ok = false, 0;
+            return *p++;
+        }
+        uint32_t varint() noexcept {
+            uint32_t v = 0;
+            for (uint8_t shift = 0; shift < 35; shift += 7) {
+                uint8_t b = byte();
+                v |= static_cast<uint32_t>(b & 0x7F) << shift;
+                if (!(b & 0x80)) return v;
+            }
+            return ok = false, v;
+        }
+    };
+
+    static const char* level_name(uint8_t level) noexcept {
+        static const char* const names[] = { "FATAL", "ERROR", " WARN", " INFO", "DEBUG" };
+        return level < 5 ? names[level] : "UNKNOW";
+    }
+
+    public:
+    log_decoder() noexcept : m_count(0), m_collisions(0) {}
+
+    /// @brief take the formats of a string table, which must outlive the decoder
+    /// @return how many formats are known now
+    size_t load(const char* table, size_t len) noexcept {
+        const char* end = table + len;
+        while (table < end) {
+            size_t n = strnlen(table, static_cast<size_t>(end - table));
+            if (n != 0 && table + n < end) add(table);
+            table += n + 1;
+        }
+        return m_count;
+    }
+
+    /// @brief a single format, as the device hashes it
+    void add(const char* fmt) noexcept {
+        uint16_t id = __details::__log_id(fmt);
+        if (const char* known = find(id)) {
+            if (strcmp(known, fmt) != 0) m_collisions++;
+            return; // the same call site again, or the same text at another
+        }
+        if (m_count < max_formats) m_entries[m_count++] = { id, fmt };
+    }
+
+    const char* find(uint16_t id) const noexcept {
+        for (size_t i = 0; i < m_count; i++)
+            if (m_entries[i].id == id) return m_entries[i].fmt;
+        return nullptr;
+    }
+
+    size_t size() const noexcept { return m_count; }
+    size_t collisions() const noexcept { return m_collisions; }
+
+    /// @brief whether a line, without its '\n', is a binary frame rather than text
+    static bool is_frame(const uint8_t* line, size_t len) noexcept {
+        return len >= 4 && (line[0] & 0xF8) == __details::LOG_FRAME_MARK;
+    }
+
+    /// @brief decode one frame, given without its '\n', into text
+    /// @return false for a line that is not a frame, an unknown id or a damaged frame
+    bool decode(const uint8_t* line, size_t len, char* out, size_t max) noexcept {
+        if (!is_frame(line, len) || max == 0) return false;
+
+        uint8_t raw[256];
+        size_t n = 0;
+        for (size_t i = 0; i < len && n < sizeof(raw); i++)
+            raw[n++] = line[i] == __details::LOG_ESCAPE && i + 1 < len ? line[++i] ^ 0x20 : line[i];
+
+        reader r{ raw, raw + n, true };
+        uint8_t level   = r.byte() & 0x07;
+        uint16_t id     = r.byte();
+        id              = static_cast<uint16_t>(id | r.byte() << 8);
+        uint32_t clock  = r.varint(); // the device's millis()
+        const char* fmt = find(id);
+        if (!fmt || !r.ok) return false;
+
+        size_t pos = 0;
+        auto emit  = [&](int written) {
+            if (written > 0) pos += static_cast<size_t>(written);
+            if (pos >= max) pos = max - 1;
+        };
+        emit(snprintf(out, max, "[%lu.%03lu][%s]", static_cast<unsigned long>(clock / 1000), static_cast<unsigned long>(clock % 1000), level_name(level)));
+
+        for (const char* f = fmt; *f; f++) {
+            if (*f != '%' || f[1] == '%') {
+                if (*f == '%') f++;
+                if (pos + 1 < max) out[pos++] = *f;
+                continue;
+            }
+            // the spec without its length modifier, the value's own one put back in
+            const char* start = f++;
+            char conv         = __details::__log_conversion(f);
+            char spec[24];
+            size_t s = 0;
+            for (const char* c = start; c < f && s < sizeof(spec) - 4; c++)
+                if (*c != 'h' && *c != 'l' && *c != 'L' && *c != 'z' && *c != 'j' && *c != 't') spec[s++] = *c;
+
+            switch (__details::__log_kind_of(conv)) {
+            case __details::LOG_SIGNED: {
+                uint32_t z = r.varint();
+                spec[s++] = 'l', spec[s++] = conv, spec[s] = '\0';
+                emit(snprintf(out + pos, max - pos, spec, static_cast<long>(static_cast<int32_t>((z >> 1) ^ (0u - (z & 1))))));
+                break;
+            }
+            case __details::LOG_UNSIGNED: {
+                uint32_t u = r.varint();
+                if (conv == 'c') {
+                    spec[s++] = conv, spec[s] = '\0';
+                    emit(snprintf(out + pos, max - pos, spec, static_cast<int>(static_cast<unsigned char>(u))));
+                } else {
+                    spec[s++] = 'l', spec[s++] = conv, spec[s] = '\0';
+                    emit(snprintf(out + pos, max - pos, spec, static_cast<unsigned long>(u)));
+                }
+                break;
+            }
+            case __details::LOG_FLOAT: {
+                uint8_t bytes[4] = { r.byte(), r.byte(), r.byte(), r.byte() };
+                float v;
+                memcpy(&v, bytes, 4);
+                spec[s++] = conv, spec[s] = '\0';
+                emit(snprintf(out + pos, max - pos, spec, static_cast<double>(v)));
+                break;
+            }
+            case __details::LOG_STRING: {
+                char str[256];
+                uint32_t l = r.varint();
+                for (uint32_t i = 0; i < l && i < sizeof(str) - 1; i++) str[i] = static_cast<char>(r.byte());
+                str[l < sizeof(str) - 1 ? l : sizeof(str) - 1] = '\0';
+                spec[s++] = conv, spec[s] = '\0';
+                emit(snprintf(out + pos, max - pos, spec, str));
+                break;
+            }
+            default: return false;
+            }
+            if (!*f) break;
+        }
+        out[pos] = '\0';
+        return r.ok && r.p == r.end;
+    }
+};
+
+} // namespace firmware
@@ -0,0 +1,40 @@
+#pragma once
+
+/*
+ * The least severe level built into the firmware, a build flag: -DFIRMWARE_LOG_LEVEL=2 keeps
+ * FATAL, ERROR and WARN. A logger call below it is discarded at compile time, its format,
+ * arguments and string literals with it; the runtime level of logger::set_level() filters
+ * what is left. -1 compiles every call out.
+ */
+#ifndef FIRMWARE_LOG_LEVEL
+#define FIRMWARE_LOG_LEVEL 4 // DEBUG, everything
+#endif
+
+namespace firmware {
+
+enum class Level {
+    DEBUG   = 4,
+    INFO    = 3,
+    WARN    = 2,
+    ERROR   = 1,
+    FATAL   = 0,
+    DISABLE = -1,
+};
+
+static_assert(FIRMWARE_LOG_LEVEL >= -1 && FIRMWARE_LOG_LEVEL <= 4, "FIRMWARE_LOG_LEVEL is -1 (nothing) to 4 (DEBUG)");
+
+/// @brief the least severe level compiled in
+constexpr Level compiled_level = static_cast<Level>(FIRMWARE_LOG_LEVEL);
+
+/// @brief whether messages of level are compiled in; a Level or its number
+template <typename L>
+constexpr bool is_compiled(L level) noexcept {
+    return static_cast<int>(level) >= 0 && static_cast<int>(level) <= FIRMWARE_LOG_LEVEL;
+}
+
+/// @brief whether a message of level goes out: compiled in, and not above the runtime level
+constexpr bool is_enabled(Level level, Level runtime) noexcept {
+    return is_compiled(level) && static_cast<int>(level) <= static_cast<int>(runtime);
+}
+
+} // namespace firmware
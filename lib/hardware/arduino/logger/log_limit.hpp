@@ -0,0 +1,245 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <format>
+#include <type_traits>
+
+#include "log_level.hpp"
+
+/*
+ * Two ways to keep a flood of one message off the UART.
+ *
+ * Rate limiting, per call site: FIRMWARE_LOG_LIMITED(level, burst, period_ms, "..."_fmt, ...)
+ * lets burst messages through at once and then one per period_ms, a token bucket. Its state is
+ * a static at the call site, 7 bytes, so only the sites that ask for a limit pay for one. A
+ * suppressed call costs the level check, millis() and one compare; the next message that goes
+ * out carries the number suppressed.
+ *
+ * Coalescing, in the logger, off unless set_coalesce(true): a message equal to the one before
+ * it, the same call site, level and arguments, is counted instead of sent, and "last message
+ * repeated N times" goes out when a different message arrives, at flush(), or every 65535
+ * repeats. A repeat FIRMWARE_LOG_REPEAT_MS or more after the message was last sent goes out
+ * again, after the count, so a periodic status line still shows up now and then. Arguments are
+ * compared by their bytes, up to FIRMWARE_LOG_KEY of them; strings by a hash of their text. A
+ * message with more argument bytes than that is never taken for a repeat.
+ *
+ * log_filter does both around the lines of a target; the logger is one, and tests use it the
+ * same way with a target of their own.
+ */
+#ifndef FIRMWARE_LOG_KEY
+#define FIRMWARE_LOG_KEY 8
+#endif
+
+#ifndef FIRMWARE_LOG_REPEAT_MS
+#define FIRMWARE_LOG_REPEAT_MS 10000
+#endif
+
+namespace firmware {
+
+namespace __details {
+/// FNV-1a of a string's text
+inline uint32_t __log_text_hash(const char* s) noexcept {
+    uint32_t h = 2166136261u;
+    for (; *s; s++) h = (h ^ static_cast<uint8_t>(*s)) * 16777619u;
+    return h;
+}
+} // namespace __details
+
+/// @brief a token bucket for one call site: Burst messages at once, then one per PeriodMs.
+/// All zero is a full bucket, so a static one needs no constructor and no guard.
+template <uint8_t Burst, uint16_t PeriodMs>
+class log_rate {
+    static_assert(Burst >= 1, "a burst of at least one message");
+    static_assert(PeriodMs >= 1, "a period of at least 1 ms");
+
+    private:
+    uint32_t m_next;       // ms the next token comes back, while any are spent
+    uint8_t m_spent;       // tokens taken, Burst is an empty bucket
+    uint16_t m_suppressed; // calls refused since the last one let through
+
+    public:
+    /// @brief whether a message may go out at now, in ms; takes a token if so
+    bool allow(uint32_t now) noexcept {
+        if (m_spent == Burst && static_cast<int32_t>(now - m_next) < 0) { // the flood: empty, none due
+            if (m_suppressed != 0xFFFF) m_suppressed++;
+            return false;
+        }
+        while (m_spent != 0 && static_cast<int32_t>(now - m_next) >= 0) m_spent--, m_next += PeriodMs;
+        if (m_spent == 0) m_next = now + PeriodMs;
+        m_spent++;
+        return true;
+    }
+
+    /// @brief calls refused since the last take, and start counting again
+    uint16_t take_suppressed() noexcept {
+        uint16_t n   = m_suppressed;
+        m_suppressed = 0;
+        return n;
+    }
+};
+
+/// @brief what makes two messages the same: call site, level and argument bytes
+class log_key {
+    private:
+    const void* m_site;
+    uint8_t m_level;
+    uint8_t m_size; // 0xFF: too many argument bytes, equal to nothing
+    uint8_t m_bytes[FIRMWARE_LOG_KEY];
+
+    void add_bytes(const void* p, uint8_t n) noexcept {
+        if (m_size > FIRMWARE_LOG_KEY - n) {
+            m_size = 0xFF;
+            return;
+        }
+        memcpy(m_bytes + m_size, p, n);
+        m_size = static_cast<uint8_t>(m_size + n);
+    }
+
+    template <typename T>
+    void add(T v) noexcept {
+        if (m_size == 0xFF) return;
+        if constexpr (msd::is_same<T, const char*>::value || msd::is_same<T, char*>::value) {
+            uint32_t h = __details::__log_text_hash(v ? v : "");
+            add_bytes(&h, sizeof(h));
+        } else {
+            add_bytes(&v, sizeof(v));
+        }
+    }
+
+    public:
+    /// @brief a key equal to nothing
+    log_key() noexcept : m_site(nullptr), m_level(0), m_size(0xFF) {}
+
+    /// @brief site is anything unique to the call: its format, a flash string
+    template <typename... Args>
+    log_key(const void* site, Level level, Args... args) noexcept : m_site(site), m_level(static_cast<uint8_t>(level)), m_size(0) {
+        (add(args), ...);
+    }
+
+    Level level() const noexcept { return static_cast<Level>(static_cast<int8_t>(m_level)); }
+
+    bool operator==(const log_key& other) const noexcept {
+        return m_size != 0xFF && m_site == other.m_site && m_level == other.m_level && m_size == other.m_size &&
+               memcmp(m_bytes, other.m_bytes, m_size) == 0;
+    }
+};
+
+/// @brief the last message and how many times it came again since it was sent
+class log_repeat {
+    private:
+    log_key m_last;
+    uint16_t m_count;
+
+    public:
+    log_repeat() noexcept : m_count(0) {}
+
+    /// @brief whether key repeats the last message; counts it if so. Saturated at 65535, the
+    /// next repeat is refused so that the count gets reported.
+    bool repeat(const log_key& key) noexcept {
+        if (m_count == 0xFFFF || !(key == m_last)) return false;
+        m_count++;
+        return true;
+    }
+
+    /// @brief repeats not reported yet, and the level of the message they repeat
+    uint16_t count() const noexcept { return m_count; }
+    Level level() const noexcept { return m_last.level(); }
+
+    /// @brief key went out: compare with it from now on
+    void replace(const log_key& key) noexcept { m_last = key, m_count = 0; }
+    /// @brief forget the last message, the next one is never a repeat
+    void clear() noexcept { m_last = log_key(), m_count = 0; }
+};
+
+/// @brief coalescing and rate limiting around the lines of a target. Lines is where a line
+/// goes: begin_line(level), put(char) and write(const char*, size_t) for the text, end_line().
+class log_filter {
+    private:
+    log_repeat m_repeat;
+    uint32_t m_sent; // ms the message m_repeat compares with was last sent
+    bool m_coalesce;
+
+    template <typename Lines>
+    void report(Lines& out) {
+        using namespace msd::literals;
+        if (m_repeat.count() == 0) return;
+        out.begin_line(m_repeat.level());
+        msd::format(out, "last message repeated {} times"_fmt, m_repeat.count());
+        out.end_line();
+    }
+
+    public:
+    log_filter() noexcept : m_sent(0), m_coalesce(false) {}
+
+    bool is_coalescing() const noexcept { return m_coalesce; }
+
+    /// @brief coalescing on or off; repeats counted so far are reported either way
+    template <typename Lines>
+    void set_coalesce(Lines& out, bool coalesce) {
+        flush(out);
+        m_coalesce = coalesce;
+    }
+
+    /// @brief report repeats counted so far, the next message is never a repeat
+    template <typename Lines>
+    void flush(Lines& out) {
+        report(out);
+        m_repeat.clear();
+    }
+
+    /// @brief whether the message of key, at now in ms, is a repeat to count instead of sending;
+    /// if not, the repeats before it are reported and it becomes the one to compare with
+    template <typename Lines>
+    bool drop(Lines& out, const log_key& key, uint32_t now) {
+        if (!m_coalesce) return false;
+        if (now - m_sent < FIRMWARE_LOG_REPEAT_MS && m_repeat.repeat(key)) return true;
+        report(out);
+        m_repeat.replace(key);
+        m_sent = now;
+        return false;
+    }
+
+    /// @brief one formatted line, unless it is a repeat
+    template <typename Lines, char... Cs, typename... Args>
+    void line(Lines& out, uint32_t now, Level level, msd::fmt_string<Cs...> fmt, Args... args) {
+        if (drop(out, log_key(fmt.value, level, args...), now)) return;
+        out.begin_line(level);
+        msd::format(out, fmt, args...);
+        out.end_line();
+    }
+
+    /// @brief line() from one call site, at most as often as rate lets it; the line carries
+    /// the number of calls the rate held back before it
+    template <typename Lines, typename Rate, char... Cs, typename... Args>
+    void limited(Lines& out, Rate& rate, uint32_t now, Level level, msd::fmt_string<Cs...> fmt, Args... args) {
+        using namespace msd::literals;
+        if (!rate.allow(now)) return;
+        if (drop(out, log_key(fmt.value, level, args...), now)) return;
+        out.begin_line(level);
+        msd::format(out, fmt, args...);
+        if (uint16_t n = rate.take_suppressed()) msd::format(out, " ({} suppressed)"_fmt, n);
+        out.end_line();
+    }
+};
+
+} // namespace firmware
+
+/*
+ * Log through any target with a log_limited(rate, level, fmt, args...) member, at most burst
+ * messages at once and then one per period_ms from this call site.
+ */
+#define FIRMWARE_LOG_LIMITED_TO(target, level, burst, period_ms, fmt, ...)         \
+    do {                                                                           \
+        if constexpr (firmware::is_compiled(level)) {                              \
+            static firmware::log_rate<(burst), (period_ms)> __fw_log_rate;         \
+            (target).log_limited(__fw_log_rate, level, fmt, ##__VA_ARGS__);        \
+        }                                                                          \
+    } while (0)
+
+/// @brief rate-limited log through the logger:
+/// FIRMWARE_LOG_LIMITED(firmware::Level::WARN, 3, 1000, "sensor {} fault"_fmt, id);
+#define FIRMWARE_LOG_LIMITED(level, burst, period_ms, fmt, ...) \
+    FIRMWARE_LOG_LIMITED_TO(firmware::logger::instance(), level, burst, period_ms, fmt, ##__VA_ARGS__)
@@ -0,0 +1,15 @@
+#ifdef ARDUINO
+
+#include "log_sink.hpp"
+
+#include <Arduino.h>
+
+namespace firmware {
+
+void serial_sink::put(char c) { Serial.write(static_cast<uint8_t>(c)); }
+void serial_sink::write(const char* str, size_t len) { Serial.write(reinterpret_cast<const uint8_t*>(str), len); }
+size_t serial_sink::room() { return static_cast<size_t>(Serial.availableForWrite()); }
+
+} // namespace firmware
+
+#endif // ARDUINO
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <type_traits>
+
+#ifndef ARDUINO
+#include <stdio.h>
+#endif
+
+/*
+ * Where log output goes. A sink is any object with put(char) and write(const char*, size_t);
+ * it may add room(), the bytes it takes without waiting, which the async logger's poll() keeps
+ * to. log_to<a, b, ...> sends everything to each of the sink objects named, every call resolved
+ * at compile time: no vtable, no function pointer, and one sink costs what calling it directly
+ * costs.
+ *
+ * The logger writes to firmware::log_output, log_to<serial_out> unless the build names a header
+ * declaring another, -DFIRMWARE_LOG_SINKS_HEADER='"log_sinks.hpp"':
+ *
+ *     #include <arduino/logger/log_sink.hpp>
+ *     extern firmware::ram_sink<256> crash_log; // FIRMWARE_NOINIT, defined once in a .cpp
+ *     namespace firmware { using log_output = log_to<serial_out, crash_log>; }
+ *
+ * Sinks:
+ * - serial_sink, the UART through Serial (Arduino)
+ * - ram_sink<N>, the last N bytes in RAM; placed in .noinit it survives a watchdog or other warm
+ *   reset, for a post-mortem log read back at the next start
+ * - file_sink, a stdio stream, stdout by default (native)
+ */
+
+/// @brief a variable the C runtime leaves alone at start, kept over a warm reset (AVR)
+#ifdef __AVR__
+#define FIRMWARE_NOINIT __attribute__((section(".noinit")))
+#else
+#define FIRMWARE_NOINIT
+#endif
+
+namespace firmware {
+
+namespace __details {
+template <typename S, typename = void> struct __sink_has_room : msd::false_type {};
+template <typename S> struct __sink_has_room<S, msd::void_t<decltype(msd::declval<S&>().room())>> : msd::true_type {};
+} // namespace __details
+
+/// @brief the sink objects Sinks..., written to one after the other
+template <auto&... Sinks>
+struct log_to {
+    static_assert(sizeof...(Sinks) >= 1, "at least one sink");
+
+    static void put(char c) { (Sinks.put(c), ...); }
+    static void write(const char* str, size_t len) { (Sinks.write(str, len), ...); }
+
+    /// @brief bytes every sink takes without waiting: the least room() of those that have one
+    static size_t room() {
+        size_t least = ~static_cast<size_t>(0);
+        (room_of(Sinks, least), ...);
+        return least;
+    }
+
+    private:
+    template <typename S>
+    static void room_of(S& sink, size_t& least) {
+        if constexpr (__details::__sink_has_room<S>::value) {
+            size_t r = static_cast<size_t>(sink.room());
+            if (r < least) least = r;
+        }
+    }
+};
+
+/// @brief the last N bytes logged, oldest overwritten first. Trivial, so that it can sit in
+/// .noinit: call begin() once at start, which keeps what a warm reset left or clears garbage.
+template <size_t N>
+class ram_sink {
+    static_assert(N >= 16 && N <= 0x8000 && (N & (N - 1)) == 0, "N must be a power of two, 16 to 32768");
+
+    private:
+    static constexpr uint16_t magic = 0x10C5;
+
+    uint16_t m_magic;
+    uint16_t m_head;  // where the next byte goes
+    uint16_t m_used;  // bytes held, up to N
+    uint16_t m_check; // m_head ^ m_used ^ ~magic, so that noise is not taken for a log
+    char m_data[N];
+
+    void seal() noexcept { m_check = static_cast<uint16_t>(m_head ^ m_used ^ static_cast<uint16_t>(~magic)); }
+
+    public:
+    static constexpr size_t capacity = N;
+
+    /// @brief true if a log from before a warm reset is still here; otherwise starts empty
+    bool begin() noexcept {
+        if (m_magic == magic && m_used <= N && m_head < N && m_check == static_cast<uint16_t>(m_head ^ m_used ^ static_cast<uint16_t>(~magic)))
+            return m_used != 0;
+        clear();
+        return false;
+    }
+
+    void clear() noexcept {
+        m_magic = magic, m_head = 0, m_used = 0;
+        seal();
+    }
+
+    void put(char c) noexcept {
+        m_data[m_head & (N - 1)] = c;
+        m_head                   = static_cast<uint16_t>((m_head + 1) & (N - 1));
+        if (m_used < N) m_used++;
+        seal();
+    }
+
+    void write(const char* str, size_t len) noexcept {
+        if (len > N) str += len - N, len = N; // only the end of it stays anyway
+        uint16_t head  = m_head & (N - 1);
+        size_t first   = N - head < len ? N - head : len;
+        memcpy(m_data + head, str, first);
+        memcpy(m_data, str + first, len - first);
+        m_head = static_cast<uint16_t>((head + len) & (N - 1));
+        m_used = static_cast<uint16_t>(m_used + len > N ? N : m_used + len);
+        seal();
+    }
+
+    size_t size() const noexcept { return m_used; }
+
+    /// @brief the bytes held, oldest first, into another sink: after a reset, to the UART
+    template <typename Sink>
+    void dump(Sink& out) const {
+        size_t start = (m_head - m_used) & (N - 1);
+        size_t first = N - start < m_used ? N - start : m_used;
+        out.write(m_data + start, first);
+        if (m_used > first) out.write(m_data, m_used - first);
+    }
+};
+
+#ifdef ARDUINO
+/// @brief the UART, through the core's Serial
+struct serial_sink {
+    void put(char c);
+    void write(const char* str, size_t len);
+    size_t room();
+};
+
+inline serial_sink serial_out;
+#else
+/// @brief a stdio stream, stdout unless given one
+class file_sink {
+    private:
+    FILE* m_file;
+
+    public:
+    explicit file_sink(FILE* file = stdout) noexcept : m_file(file) {}
+
+    void put(char c) { fputc(c, m_file); }
+    void write(const char* str, size_t len) { fwrite(str, 1, len, m_file); }
+    void flush() { fflush(m_file); }
+};
+
+inline file_sink stdout_out;
+#endif
+
+} // namespace firmware
+
+#ifdef FIRMWARE_LOG_SINKS_HEADER
+#include FIRMWARE_LOG_SINKS_HEADER
+#else
+namespace firmware {
+#ifdef ARDUINO
+using log_output = log_to<serial_out>;
+#else
+using log_output = log_to<stdout_out>;
+#endif
+} // namespace firmware
+#endif
@@ -1,17 +1,33 @@
 #include "logger.hpp"
 
+#include <flash>
+
+#ifdef ARDUINO
 #include <Arduino.h>
+#endif
 
 namespace firmware {
 
+#ifdef ARDUINO
 namespace __details {
 template <> struct is_flash_string<const __FlashStringHelper*> : msd::true_type {};
 } // namespace __details
+#endif
+
+namespace {
+#ifdef ARDUINO
+uint32_t default_clock() { return millis(); }
+#else
+uint32_t default_clock() { return 0; } // native: no time until set_clock() gives one
+#endif
+} // namespace
 
 logger::logger() noexcept
 : m_baud_rate(BaudRate::BAUD_9600),
   m_level(Level::INFO),
-  m_is_initialized(false) {}
+  m_is_initialized(false),
+  m_async(false),
+  m_clock(&default_clock) {}
 
 void logger::init(uint32_t br, Level level) {
     if (m_is_initialized == true) return;
@@ -19,16 +35,20 @@ void logger::init(uint32_t br, Level level) {
     m_baud_rate = br;
     m_level     = level;
 
+#ifdef ARDUINO
     Serial.begin(br);
     delay(50);
+#endif
 
     m_is_initialized = true;
 
-    info(F("========================="));
-    info(F("Serial Logger initialized"));
-    info("Baud Rate: %lu", (m_baud_rate));
-    info("Level: %s", level_to_string(level));
-    info(F("========================="));
+    // _fmt text stays in flash on AVR, as F() would
+    using namespace msd::literals;
+    info("========================="_fmt);
+    info("Serial Logger initialized"_fmt);
+    info("Baud Rate: {}"_fmt, m_baud_rate);
+    info("Level: {}"_fmt, level_to_string(level));
+    info("========================="_fmt);
 }
 
 void logger::log_impl(Level level, const char* str) {
@@ -36,44 +56,96 @@ void logger::log_impl(Level level, const char* str) {
 }
 
 void logger::log_impl(Level level, const void* flash_str) {
-    const __FlashStringHelper* fsh = reinterpret_cast<const __FlashStringHelper*>(flash_str);
-    char buf[64];
-    strncpy_P(buf, (const char*)fsh, sizeof(buf) - 1);
-    buf[sizeof(buf) - 1] = '\0';
-    log_str(level, buf);
+    if (m_is_initialized == false || !is_enabled(level, m_level)) return;
+    line_sink sink;
+    if (m_filter.drop(sink, log_key(flash_str, level), clock())) return;
+    // straight out of flash, no copy
+    const char* p = reinterpret_cast<const char*>(flash_str);
+    sink.begin_line(level);
+    for (char c; (c = msd::flash_load(p)) != '\0'; p++) sink.put(c);
+    sink.end_line();
 }
 
 void logger::log_str(Level level, const char* str) {
-    if (m_is_initialized == false) return;
-    if (m_level < level) return;
-
-    // print time stamp
-    print_time_stamp();
-    // print level
-    print_level(level);
-    // print message
-    Serial.print(str);
-    Serial.print('\n');
+    if (m_is_initialized == false || !is_enabled(level, m_level)) return;
+    line_sink sink;
+    if (m_filter.drop(sink, log_key(nullptr, level, str), clock())) return;
+    sink.begin_line(level);
+    sink.write(str, strlen(str));
+    sink.end_line();
+}
+
+void logger::line_sink::put(char c) {
+    if (!m_async) return log_output::put(c);
+    // the last byte is kept for the '\n'
+    if (m_len < sizeof(m_text) - 1) m_text[m_len++] = c;
+}
+
+void logger::line_sink::write(const char* str, size_t len) {
+    if (!m_async) return log_output::write(str, len);
+    size_t room = sizeof(m_text) - 1 - m_len;
+    if (len > room) len = room;
+    for (size_t i = 0; i < len; i++) m_text[m_len + i] = str[i];
+    m_len = static_cast<uint8_t>(m_len + len);
+}
+
+void logger::line_sink::begin_line(Level level) {
+    // [s.ms][LEVEL]
+    using namespace msd::literals;
+    m_len = 0;
+    char time[16];
+    time[0]   = '[';
+    char* end = msd::to_chars_fixed(time + 1, time + sizeof(time), instance().clock(), 3).ptr;
+    write(time, static_cast<size_t>(end - time));
+    msd::format(*this, "][{}]"_fmt, level_to_string(level));
+}
+
+void logger::line_sink::end_line() {
+    if (!m_async) return log_output::put('\n');
+    m_text[m_len++] = '\n';
+    instance().m_buffer.write(m_text, m_len);
+}
+
+void logger::set_coalesce(bool coalesce) {
+    line_sink sink;
+    m_filter.set_coalesce(sink, coalesce);
+}
+
+bool logger::send_frame(const log_frame& frame) {
+    if (m_async) return m_buffer.write(reinterpret_cast<const char*>(frame.data()), frame.size());
+    log_output::write(reinterpret_cast<const char*>(frame.data()), frame.size());
+    return true;
+}
+
+void logger::set_async(bool async, LogOverflow policy) noexcept {
+    if (!async) flush();
+    m_buffer.set_policy(policy, &logger::drain_wait);
+    m_async = async;
+}
+
+void logger::poll() {
+    char chunk[16];
+    size_t room = log_output::room();
+    while (room > 0) {
+        size_t n = m_buffer.read(chunk, room < sizeof(chunk) ? room : sizeof(chunk));
+        if (n == 0) break;
+        log_output::write(chunk, n);
+        room -= n;
+    }
 }
 
-void logger::print_level(Level level) {
-    Serial.print('[');
-    Serial.print(level_to_string(level));
-    Serial.print(']');
+void logger::flush() {
+    line_sink sink;
+    m_filter.flush(sink);
+    while (!m_buffer.empty()) drain_wait();
 }
 
-void logger::print_time_stamp() {
-    // [s.ms]
-    unsigned long time = millis();
-    unsigned long ms   = time % 1000;
-    unsigned long s    = time / 1000;
-    Serial.print('[');
-    Serial.print(s);
-    Serial.print('.');
-    if (ms < 100) Serial.print("0");
-    if (ms < 10) Serial.print("0");
-    Serial.print(ms);
-    Serial.print(']');
+void logger::drain_wait() {
+    // a chunk even when the sinks are full: the serial sink waits on the UART, which is the
+    // progress BLOCK asks for
+    char chunk[16];
+    size_t n = instance().m_buffer.read(chunk, sizeof(chunk));
+    if (n) log_output::write(chunk, n);
 }
 
 const char* logger::level_to_string(Level level) {
@@ -87,4 +159,4 @@ const char* logger::level_to_string(Level level) {
     }
 }
 
-} // namespace firmware
\ No newline at end of file
+} // namespace firmware
@@ -2,10 +2,25 @@
 
 #include <stddef.h>
 
+#include <format>
 #include <singleton>
 #include <type_traits>
 
 #include "../serial/serial.hpp"
+#include "log_binary.hpp"
+#include "log_buffer.hpp"
+#include "log_level.hpp"
+#include "log_limit.hpp"
+#include "log_sink.hpp"
+
+#ifndef FIRMWARE_LOG_BUFFER
+#define FIRMWARE_LOG_BUFFER 128
+#endif
+
+// longest async text line, prefix and '\n' included; a longer one is cut
+#ifndef FIRMWARE_LOG_LINE
+#define FIRMWARE_LOG_LINE 80
+#endif
 
 namespace firmware {
 
@@ -16,15 +31,6 @@ extern "C" int snprintf(char* str, size_t size, const char* format, ...);
 template <typename T> struct is_flash_string : msd::false_type {};
 } // namespace __details
 
-enum class Level {
-    DEBUG   = 4,
-    INFO    = 3,
-    WARN    = 2,
-    ERROR   = 1,
-    FATAL   = 0,
-    DISABLE = -1,
-};
-
 struct BaudRate {
     static constexpr uint32_t BAUD_300    = 300;
     static constexpr uint32_t BAUD_1200   = 1200;
@@ -45,6 +51,10 @@ class logger : public msd::singleton<logger> {
     uint32_t m_baud_rate;
     Level m_level;
     bool m_is_initialized;
+    bool m_async;
+    log_filter m_filter;
+    log_buffer<FIRMWARE_LOG_BUFFER> m_buffer;
+    uint32_t (*m_clock)();
 
     logger() noexcept;
     ~logger() noexcept               = default;
@@ -62,51 +72,164 @@ class logger : public msd::singleton<logger> {
 
     // control
     void set_level(Level level) noexcept { m_level = level; }
-
-    // log
+    /// @brief the milliseconds time stamps and repeat windows run on, millis() by default;
+    /// natively none until one is set
+    void set_clock(uint32_t (*now)()) noexcept { m_clock = now; }
+
+    // output goes to log_output, the sinks chosen at compile time, see log_sink.hpp
+    // async: log calls queue whole lines in a ring buffer and return, poll() feeds them to the sinks.
+    // A line is built on the stack, up to FIRMWARE_LOG_LINE characters, and queued in one step,
+    // so an ISR may log in async mode without tearing the line it interrupted; coalescing and
+    // FIRMWARE_LOG_LIMITED keep main loop state and BLOCK waits on the UART, keep them out of
+    // ISRs. Synchronous logging from an ISR is unsupported.
+    void set_async(bool async, LogOverflow policy = LogOverflow::DROP_NEWEST) noexcept;
+    bool is_async() const noexcept { return m_async; }
+    /// @brief move queued bytes into the sinks as far as they have room (Serial's TX buffer),
+    /// never waits; call it from loop() or an idle hook, Serial's TX-empty ISR sends them on
+    void poll();
+    /// @brief send everything queued, waiting on the UART
+    void flush();
+    /// @brief messages lost to a full buffer
+    uint16_t dropped() const noexcept { return m_buffer.dropped(); }
+
+    /// @brief count a message equal to the one before instead of sending it again, off by
+    /// default; see log_limit.hpp
+    void set_coalesce(bool coalesce);
+    bool is_coalescing() const noexcept { return m_filter.is_coalescing(); }
+
+    // log: a call below FIRMWARE_LOG_LEVEL compiles to nothing, see log_level.hpp
     template <typename T>
     void log(Level level, T str) {
+        if (!is_compiled(level)) return;
         log_impl(level, str);
     }
 
+    /// @brief a message formatted by msd::format straight into the sinks or the async buffer:
+    /// log(Level::INFO, "axis {} at {:.2}"_fmt, axis, pos), no printf, and no length limit but
+    /// FIRMWARE_LOG_LINE when async
+    template <char... Cs, typename... Args>
+    void log(Level level, msd::fmt_string<Cs...> fmt, Args... args) {
+        if (m_is_initialized == false || !is_enabled(level, m_level)) return;
+        line_sink sink;
+        m_filter.line(sink, clock(), level, fmt, args...);
+    }
+
+    /// @brief log() from one call site, at most as often as rate lets it; what
+    /// FIRMWARE_LOG_LIMITED expands to, see log_limit.hpp
+    template <typename Rate, char... Cs, typename... Args>
+    void log_limited(Rate& rate, Level level, msd::fmt_string<Cs...> fmt, Args... args) {
+        if (m_is_initialized == false || !is_enabled(level, m_level)) return;
+        line_sink sink;
+        m_filter.limited(sink, rate, clock(), level, fmt, args...);
+    }
+
+    /// @brief printf formatting, kept for formats only known at run time; it links vfprintf
+    /// and cuts messages at 63 characters, prefer the _fmt overload
     template <typename... Args>
     void log(Level level, const char* fmt, Args... args) {
+        // the level first: a message that is not sent is not formatted either
+        if (m_is_initialized == false || !is_enabled(level, m_level)) return;
         char buf[64] = {};
         __details::snprintf(buf, sizeof(buf), fmt, args...);
         log_str(level, buf);
     }
 
+    /// @brief one binary frame, what FIRMWARE_LOG_BIN expands to; see log_binary.hpp
+    template <uint32_t Kinds, uint16_t Id, typename... Args>
+    void log_binary(Level level, Args... args) {
+        if (m_is_initialized == false || !is_enabled(level, m_level)) return;
+        log_frame frame;
+        if (frame.encode<Kinds>(static_cast<uint8_t>(level), Id, clock(), args...)) send_frame(frame);
+    }
+
     template <typename T>
-    void debug(T str) { log(Level::DEBUG, str); }
+    __attribute__((always_inline)) void debug(T str) {
+        if constexpr (is_compiled(Level::DEBUG)) log(Level::DEBUG, str);
+    }
     template <typename T>
-    void info(T str) { log(Level::INFO, str); }
+    __attribute__((always_inline)) void info(T str) {
+        if constexpr (is_compiled(Level::INFO)) log(Level::INFO, str);
+    }
     template <typename T>
-    void warn(T str) { log(Level::WARN, str); }
+    __attribute__((always_inline)) void warn(T str) {
+        if constexpr (is_compiled(Level::WARN)) log(Level::WARN, str);
+    }
     template <typename T>
-    void error(T str) { log(Level::ERROR, str); }
+    __attribute__((always_inline)) void error(T str) {
+        if constexpr (is_compiled(Level::ERROR)) log(Level::ERROR, str);
+    }
     template <typename T>
-    void fatal(T str) { log(Level::FATAL, str); }
+    __attribute__((always_inline)) void fatal(T str) {
+        if constexpr (is_compiled(Level::FATAL)) log(Level::FATAL, str);
+    }
 
     template <typename... Args>
-    void debug(const char* fmt, Args... args) { log(Level::DEBUG, fmt, args...); }
+    __attribute__((always_inline)) void debug(const char* fmt, Args... args) {
+        if constexpr (is_compiled(Level::DEBUG)) log(Level::DEBUG, fmt, args...);
+    }
     template <typename... Args>
-    void info(const char* fmt, Args... args) { log(Level::INFO, fmt, args...); }
+    __attribute__((always_inline)) void info(const char* fmt, Args... args) {
+        if constexpr (is_compiled(Level::INFO)) log(Level::INFO, fmt, args...);
+    }
     template <typename... Args>
-    void warn(const char* fmt, Args... args) { log(Level::WARN, fmt, args...); }
+    __attribute__((always_inline)) void warn(const char* fmt, Args... args) {
+        if constexpr (is_compiled(Level::WARN)) log(Level::WARN, fmt, args...);
+    }
     template <typename... Args>
-    void error(const char* fmt, Args... args) { log(Level::ERROR, fmt, args...); }
+    __attribute__((always_inline)) void error(const char* fmt, Args... args) {
+        if constexpr (is_compiled(Level::ERROR)) log(Level::ERROR, fmt, args...);
+    }
     template <typename... Args>
-    void fatal(const char* fmt, Args... args) { log(Level::FATAL, fmt, args...); }
+    __attribute__((always_inline)) void fatal(const char* fmt, Args... args) {
+        if constexpr (is_compiled(Level::FATAL)) log(Level::FATAL, fmt, args...);
+    }
+
+    template <char... Cs, typename... Args>
+    __attribute__((always_inline)) void debug(msd::fmt_string<Cs...> fmt, Args... args) {
+        if constexpr (is_compiled(Level::DEBUG)) log(Level::DEBUG, fmt, args...);
+    }
+    template <char... Cs, typename... Args>
+    __attribute__((always_inline)) void info(msd::fmt_string<Cs...> fmt, Args... args) {
+        if constexpr (is_compiled(Level::INFO)) log(Level::INFO, fmt, args...);
+    }
+    template <char... Cs, typename... Args>
+    __attribute__((always_inline)) void warn(msd::fmt_string<Cs...> fmt, Args... args) {
+        if constexpr (is_compiled(Level::WARN)) log(Level::WARN, fmt, args...);
+    }
+    template <char... Cs, typename... Args>
+    __attribute__((always_inline)) void error(msd::fmt_string<Cs...> fmt, Args... args) {
+        if constexpr (is_compiled(Level::ERROR)) log(Level::ERROR, fmt, args...);
+    }
+    template <char... Cs, typename... Args>
+    __attribute__((always_inline)) void fatal(msd::fmt_string<Cs...> fmt, Args... args) {
+        if constexpr (is_compiled(Level::FATAL)) log(Level::FATAL, fmt, args...);
+    }
 
 
     private:
+    /// where a line goes while it is written: straight to the sinks, or when async into m_text,
+    /// queued whole by end_line()
+    struct line_sink {
+        bool m_async;
+        uint8_t m_len;
+        char m_text[FIRMWARE_LOG_LINE];
+
+        line_sink() noexcept : m_async(instance().m_async), m_len(0) {}
+        void put(char c);
+        void write(const char* str, size_t len);
+        void begin_line(Level level);
+        void end_line();
+    };
+    static_assert(FIRMWARE_LOG_LINE >= 32 && FIRMWARE_LOG_LINE <= 255, "FIRMWARE_LOG_LINE must be 32 to 255");
+
     void log_str(Level level, const char* str);
+    static void drain_wait();
+    bool send_frame(const log_frame& frame);
+    uint32_t clock() const { return m_clock(); }
 
     void log_impl(Level level, const char* str);
     void log_impl(Level level, const void* flash_str);
 
-    static void print_level(Level level);
-    static void print_time_stamp();
     static const char* level_to_string(Level level);
 };
 } // namespace firmware
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ring_buffer>
+
+#include "pin_group.hpp"
+
+namespace firmware {
+
+/// a debounced change of one input, index is the pin's place in the debouncer's list
+struct button_event {
+    uint8_t index;
+    bool pressed;
+};
+
+namespace __details {
+/*
+ * Eight 2-bit counters side by side: bit i of c0 and c1 is the counter of input i. A counter
+ * runs while its input differs from the debounced state and resets as soon as they agree, so
+ * an input must read the same for 4 samples in a row to change state. A whole byte of inputs
+ * costs a handful of logic operations, whatever the number of pins.
+ */
+struct __vertical_counter {
+    uint8_t state = 0;
+    uint8_t c0    = 0;
+    uint8_t c1    = 0;
+
+    /// @brief feed one sample, returns the bits whose debounced state flipped
+    __attribute__((always_inline)) uint8_t update(uint8_t sample) noexcept {
+        uint8_t delta   = sample ^ state;
+        c1              = static_cast<uint8_t>((c1 ^ c0) & delta);
+        c0              = static_cast<uint8_t>(~c0 & delta);
+        uint8_t toggled = static_cast<uint8_t>(delta & ~(c0 | c1));
+        state ^= toggled;
+        return toggled;
+    }
+};
+} // namespace __details
+
+/*
+ * Up to 8 inputs debounced together from a periodic ISR.
+ *
+ * tick() reads every pin at once through pin_group, runs the vertical counters and queues a
+ * button_event for each input whose debounced state changed; the main loop takes them with
+ * poll(). An input is "pressed" when it is at its active level: low for INPUT_PULLUP pins,
+ * high otherwise. A change needs 4 equal ticks, so a 1 kHz tick rejects bounces up to 3 ms and
+ * reports a press 4 ms after it settles, with no delay() anywhere.
+ *
+ * tick() is the producer and poll() the consumer of the event ring, one ISR and one loop.
+ */
+template <size_t Events, typename... Pins>
+class basic_debouncer {
+    static_assert(sizeof...(Pins) > 0 && sizeof...(Pins) <= 8, "1 to 8 inputs");
+
+    using group = pin_group<Pins...>;
+
+    /// inputs that read low when pressed
+    static constexpr uint8_t m_active_low = static_cast<uint8_t>(group::template bits_where<PinMode::INPUT_PULLUP>());
+
+    private:
+    __details::__vertical_counter m_counter;
+    msd::ring_buffer<uint8_t, Events> m_events;
+    volatile uint8_t m_dropped;
+
+    __attribute__((always_inline)) uint8_t sample() const noexcept {
+        return static_cast<uint8_t>(group::read() ^ m_active_low);
+    }
+
+    /// the debounced state as tick() left it: a volatile read, so that a loop waiting on
+    /// pressed() reads it again on every pass while the ISR keeps the counter plain
+    uint8_t state() const noexcept { return *static_cast<const volatile uint8_t*>(&m_counter.state); }
+
+    public:
+    static constexpr size_t size = sizeof...(Pins);
+
+    basic_debouncer() noexcept : m_dropped(0) {}
+
+    /// @brief configure the pins and take their current levels as settled, no events for them
+    void init() noexcept {
+        group::init();
+        m_counter.state = sample();
+        m_counter.c0 = m_counter.c1 = 0;
+    }
+
+    /// @brief one sample of every input, from the periodic ISR
+    void tick() noexcept {
+        uint8_t toggled = m_counter.update(sample());
+        if (!toggled) return;
+        uint8_t state = m_counter.state;
+        for (uint8_t i = 0; toggled; i++, toggled >>= 1) {
+            if (!(toggled & 1)) continue;
+            uint8_t e = static_cast<uint8_t>(i | ((state >> i) & 1) << 7);
+            if (!m_events.push(e)) m_dropped = static_cast<uint8_t>(m_dropped + 1);
+        }
+    }
+
+    /// @brief take the oldest event, false when there is none
+    bool poll(button_event& e) noexcept {
+        uint8_t v;
+        if (!m_events.pop(v)) return false;
+        e.index   = v & 0x07;
+        e.pressed = v & 0x80;
+        return true;
+    }
+
+    /// @brief debounced state, bit i set while input i is pressed
+    uint8_t pressed() const noexcept { return state(); }
+    bool pressed(uint8_t index) const noexcept { return (state() >> index) & 1; }
+
+    /// @brief events lost to a full queue
+    uint8_t dropped() const noexcept { return m_dropped; }
+};
+
+template <typename... Pins>
+using debouncer = basic_debouncer<16, Pins...>;
+
+} // namespace firmware
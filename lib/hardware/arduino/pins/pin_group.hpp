@@ -0,0 +1,227 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+#include "pins.hpp"
+
+namespace firmware {
+
+/*
+ * Several firmware::pins written as one value: bit i of the value drives the i-th pin of the list.
+ *
+ * The masks of each port are worked out at compile time, so a write costs one read-modify-write
+ * of PORTx per port the group touches (one store when the group owns the whole port), and the
+ * pins of one port change on the same cycle instead of passing through the states in between.
+ * Pins on different ports change a few cycles apart, PORTB, then PORTC, then PORTD.
+ *
+ * The read-modify-write loses an ISR's change to another pin of the same port if the ISR runs in
+ * between; use the *_atomic variants when ISRs write to those ports. toggle() is a single store
+ * to PINx and is always safe.
+ *
+ * Like pins::dwrite(), write(), set() and clear() detach the timer from the PWM pins they drive
+ * (D3, D5, D6, D9, D10, D11), or a pin analogWrite() set up would keep following the timer. A
+ * group without such pins pays nothing for it. toggle() stays a single store and leaves PWM alone.
+ */
+template <typename... Pins>
+class pin_group {
+    static_assert(sizeof...(Pins) > 0 && sizeof...(Pins) <= 16, "1 to 16 pins");
+    static_assert((__details::__has_port(Pins::number) && ...), "every pin must be on PORTB, PORTC or PORTD");
+
+    private:
+    static constexpr uint8_t m_pin[] = { Pins::number... };
+
+    /// mask of pin I on the port whose PINx is at PINR, 0 when it is elsewhere
+    template <uint8_t PINR, size_t I>
+    static constexpr uint8_t m_on = __details::__pin_register(m_pin[I]) == PINR ? __details::__pin_mask(m_pin[I]) : 0;
+
+    template <uint8_t PINR, size_t... I>
+    static constexpr uint8_t port_mask(msd::index_sequence<I...>) noexcept {
+        return static_cast<uint8_t>((0 | ... | m_on<PINR, I>));
+    }
+
+    /// shift taking the value's bits to the port's bits when every pin of the port keeps its order, 99 otherwise
+    template <uint8_t PINR, size_t... I>
+    static constexpr int port_shift(msd::index_sequence<I...>) noexcept {
+        int shift = 99;
+        bool ok   = true;
+        auto check = [&](size_t i, uint8_t mask) {
+            if (!mask) return;
+            int s = 0;
+            while ((1 << s) != mask) s++;
+            s -= static_cast<int>(i);
+            if (shift == 99) shift = s;
+            else if (shift != s) ok = false;
+        };
+        (check(I, m_on<PINR, I>), ...);
+        return ok ? shift : 99;
+    }
+
+    using indices = msd::make_index_sequence<sizeof...(Pins)>;
+
+    template <uint8_t PINR>
+    static constexpr uint8_t m_mask = port_mask<PINR>(indices{});
+    template <uint8_t PINR>
+    static constexpr int m_shift = port_shift<PINR>(indices{});
+
+    /// bits of PORTx for value v
+    template <uint8_t PINR, size_t... I>
+    __attribute__((always_inline)) static uint8_t port_bits(uint16_t v, msd::index_sequence<I...>) noexcept {
+        constexpr int shift = m_shift<PINR>;
+        if constexpr (shift == 99) {
+            return static_cast<uint8_t>((0 | ... | (((v >> I) & 1) ? m_on<PINR, I> : 0)));
+        } else if constexpr (shift >= 0) {
+            return static_cast<uint8_t>((v << shift) & m_mask<PINR>);
+        } else {
+            return static_cast<uint8_t>((v >> -shift) & m_mask<PINR>);
+        }
+    }
+
+    template <uint8_t PINR>
+    __attribute__((always_inline)) static void write_port(uint16_t v) noexcept {
+        constexpr uint8_t mask = m_mask<PINR>;
+        if constexpr (mask == 0xFF) {
+            __details::__reg_write<PINR + 2>(port_bits<PINR>(v, indices{}));
+        } else if constexpr (mask != 0) {
+            uint8_t bits = port_bits<PINR>(v, indices{});
+            __details::__reg_write<PINR + 2>(static_cast<uint8_t>((__details::__reg_read<PINR + 2>() & ~mask) | bits));
+        }
+    }
+
+    template <uint8_t PINR, bool HIGH>
+    __attribute__((always_inline)) static void update_port(uint16_t v) noexcept {
+        if constexpr (m_mask<PINR> != 0) {
+            uint8_t bits = port_bits<PINR>(v, indices{});
+            uint8_t now  = __details::__reg_read<PINR + 2>();
+            __details::__reg_write<PINR + 2>(static_cast<uint8_t>(HIGH ? now | bits : now & ~bits));
+        }
+    }
+
+    /// COMnx1 bit of pin I if it is a PWM pin of the timer whose TCCRnA is at TCCR, 0 otherwise
+    template <uint8_t TCCR, size_t I>
+    static constexpr uint8_t m_com = __details::__pwm_register(m_pin[I]) == TCCR ? __details::__pwm_mask(m_pin[I]) : 0;
+
+    /// COMnx1 bits of the pins whose bit is set in v
+    template <uint8_t TCCR, size_t... I>
+    __attribute__((always_inline)) static uint8_t com_bits(uint16_t v, msd::index_sequence<I...>) noexcept {
+        return static_cast<uint8_t>((0 | ... | (((v >> I) & 1) ? m_com<TCCR, I> : 0)));
+    }
+
+    template <uint8_t TCCR, size_t... I>
+    static constexpr bool has_pwm(msd::index_sequence<I...>) noexcept {
+        return (0 | ... | m_com<TCCR, I>) != 0;
+    }
+
+    /// disconnect the timer from the PWM pins whose bit is set in v, as dwrite() does
+    template <uint8_t TCCR>
+    __attribute__((always_inline)) static void detach_port(uint16_t v) noexcept {
+        if constexpr (has_pwm<TCCR>(indices{})) {
+            uint8_t bits = com_bits<TCCR>(v, indices{});
+            if (bits) __details::__reg_clear<TCCR>(bits);
+        }
+    }
+
+    __attribute__((always_inline)) static void detach(uint16_t v) noexcept {
+        detach_port<__details::TCCR0A_ADDR>(v);
+        detach_port<__details::TCCR1A_ADDR>(v);
+        detach_port<__details::TCCR2A_ADDR>(v);
+    }
+
+    template <uint8_t PINR>
+    __attribute__((always_inline)) static void toggle_port(uint16_t v) noexcept {
+        if constexpr (m_mask<PINR> != 0) __details::__reg_write<PINR>(port_bits<PINR>(v, indices{}));
+    }
+
+    template <uint8_t PINR>
+    __attribute__((always_inline)) static void read_port(uint16_t& v) noexcept {
+        if constexpr (m_mask<PINR> != 0) {
+            uint8_t in = __details::__reg_read<PINR>();
+            v          = static_cast<uint16_t>(v | gather<PINR>(in, indices{}));
+        }
+    }
+
+    template <uint8_t PINR, size_t... I>
+    __attribute__((always_inline)) static uint16_t gather(uint8_t in, msd::index_sequence<I...>) noexcept {
+        return static_cast<uint16_t>((0 | ... | ((in & m_on<PINR, I>) ? (1u << I) : 0u)));
+    }
+
+    public:
+    static constexpr size_t size = sizeof...(Pins);
+
+    /// every pin's mask on PORTB, PORTC and PORTD
+    static constexpr uint8_t mask_b = m_mask<__details::PINB_ADDR>;
+    static constexpr uint8_t mask_c = m_mask<__details::PINC_ADDR>;
+    static constexpr uint8_t mask_d = m_mask<__details::PIND_ADDR>;
+
+    /// value bits of the pins configured as M
+    template <PinMode M>
+    static constexpr uint16_t bits_where() noexcept {
+        uint16_t v = 0, bit = 1;
+        ((v = static_cast<uint16_t>(Pins::mode == M ? v | bit : v), bit = static_cast<uint16_t>(bit << 1)), ...);
+        return v;
+    }
+
+    static void init() noexcept { (Pins::init(), ...); }
+
+    /// @brief drive every pin from the bits of v
+    __attribute__((always_inline)) static void write(uint16_t v) noexcept {
+        detach(0xFFFF);
+        write_port<__details::PINB_ADDR>(v);
+        write_port<__details::PINC_ADDR>(v);
+        write_port<__details::PIND_ADDR>(v);
+    }
+
+    /// @brief drive high the pins whose bit is set in v, leave the others
+    __attribute__((always_inline)) static void set(uint16_t v) noexcept {
+        detach(v);
+        update_port<__details::PINB_ADDR, true>(v);
+        update_port<__details::PINC_ADDR, true>(v);
+        update_port<__details::PIND_ADDR, true>(v);
+    }
+
+    /// @brief drive low the pins whose bit is set in v, leave the others
+    __attribute__((always_inline)) static void clear(uint16_t v) noexcept {
+        detach(v);
+        update_port<__details::PINB_ADDR, false>(v);
+        update_port<__details::PINC_ADDR, false>(v);
+        update_port<__details::PIND_ADDR, false>(v);
+    }
+
+    /// @brief flip the pins whose bit is set in v, a single store per port
+    __attribute__((always_inline)) static void toggle(uint16_t v) noexcept {
+        toggle_port<__details::PINB_ADDR>(v);
+        toggle_port<__details::PINC_ADDR>(v);
+        toggle_port<__details::PIND_ADDR>(v);
+    }
+
+    /// @brief input levels, bit i for the i-th pin
+    __attribute__((always_inline)) static uint16_t read() noexcept {
+        uint16_t v = 0;
+        read_port<__details::PINB_ADDR>(v);
+        read_port<__details::PINC_ADDR>(v);
+        read_port<__details::PIND_ADDR>(v);
+        return v;
+    }
+
+    // interrupts masked around the read-modify-write, for ports an ISR also writes
+
+    static void write_atomic(uint16_t v) noexcept {
+        uint8_t sreg = __details::__irq_save();
+        write(v);
+        __details::__irq_restore(sreg);
+    }
+    static void set_atomic(uint16_t v) noexcept {
+        uint8_t sreg = __details::__irq_save();
+        set(v);
+        __details::__irq_restore(sreg);
+    }
+    static void clear_atomic(uint16_t v) noexcept {
+        uint8_t sreg = __details::__irq_save();
+        clear(v);
+        __details::__irq_restore(sreg);
+    }
+};
+
+} // namespace firmware
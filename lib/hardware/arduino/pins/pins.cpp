@@ -1,3 +1,5 @@
+#ifdef ARDUINO
+
 #include "pins.hpp"
 
 #include <Arduino.h>
@@ -26,3 +28,5 @@ uint16_t __details::__analog_read(uint8_t p) noexcept {
 
 
 } // namespace firmware
+
+#endif // ARDUINO
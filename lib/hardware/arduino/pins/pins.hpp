@@ -22,9 +22,95 @@ bool __digital_read(uint8_t) noexcept;
 void __analog_write(uint8_t, uint8_t) noexcept;
 uint16_t __analog_read(uint8_t) noexcept;
 
+/*
+ * ATmega328P (Uno) port of each Arduino pin: D0-D7 on PORTD, D8-D13 on PORTB, A0-A5 (14-19)
+ * on PORTC. Registers are given by data-space address; every port has PINx, DDRx and PORTx at
+ * consecutive addresses, all inside the range sbi/cbi/sbic reach. Pins beyond it fall back to
+ * the Arduino calls.
+ */
+constexpr uint8_t PINB_ADDR = 0x23;
+constexpr uint8_t PINC_ADDR = 0x26;
+constexpr uint8_t PIND_ADDR = 0x29;
+
+constexpr bool __has_port(uint8_t pin) noexcept { return pin < 20; }
+constexpr uint8_t __pin_register(uint8_t pin) noexcept { return pin < 8 ? PIND_ADDR : pin < 14 ? PINB_ADDR : PINC_ADDR; }
+constexpr uint8_t __ddr_register(uint8_t pin) noexcept { return __pin_register(pin) + 1; }
+constexpr uint8_t __port_register(uint8_t pin) noexcept { return __pin_register(pin) + 2; }
+constexpr uint8_t __pin_mask(uint8_t pin) noexcept { return uint8_t(1) << (pin < 8 ? pin : pin < 14 ? pin - 8 : pin - 14); }
+
+/*
+ * The timer compare output analogWrite connects to each PWM pin: TCCRnA and its COMnx1 bit.
+ * D6/D5 on Timer0 (OC0A/OC0B), D9/D10 on Timer1, D11/D3 on Timer2; 0 for the other pins.
+ */
+constexpr uint8_t TCCR0A_ADDR = 0x44;
+constexpr uint8_t TCCR1A_ADDR = 0x80;
+constexpr uint8_t TCCR2A_ADDR = 0xB0;
+
+constexpr uint8_t __pwm_register(uint8_t pin) noexcept {
+    return pin == 5 || pin == 6 ? TCCR0A_ADDR : pin == 9 || pin == 10 ? TCCR1A_ADDR : pin == 3 || pin == 11 ? TCCR2A_ADDR : 0;
+}
+constexpr uint8_t __pwm_mask(uint8_t pin) noexcept { return pin == 6 || pin == 9 || pin == 11 ? 0x80 : 0x20; }
+
+#ifdef __AVR__
+template <uint8_t ADDR>
+__attribute__((always_inline)) inline volatile uint8_t& __reg() noexcept {
+    return *reinterpret_cast<volatile uint8_t*>(ADDR);
+}
+
+template <uint8_t ADDR>
+__attribute__((always_inline)) inline void __reg_set(uint8_t mask) noexcept { __reg<ADDR>() |= mask; }
+template <uint8_t ADDR>
+__attribute__((always_inline)) inline void __reg_clear(uint8_t mask) noexcept { __reg<ADDR>() &= static_cast<uint8_t>(~mask); }
+template <uint8_t ADDR>
+__attribute__((always_inline)) inline uint8_t __reg_read() noexcept { return __reg<ADDR>(); }
+/// a one written to PINx toggles the PORTx bit
+template <uint8_t ADDR>
+__attribute__((always_inline)) inline void __reg_write(uint8_t v) noexcept { __reg<ADDR>() = v; }
+
+/// disable interrupts, returns SREG to restore
+__attribute__((always_inline)) inline uint8_t __irq_save() noexcept {
+    uint8_t sreg = __reg<0x5F>();
+    __asm__ __volatile__("cli" ::: "memory");
+    return sreg;
+}
+__attribute__((always_inline)) inline void __irq_restore(uint8_t sreg) noexcept {
+    __asm__ __volatile__("" ::: "memory");
+    __reg<0x5F>() = sreg;
+}
+#else
+/// native stand-in for the I/O registers, indexed by data-space address; tests set PINx to feed inputs
+inline uint8_t io_registers[0x100];
+/// register accesses so far, sbi / cbi count as one write
+inline uint32_t io_reads  = 0;
+inline uint32_t io_writes = 0;
+
+constexpr bool __is_pin_register(uint8_t addr) noexcept { return addr == PINB_ADDR || addr == PINC_ADDR || addr == PIND_ADDR; }
+
+template <uint8_t ADDR>
+inline void __reg_set(uint8_t mask) noexcept { io_registers[ADDR] |= mask, io_writes++; }
+template <uint8_t ADDR>
+inline void __reg_clear(uint8_t mask) noexcept { io_registers[ADDR] &= static_cast<uint8_t>(~mask), io_writes++; }
+template <uint8_t ADDR>
+inline uint8_t __reg_read() noexcept { return io_reads++, io_registers[ADDR]; }
+/// like the hardware, a write to PINx toggles the written bits of PORTx
+template <uint8_t ADDR>
+inline void __reg_write(uint8_t v) noexcept {
+    io_writes++;
+    if (__is_pin_register(ADDR)) io_registers[ADDR + 2] ^= v;
+    else io_registers[ADDR] = v;
+}
+
+inline uint8_t __irq_save() noexcept { return 0; }
+inline void __irq_restore(uint8_t) noexcept {}
+#endif
+
 } // namespace __details
 
 
+/// @brief an Arduino pin bound at compile time
+/// dwrite, dread, toggle and init are single port register accesses (sbi, cbi, sbic, out);
+/// on the six PWM pins dwrite first detaches the timer output awrite may have left running, as
+/// digitalWrite does, one more read-modify-write there and nothing on the other pins
 template <uint8_t PIN, PinMode MODE>
 class pins {
 
@@ -32,6 +118,13 @@ class pins {
     static constexpr uint8_t m_pin  = PIN;
     static constexpr PinMode m_mode = MODE;
 
+    static constexpr bool m_direct  = __details::__has_port(PIN);
+    static constexpr uint8_t m_mask = __details::__pin_mask(PIN);
+    static constexpr uint8_t m_pinr = __details::__pin_register(PIN);
+    static constexpr uint8_t m_ddr  = __details::__ddr_register(PIN);
+    static constexpr uint8_t m_port = __details::__port_register(PIN);
+    static constexpr uint8_t m_pwm  = __details::__pwm_register(PIN); // TCCRnA, 0 for no PWM
+
     pins() noexcept { init(); };
     ~pins() noexcept                      = delete;
     pins(const pins&) noexcept            = delete;
@@ -40,13 +133,25 @@ class pins {
     pins& operator=(pins&&) noexcept      = delete;
 
     public:
+    static constexpr uint8_t number = PIN;
+    static constexpr PinMode mode   = MODE;
+
     __attribute__((always_inline)) static void init() noexcept {
-        __details::__pin_mode(m_pin, static_cast<uint8_t>(m_mode));
+        if constexpr (!m_direct) {
+            __details::__pin_mode(m_pin, static_cast<uint8_t>(m_mode));
+        } else if constexpr (m_mode == PinMode::OUTPUT) {
+            __details::__reg_set<m_ddr>(m_mask);
+        } else {
+            __details::__reg_clear<m_ddr>(m_mask);
+            if constexpr (m_mode == PinMode::INPUT_PULLUP) __details::__reg_set<m_port>(m_mask);
+            else __details::__reg_clear<m_port>(m_mask);
+        }
     }
 
 
     __attribute__((always_inline)) static bool dread() {
-        return __details::__digital_read(m_pin);
+        if constexpr (m_direct) return (__details::__reg_read<m_pinr>() & m_mask) != 0;
+        else return __details::__digital_read(m_pin);
     }
     __attribute__((always_inline)) static uint16_t aread() {
         return __details::__analog_read(m_pin);
@@ -54,10 +159,22 @@ class pins {
 
 
     __attribute__((always_inline)) static void dwrite(bool val) {
-        return __details::__digital_write(m_pin, val);
+        if constexpr (m_direct) {
+            if constexpr (m_pwm != 0) __details::__reg_clear<m_pwm>(__details::__pwm_mask(PIN));
+            if (val) __details::__reg_set<m_port>(m_mask);
+            else __details::__reg_clear<m_port>(m_mask);
+        } else {
+            __details::__digital_write(m_pin, val);
+        }
     }
     __attribute__((always_inline)) static void awrite(uint8_t val) {
         return __details::__analog_write(m_pin, val);
     }
+
+    /// flip the output level
+    __attribute__((always_inline)) static void toggle() {
+        if constexpr (m_direct) __details::__reg_write<m_pinr>(m_mask);
+        else __details::__digital_write(m_pin, !__details::__digital_read(m_pin));
+    }
 };
 } // namespace firmware
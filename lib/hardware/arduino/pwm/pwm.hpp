@@ -0,0 +1,190 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+#include "../pins/pins.hpp"
+
+namespace firmware {
+
+enum class PwmMode : uint8_t {
+    FAST,          // counts up to TOP, twice the frequency for a given resolution
+    PHASE_CORRECT, // counts up and down, pulses stay centred and 0 / TOP give a clean 0 % / 100 %
+};
+
+namespace __details {
+#ifdef F_CPU
+constexpr uint32_t __cpu_frequency = F_CPU;
+#else
+constexpr uint32_t __cpu_frequency = 16000000UL;
+#endif
+
+// TCCRnA_ADDR of the three timers come with pins.hpp, whose dwrite detaches PWM outputs
+// Timer0, also the millis() clock
+constexpr uint8_t OCR0A_ADDR  = 0x47;
+constexpr uint8_t OCR0B_ADDR  = 0x48;
+// Timer1, 16 bits; the high byte of a 16-bit register goes first, through the shared TEMP byte
+constexpr uint8_t TCCR1B_ADDR = 0x81;
+constexpr uint8_t TCNT1_ADDR  = 0x84;
+constexpr uint8_t ICR1_ADDR   = 0x86;
+constexpr uint8_t OCR1A_ADDR  = 0x88;
+constexpr uint8_t OCR1B_ADDR  = 0x8A;
+// Timer2
+constexpr uint8_t TCCR2B_ADDR = 0xB1;
+constexpr uint8_t OCR2A_ADDR  = 0xB3;
+constexpr uint8_t OCR2B_ADDR  = 0xB4;
+
+/// timer driving the output compare unit of a pin, 0xFF when the pin has none
+constexpr uint8_t __pwm_timer(uint8_t pin) noexcept {
+    return pin == 5 || pin == 6 ? 0 : pin == 9 || pin == 10 ? 1 : pin == 3 || pin == 11 ? 2 : 0xFF;
+}
+/// channel A (OCxA) or B (OCxB)
+constexpr bool __pwm_channel_a(uint8_t pin) noexcept { return pin == 6 || pin == 9 || pin == 11; }
+
+template <uint8_t ADDR>
+__attribute__((always_inline)) inline void __reg_write16(uint16_t v) noexcept {
+    __reg_write<ADDR + 1>(static_cast<uint8_t>(v >> 8));
+    __reg_write<ADDR>(static_cast<uint8_t>(v));
+}
+
+/// prescaler and TOP giving hz on Timer1, the finest resolution that fits 16 bits
+struct __timer1_setup {
+    uint8_t cs; // clock select, 0 when hz is out of reach
+    uint16_t top;
+};
+constexpr __timer1_setup __timer1_for(uint32_t hz, PwmMode mode) noexcept {
+    constexpr uint16_t div[] = { 1, 8, 64, 256, 1024 };
+    if (hz == 0) return { 0, 0 };
+    for (uint8_t i = 0; i < 5; i++) {
+        uint32_t ticks = __cpu_frequency / div[i] / hz;
+        uint32_t top   = mode == PwmMode::FAST ? ticks - 1 : ticks / 2;
+        if (ticks >= 2 && top <= 0xFFFF) return { static_cast<uint8_t>(i + 1), static_cast<uint16_t>(top) };
+        if (ticks < 2) return { 0, 0 };
+    }
+    return { 0, 0 };
+}
+} // namespace __details
+
+/*
+ * Timer1 as a PWM source with its period in ICR1, so both the frequency and the resolution are
+ * free: 16 bits at 244 Hz, 800 steps at 20 kHz (above hearing, where the coils stop whining).
+ * Fast PWM is mode 14; phase correct is mode 8, phase and frequency correct, which also takes a
+ * new OCR1x at BOTTOM.
+ *
+ * In both modes the compare registers are double buffered by the hardware: a duty written at
+ * any time takes effect at the start of the next period, never in the middle of one. Timer1 can
+ * drive either the step timer (firmware::timer1) or PWM on D9 / D10, not both; an ISR that
+ * writes a Timer1 16-bit register would corrupt TEMP under a duty write in progress.
+ */
+struct pwm_timer1 {
+    /// @brief run Timer1 at hz
+    /// @return TOP, the duty that means 100 %; 0 and the timer stopped when hz is out of reach
+    static uint16_t configure(uint32_t hz, PwmMode mode = PwmMode::FAST) noexcept {
+        __details::__timer1_setup s = __details::__timer1_for(hz, mode);
+        return configure_top(s.top, s.cs, mode);
+    }
+
+    /// @brief run Timer1 with prescaler clock select cs (1 to 5: 1, 8, 64, 256, 1024) and TOP top
+    static uint16_t configure_top(uint16_t top, uint8_t cs, PwmMode mode = PwmMode::FAST) noexcept {
+        using namespace __details;
+        // stop, and move TOP while the counter is parked at 0 so it can not run past it
+        __reg_write<TCCR1B_ADDR>(0);
+        __reg_write16<TCNT1_ADDR>(0);
+        s_top = cs ? top : 0;
+        if (!cs) return 0;
+        __reg_write16<ICR1_ADDR>(top);
+        uint8_t com = static_cast<uint8_t>(__reg_read<TCCR1A_ADDR>() & 0xF0); // keep the connected outputs
+        __reg_write<TCCR1A_ADDR>(static_cast<uint8_t>(com | (mode == PwmMode::FAST ? 0x02 : 0x00)));
+        __reg_write<TCCR1B_ADDR>(static_cast<uint8_t>((mode == PwmMode::FAST ? 0x18 : 0x10) | cs));
+        return top;
+    }
+
+    static void stop() noexcept { __details::__reg_write<__details::TCCR1B_ADDR>(0); }
+
+    static uint16_t top() noexcept { return s_top; }
+
+    private:
+    static inline uint16_t s_top = 0;
+};
+
+/*
+ * Timer2, 8 bits with TOP fixed at 255 so both of its outputs stay usable; only the prescaler
+ * moves the frequency: F_CPU / (N * 256) fast, F_CPU / (N * 510) phase correct.
+ */
+struct pwm_timer2 {
+    /// @brief run Timer2 at the frequency closest to hz
+    /// @return the frequency reached
+    static uint32_t configure(uint32_t hz, PwmMode mode = PwmMode::FAST) noexcept {
+        using namespace __details;
+        constexpr uint16_t div[] = { 1, 8, 32, 64, 128, 256, 1024 };
+        uint32_t period = mode == PwmMode::FAST ? 256 : 510;
+        uint8_t best    = 0;
+        uint32_t f_best = 0, err_best = 0xFFFFFFFF;
+        for (uint8_t i = 0; i < 7; i++) {
+            uint32_t f   = __cpu_frequency / div[i] / period;
+            uint32_t err = f > hz ? f - hz : hz - f;
+            if (err < err_best) best = i, f_best = f, err_best = err;
+        }
+        uint8_t com = static_cast<uint8_t>(__reg_read<TCCR2A_ADDR>() & 0xF0);
+        __reg_write<TCCR2A_ADDR>(static_cast<uint8_t>(com | (mode == PwmMode::FAST ? 0x03 : 0x01)));
+        __reg_write<TCCR2B_ADDR>(static_cast<uint8_t>(best + 1));
+        return f_best;
+    }
+
+    static void stop() noexcept { __details::__reg_write<__details::TCCR2B_ADDR>(0); }
+
+    static constexpr uint16_t top() noexcept { return 255; }
+};
+
+/// Timer0 keeps the core's fast PWM at 976 Hz, millis() counts its overflows
+struct pwm_timer0 {
+    static constexpr uint16_t top() noexcept { return 255; }
+};
+
+/// @brief hardware PWM on an Arduino pin, its timer and compare register picked at compile time
+/// D9 D10 on Timer1, D3 D11 on Timer2, D5 D6 on Timer0; write() is one store to OCRxy
+/// (two for Timer1, high byte first) and takes effect at the next period
+template <uint8_t PIN>
+class pwm {
+    static constexpr uint8_t m_timer = __details::__pwm_timer(PIN);
+    static_assert(m_timer != 0xFF, "pin has no output compare unit, use D3, D5, D6, D9, D10 or D11");
+
+    static constexpr bool m_a        = __details::__pwm_channel_a(PIN);
+    static constexpr uint8_t m_com   = m_a ? 0x80 : 0x20; // COMxy1, clear on match, non-inverting
+    static constexpr uint8_t m_tccra = m_timer == 0   ? __details::TCCR0A_ADDR
+                                       : m_timer == 1 ? __details::TCCR1A_ADDR
+                                                      : __details::TCCR2A_ADDR;
+    static constexpr uint8_t m_ocr   = m_timer == 0   ? (m_a ? __details::OCR0A_ADDR : __details::OCR0B_ADDR)
+                                       : m_timer == 1 ? (m_a ? __details::OCR1A_ADDR : __details::OCR1B_ADDR)
+                                                      : (m_a ? __details::OCR2A_ADDR : __details::OCR2B_ADDR);
+
+    public:
+    using timer = typename msd::conditional<m_timer == 1, pwm_timer1,
+                                            typename msd::conditional<m_timer == 2, pwm_timer2, pwm_timer0>::type>::type;
+
+    static constexpr uint8_t number = PIN;
+
+    /// @brief make the pin an output and connect it to the compare unit
+    static void init() noexcept {
+        pins<PIN, PinMode::OUTPUT>::init();
+        __details::__reg_set<m_tccra>(m_com);
+    }
+
+    /// @brief hand the pin back to PORTx
+    static void release() noexcept { __details::__reg_clear<m_tccra>(static_cast<uint8_t>(m_com | m_com >> 1)); }
+
+    /// @brief duty as a compare value, 0 to timer::top()
+    __attribute__((always_inline)) static void write(uint16_t duty) noexcept {
+        if constexpr (m_timer == 1) __details::__reg_write16<m_ocr>(duty);
+        else __details::__reg_write<m_ocr>(static_cast<uint8_t>(duty));
+    }
+
+    /// @brief duty as a fraction of 65536, whatever the resolution; 0xFFFF is 100 %
+    static void write_scaled(uint16_t level) noexcept {
+        write(static_cast<uint16_t>((static_cast<uint32_t>(level) * (static_cast<uint32_t>(timer::top()) + 1)) >> 16));
+    }
+};
+
+} // namespace firmware
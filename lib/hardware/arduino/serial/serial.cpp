@@ -1,10 +1,26 @@
+#ifdef ARDUINO
+
 #include "serial.hpp"
 
 #include <Arduino.h>
 #include <stdint.h>
 
+#include <charconv>
+
 namespace firmware {
 
+namespace {
+
+/// the digits through msd::to_chars in one write, instead of Print's divide per digit
+template <typename T>
+size_t print_number(T n) {
+    char buf[11];
+    auto r = msd::to_chars(buf, buf + sizeof(buf), n);
+    return Serial.write(reinterpret_cast<const uint8_t*>(buf), static_cast<size_t>(r.ptr - buf));
+}
+
+} // namespace
+
 void SerialPort::begin(unsigned long baud) { Serial.begin(baud); }
 void SerialPort::end() { Serial.end(); }
 int SerialPort::available() { return Serial.available(); }
@@ -17,18 +33,20 @@ size_t SerialPort::write(uint8_t byte) { return Serial.write(byte); }
 size_t SerialPort::write(const uint8_t* buffer, size_t size) { return Serial.write(buffer, size); }
 
 size_t SerialPort::print(const char* str) { return Serial.print(str); }
-size_t SerialPort::print(int n) { return Serial.print(n); }
-size_t SerialPort::print(unsigned int n) { return Serial.print(n); }
-size_t SerialPort::print(long n) { return Serial.print(n); }
-size_t SerialPort::print(unsigned long n) { return Serial.print(n); }
+size_t SerialPort::print(int n) { return print_number(n); }
+size_t SerialPort::print(unsigned int n) { return print_number(n); }
+size_t SerialPort::print(long n) { return print_number(n); }
+size_t SerialPort::print(unsigned long n) { return print_number(n); }
 size_t SerialPort::print(double n, int digits) { return Serial.print(n, digits); }
 size_t SerialPort::println(const char* str) { return Serial.println(str); }
-size_t SerialPort::println(int n) { return Serial.println(n); }
-size_t SerialPort::println(unsigned int n) { return Serial.println(n); }
-size_t SerialPort::println(long n) { return Serial.println(n); }
-size_t SerialPort::println(unsigned long n) { return Serial.println(n); }
+size_t SerialPort::println(int n) { return print_number(n) + Serial.println(); }
+size_t SerialPort::println(unsigned int n) { return print_number(n) + Serial.println(); }
+size_t SerialPort::println(long n) { return print_number(n) + Serial.println(); }
+size_t SerialPort::println(unsigned long n) { return print_number(n) + Serial.println(); }
 size_t SerialPort::println(double n, int digits) { return Serial.println(n, digits); }
 size_t SerialPort::println() { return Serial.println(); }
 
 SerialPort serial;
 } // namespace firmware
+
+#endif // ARDUINO
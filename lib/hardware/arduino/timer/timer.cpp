@@ -0,0 +1,53 @@
+#ifdef ARDUINO
+
+#include "timer.hpp"
+
+#include <Arduino.h>
+
+namespace firmware {
+
+namespace __details {
+static void (*__timer1_handler)() = nullptr;
+} // namespace __details
+
+void timer1::attach(void (*handler)()) noexcept {
+    bool enabled = mask();
+    __details::__timer1_handler = handler;
+    unmask(enabled);
+}
+
+void timer1::start(uint16_t period) noexcept {
+    TIMSK1 &= ~_BV(OCIE1A);
+    TCCR1A = 0;
+    TCCR1B = _BV(WGM12); // CTC on OCR1A, clock stopped
+    TCNT1  = 0;
+    OCR1A  = period;
+    TIFR1  = _BV(OCF1A);
+    TIMSK1 |= _BV(OCIE1A);
+    TCCR1B |= _BV(CS11) | _BV(CS10); // clk / 64
+}
+
+void timer1::set_period(uint16_t period) noexcept { OCR1A = period; }
+
+void timer1::stop() noexcept {
+    TCCR1B &= ~(_BV(CS12) | _BV(CS11) | _BV(CS10));
+    TIMSK1 &= ~_BV(OCIE1A);
+}
+
+bool timer1::mask() noexcept {
+    bool enabled = TIMSK1 & _BV(OCIE1A);
+    TIMSK1 &= ~_BV(OCIE1A);
+    return enabled;
+}
+
+void timer1::unmask(bool enabled) noexcept {
+    if (enabled) TIMSK1 |= _BV(OCIE1A);
+}
+
+} // namespace firmware
+
+ISR(TIMER1_COMPA_vect) {
+    if (firmware::__details::__timer1_handler) firmware::__details::__timer1_handler();
+}
+
+#endif // ARDUINO
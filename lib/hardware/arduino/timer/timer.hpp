@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace firmware {
+
+/// @brief Timer1 in CTC mode, one compare match interrupt every `period` ticks of F_CPU / 64
+/// the attached handler runs inside the ISR; it may call set_period() or stop()
+struct timer1 {
+    static constexpr uint32_t frequency = F_CPU / 64;
+
+    static void attach(void (*handler)()) noexcept;
+
+    static void start(uint16_t period) noexcept;
+    static void set_period(uint16_t period) noexcept;
+    static void stop() noexcept;
+
+    /// mask the compare interrupt, returns whether it was enabled
+    static bool mask() noexcept;
+    static void unmask(bool enabled) noexcept;
+};
+
+} // namespace firmware
@@ -1,3 +1,5 @@
+#ifdef ARDUINO
+
 #include "wiring.hpp"
 
 #include <Arduino.h>
@@ -14,4 +16,8 @@ void wait(msd::literals::Seconds s) {
     }
 }
 
+uint32_t clock::now_us() noexcept { return micros(); }
+
 } // namespace firmware
+
+#endif // ARDUINO
@@ -1,9 +1,20 @@
 #pragma once
 
+#include <stdint.h>
+
 #include <literals>
+#include <scheduler>
 
 namespace firmware {
 
+/// busy-waits, everything else on the MCU stalls meanwhile; inside a task use MSD_TASK_AWAIT instead
 void wait(msd::literals::Seconds s);
 
+/// @brief microsecond clock behind firmware::scheduler, wraps every ~71 minutes
+struct clock {
+    static uint32_t now_us() noexcept;
+};
+
+using scheduler = msd::scheduler<clock>;
+
 } // namespace firmware
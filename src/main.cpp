@@ -30,8 +30,8 @@ void entry() {
     auto& log = logger::instance();
     log.init();
     log.info("Hi");
-    log.info("Hi%d", 123);
-    log.info("Hi%s", "abc");
+    log.info("Hi{}"_fmt, 123);
+    log.info("Hi{}"_fmt, "abc");
     log.info("7355608");
 
     LED1::dwrite(true);
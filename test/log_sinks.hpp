@@ -0,0 +1,14 @@
+#pragma once
+
+#include <arduino/logger/log_sink.hpp>
+
+/*
+ * The native build's log output, named by -DFIRMWARE_LOG_SINKS_HEADER in platformio.ini: a RAM
+ * ring the logger tests read their lines back from, instead of stdout.
+ */
+
+inline firmware::ram_sink<512> test_log_ram;
+
+namespace firmware {
+using log_output = log_to<test_log_ram>;
+} // namespace firmware
@@ -1,8 +1,33 @@
 #include <unity.h>
 
+#include "test_adc.hpp"
+#include "test_algorithm.hpp"
+#include "test_charconv.hpp"
+#include "test_debouncer.hpp"
+#include "test_format.hpp"
+#include "test_interrupts.hpp"
+#include "test_log_binary.hpp"
+#include "test_log_buffer.hpp"
+#include "test_log_level.hpp"
+#include "test_log_limit.hpp"
+#include "test_log_sink.hpp"
+#include "test_logger.hpp"
+#include "test_microstep.hpp"
 #include "test_move.hpp"
+#include "test_multi_axis.hpp"
 #include "test_pair.hpp"
+#include "test_pin_group.hpp"
+#include "test_pin_stepmotor.hpp"
+#include "test_pins.hpp"
+#include "test_planner.hpp"
+#include "test_pwm.hpp"
+#include "test_execution.hpp"
 #include "test_queue.hpp"
+#include "test_ring_buffer.hpp"
+#include "test_scheduler.hpp"
+#include "test_simd.hpp"
+#include "test_soa_vector.hpp"
+#include "test_speed_ramp.hpp"
 #include "test_tuple.hpp"
 #include "test_type_trait.hpp"
 #include "test_vector.hpp"
@@ -53,4 +78,29 @@ int main() {
     test_tuple();
     test_type_traits();
     test_pair_basic();
+    test_soa_vector();
+    test_algorithm();
+    test_simd();
+    test_execution();
+    test_scheduler();
+    test_speed_ramp();
+    test_multi_axis();
+    test_planner();
+    test_microstep();
+    test_pin_stepmotor();
+    test_pins();
+    test_pin_group();
+    test_ring_buffer();
+    test_adc();
+    test_pwm();
+    test_debouncer();
+    test_interrupts();
+    test_log_buffer();
+    test_log_binary();
+    test_log_level();
+    test_format();
+    test_charconv();
+    test_log_limit();
+    test_log_sink();
+    test_logger();
 }
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <unity.h>
+
+#include <arduino/adc/adc.hpp>
+
+#include "test_bench.hpp"
+#include "test_pins.hpp"
+
+namespace msd_adc_test {
+
+using firmware::adc;
+using firmware::adc_sim;
+using firmware::AdcPrescaler;
+using firmware::AdcReference;
+using firmware::AdcTrigger;
+using namespace msd_pins_test;
+
+constexpr uint8_t ADCSRA = 0x7A, ADCSRB = 0x7B, ADMUX = 0x7C, DIDR0 = 0x7E, TIFR1 = 0x36;
+
+// each channel reads back as 100 times its number, plus how many conversions ran before
+inline uint16_t conversions = 0;
+inline uint16_t by_channel(uint8_t ch) { return static_cast<uint16_t>(ch * 100 + (conversions++ & 0x3F)); }
+
+inline void run(uint16_t n) {
+    for (uint16_t i = 0; i < n; i++) adc_sim::convert(by_channel);
+}
+
+inline void drain() {
+    uint16_t out[adc::capacity];
+    while (adc::read(out, adc::capacity)) {}
+}
+
+} // namespace msd_adc_test
+
+using namespace msd_adc_test;
+
+// Test start() programs the reference, first channel, trigger, prescaler and digital inputs
+void test_adc_registers() {
+    reset();
+    const uint8_t list[] = { 0, 1, 5, 7 };
+    adc::start(list, 4, AdcPrescaler::DIV_16);
+    TEST_ASSERT_EQUAL_HEX8(0x40, reg(ADMUX)); // AVCC, channel 0
+    TEST_ASSERT_EQUAL_HEX8(0x00, reg(ADCSRB));
+    TEST_ASSERT_EQUAL_HEX8(0xFC, reg(ADCSRA)); // ADEN ADSC ADATE ADIF ADIE, /16
+    TEST_ASSERT_EQUAL_HEX8(0x23, reg(DIDR0));  // A7 has no digital buffer
+
+    adc::start(list + 2, 1, AdcPrescaler::DIV_128, AdcTrigger::TIMER1_COMPB, AdcReference::INTERNAL_1V1);
+    TEST_ASSERT_EQUAL_HEX8(0xC5, reg(ADMUX));
+    TEST_ASSERT_EQUAL_HEX8(0x05, reg(ADCSRB));
+    TEST_ASSERT_EQUAL_HEX8(0xBF, reg(ADCSRA)); // no ADSC, the timer starts it
+
+    adc::stop();
+    TEST_ASSERT_EQUAL_HEX8(0x00, reg(ADCSRA) & 0x88);
+    drain();
+}
+
+// Test free running walks the list with the one-conversion pipeline and tags each sample right
+void test_adc_free_running() {
+    reset();
+    drain();
+    const uint8_t list[] = { 2, 3, 4 };
+    adc::start(list, 3);
+    run(10);
+    TEST_ASSERT_EQUAL(10, adc::available());
+
+    const uint8_t expect[] = { 2, 2, 3, 4, 2, 3, 4, 2, 3, 4 };
+    uint16_t s = 0;
+    for (uint8_t ch : expect) {
+        TEST_ASSERT_TRUE(adc::read(s));
+        TEST_ASSERT_EQUAL(ch, adc::channel(s));
+        TEST_ASSERT_EQUAL(ch, adc::value(s) / 100); // the value really came from that channel
+    }
+    TEST_ASSERT_FALSE(adc::read(s));
+    adc::stop();
+}
+
+// Test triggered conversions alternate at once and clear the timer flag for the next event
+void test_adc_triggered() {
+    reset();
+    drain();
+    const uint8_t list[] = { 1, 6 };
+    adc::start(list, 2, AdcPrescaler::DIV_64, AdcTrigger::TIMER1_COMPB);
+    run(6);
+    uint16_t out[8];
+    TEST_ASSERT_EQUAL(6, adc::read(out, 8));
+    for (uint8_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL(list[i & 1], adc::channel(out[i]));
+        TEST_ASSERT_EQUAL(list[i & 1], adc::value(out[i]) / 100);
+    }
+    TEST_ASSERT_EQUAL_HEX8(0x04, reg(TIFR1)); // OCF1B written back
+    adc::stop();
+}
+
+// Test the consumer drains in batches, a full buffer drops and counts, stop() ends sampling
+void test_adc_batch_overrun() {
+    reset();
+    drain();
+    const uint8_t list[] = { 0 };
+    adc::start(list, 1, AdcPrescaler::DIV_16, AdcTrigger::TIMER0_OVF);
+    run(adc::capacity + 10);
+    TEST_ASSERT_EQUAL(adc::capacity, adc::available());
+    TEST_ASSERT_EQUAL(10, adc::overruns());
+
+    uint16_t out[16];
+    size_t total = 0, n;
+    while ((n = adc::read(out, 16)) != 0) {
+        TEST_ASSERT_EQUAL(16, n);
+        total += n;
+    }
+    TEST_ASSERT_EQUAL(adc::capacity, total);
+
+    run(5);
+    TEST_ASSERT_EQUAL(5, adc::available());
+    adc::stop();
+    run(5);
+    TEST_ASSERT_EQUAL(5, adc::available());
+    adc::start(list, 1);
+    TEST_ASSERT_EQUAL(0, adc::available());
+    TEST_ASSERT_EQUAL(0, adc::overruns());
+    adc::stop();
+}
+
+// ==================== 性能测试 ====================
+
+// Cost of the ISR body and of draining, and the sample rates the converter allows on a 16 MHz Uno
+void test_adc_performance() {
+    reset();
+    drain();
+    const uint8_t list[] = { 0, 1, 2, 3 };
+    adc::start(list, 4, AdcPrescaler::DIV_16);
+#ifndef ARDUINO
+    const uint32_t n = 1000000;
+#else
+    const uint32_t n = 1000;
+#endif
+    uint16_t out[32];
+    uint32_t sum        = 0;
+    unsigned long isr   = 0;
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < n; i += 32) {
+        for (uint8_t k = 0; k < 32; k++) adc::on_conversion();
+        size_t got = adc::read(out, 32);
+        for (size_t k = 0; k < got; k++) sum += adc::value(out[k]);
+    }
+    isr = micros() - start;
+    bench_keep(sum);
+    adc::stop();
+    TEST_ASSERT_EQUAL(0, adc::overruns());
+
+    // 13 ADC clocks a conversion; analogRead() uses /128 and waits for each one
+    const double f_cpu = 16000000.0;
+    bench_report("ADC ISR + batch drain, ns per sample", isr * 1000.0 / n, "ns");
+    bench_report("free running /16, samples per second", f_cpu / 16 / 13, "Hz");
+    bench_report("analogRead /128, samples per second", f_cpu / 128 / 13, "Hz");
+}
+
+void test_adc() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_adc_registers);
+    RUN_TEST(test_adc_free_running);
+    RUN_TEST(test_adc_triggered);
+    RUN_TEST(test_adc_batch_overrun);
+
+    RUN_TEST(test_adc_performance);
+
+    UNITY_END();
+}
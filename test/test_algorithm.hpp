@@ -0,0 +1,243 @@
+#pragma once
+
+#include <unity.h>
+
+#include <algorithm>
+#include <array>
+#include <pair>
+#include <vector>
+
+#include "test_bench.hpp"
+
+namespace msd_algorithm_test {
+
+// xorshift, deterministic input for every run
+inline uint32_t next_rand(uint32_t& s) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+template <typename T>
+void fill_random(T* data, size_t n, uint32_t seed, uint32_t mod = 0) {
+    for (size_t i = 0; i < n; i++) {
+        uint32_t r = next_rand(seed);
+        data[i]    = static_cast<T>(mod ? r % mod : r);
+    }
+}
+
+// the hand-written sort we are replacing
+template <typename T>
+void bubble_sort(T* data, size_t n) {
+    for (size_t i = 0; i + 1 < n; i++)
+        for (size_t j = 0; j + 1 < n - i; j++)
+            if (data[j + 1] < data[j]) msd::swap(data[j], data[j + 1]);
+}
+
+struct Reading {
+    int16_t value;
+    uint16_t seq;
+};
+struct by_value {
+    bool operator()(const Reading& a, const Reading& b) const { return a.value < b.value; }
+};
+
+} // namespace msd_algorithm_test
+
+using namespace msd_algorithm_test;
+
+// Test introsort on raw pointers, including sorted, reversed and all-equal input
+void test_algorithm_sort_pointer() {
+    const size_t n = 300;
+    int16_t data[n];
+
+    fill_random(data, n, 1);
+    msd::sort(data, data + n);
+    TEST_ASSERT_TRUE(msd::is_sorted(data, data + n));
+
+    msd::sort(data, data + n); // already sorted
+    TEST_ASSERT_TRUE(msd::is_sorted(data, data + n));
+
+    msd::reverse(data, data + n);
+    msd::sort(data, data + n);
+    TEST_ASSERT_TRUE(msd::is_sorted(data, data + n));
+
+    for (size_t i = 0; i < n; i++) data[i] = 7;
+    msd::sort(data, data + n);
+    TEST_ASSERT_TRUE(msd::is_sorted(data, data + n));
+
+    // custom comparator, descending
+    fill_random(data, n, 2, 50);
+    msd::sort(data, data + n, [](int16_t a, int16_t b) { return a > b; });
+    for (size_t i = 1; i < n; i++) TEST_ASSERT_TRUE(data[i - 1] >= data[i]);
+
+    // tiny ranges
+    msd::sort(data, data);
+    msd::sort(data, data + 1);
+}
+
+// Test introsort and heap sort through msd::iterator
+void test_algorithm_sort_iterator() {
+    msd::vector<int> v;
+    uint32_t seed = 3;
+    for (int i = 0; i < 500; i++) v.push_back(static_cast<int>(next_rand(seed) % 1000) - 500);
+
+    msd::sort(v.begin(), v.end());
+    TEST_ASSERT_TRUE(msd::is_sorted(v.begin(), v.end()));
+
+    auto arr = msd::make_array(5, 3, 9, 1, 7, 2, 8);
+    msd::heap_sort(arr.begin(), arr.end());
+    for (size_t i = 0; i < arr.size(); i++) TEST_ASSERT_TRUE(i == 0 || arr[i - 1] <= arr[i]);
+
+    msd::insertion_sort(arr.begin(), arr.end(), [](int a, int b) { return a > b; });
+    TEST_ASSERT_EQUAL(9, arr[0]);
+    TEST_ASSERT_EQUAL(1, arr[6]);
+}
+
+// Test heap sort on its own, it is the introsort fallback
+void test_algorithm_heap_sort() {
+    const size_t n = 257;
+    uint16_t data[n];
+    fill_random(data, n, 4);
+    msd::heap_sort(data, data + n);
+    TEST_ASSERT_TRUE(msd::is_sorted(data, data + n));
+}
+
+// Test stable sort keeps equal keys in input order
+void test_algorithm_stable_sort() {
+    const size_t n = 200;
+    Reading r[n];
+    uint32_t seed = 5;
+    for (size_t i = 0; i < n; i++) r[i] = Reading{ static_cast<int16_t>(next_rand(seed) % 10), static_cast<uint16_t>(i) };
+
+    msd::stable_sort(r, r + n, by_value{});
+    for (size_t i = 1; i < n; i++) {
+        TEST_ASSERT_TRUE(r[i - 1].value <= r[i].value);
+        if (r[i - 1].value == r[i].value) TEST_ASSERT_TRUE(r[i - 1].seq < r[i].seq);
+    }
+
+    msd::vector<msd::pair<int, int>> v;
+    for (int i = 0; i < 64; i++) v.push_back(msd::pair<int, int>(i % 3, i));
+    msd::stable_sort(v.begin(), v.end(), [](const msd::pair<int, int>& a, const msd::pair<int, int>& b) { return a.first < b.first; });
+    for (int i = 1; i < 64; i++) {
+        TEST_ASSERT_TRUE(v[i - 1].first <= v[i].first);
+        if (v[i - 1].first == v[i].first) TEST_ASSERT_TRUE(v[i - 1].second < v[i].second);
+    }
+}
+
+// Test nth_element and partial_sort against a full sort
+void test_algorithm_selection() {
+    const size_t n = 101;
+    int32_t data[n], sorted[n];
+    fill_random(data, n, 6, 1000);
+    for (size_t i = 0; i < n; i++) sorted[i] = data[i];
+    msd::sort(sorted, sorted + n);
+
+    const size_t ks[] = { 0, 17, 50, 100 };
+    for (size_t k : ks) {
+        int32_t work[n];
+        for (size_t i = 0; i < n; i++) work[i] = data[i];
+        msd::nth_element(work, work + k, work + n);
+        TEST_ASSERT_EQUAL(sorted[k], work[k]);
+        for (size_t i = 0; i < k; i++) TEST_ASSERT_TRUE(work[i] <= work[k]);
+        for (size_t i = k + 1; i < n; i++) TEST_ASSERT_TRUE(work[i] >= work[k]);
+    }
+
+    int32_t work[n];
+    for (size_t i = 0; i < n; i++) work[i] = data[i];
+    msd::partial_sort(work, work + 10, work + n);
+    for (size_t i = 0; i < 10; i++) TEST_ASSERT_EQUAL(sorted[i], work[i]);
+}
+
+// Test lower_bound / upper_bound / unique
+void test_algorithm_bounds_unique() {
+    int data[] = { 1, 2, 2, 2, 3, 5, 5, 8 };
+    int* end   = data + 8;
+
+    TEST_ASSERT_EQUAL_PTR(data + 1, msd::lower_bound(data, end, 2));
+    TEST_ASSERT_EQUAL_PTR(data + 4, msd::upper_bound(data, end, 2));
+    TEST_ASSERT_EQUAL_PTR(data + 5, msd::lower_bound(data, end, 4));
+    TEST_ASSERT_EQUAL_PTR(data, msd::lower_bound(data, end, 0));
+    TEST_ASSERT_EQUAL_PTR(end, msd::upper_bound(data, end, 8));
+
+    int* last = msd::unique(data, end);
+    TEST_ASSERT_EQUAL(5, last - data);
+    TEST_ASSERT_EQUAL(1, data[0]);
+    TEST_ASSERT_EQUAL(2, data[1]);
+    TEST_ASSERT_EQUAL(3, data[2]);
+    TEST_ASSERT_EQUAL(5, data[3]);
+    TEST_ASSERT_EQUAL(8, data[4]);
+
+    msd::vector<int> v = { 4, 4, 4 };
+    auto it            = msd::unique(v.begin(), v.end());
+    TEST_ASSERT_EQUAL(1, it - v.begin());
+    auto lb = msd::lower_bound(v.begin(), v.end(), 4);
+    TEST_ASSERT_TRUE(lb == v.begin());
+}
+
+// ==================== 性能测试 ====================
+
+// Compare introsort / stable sort / heap sort against bubble sort across sizes
+void test_algorithm_performance_sort() {
+#ifndef ARDUINO
+    const size_t sizes[] = { 16, 64, 256, 1024, 4096 };
+    static int16_t data[4096], work[4096];
+#else
+    const size_t sizes[] = { 16, 64, 256 };
+    static int16_t data[256], work[256];
+#endif
+    for (size_t n : sizes) {
+        fill_random(data, n, 7);
+        char name[48];
+        unsigned long start;
+
+        for (size_t i = 0; i < n; i++) work[i] = data[i];
+        start = micros();
+        bubble_sort(work, n);
+        unsigned long bubble = micros() - start;
+        TEST_ASSERT_TRUE(msd::is_sorted(work, work + n));
+
+        for (size_t i = 0; i < n; i++) work[i] = data[i];
+        start = micros();
+        msd::sort(work, work + n);
+        unsigned long intro = micros() - start;
+        TEST_ASSERT_TRUE(msd::is_sorted(work, work + n));
+
+        for (size_t i = 0; i < n; i++) work[i] = data[i];
+        start = micros();
+        msd::stable_sort(work, work + n);
+        unsigned long stable = micros() - start;
+        TEST_ASSERT_TRUE(msd::is_sorted(work, work + n));
+
+        for (size_t i = 0; i < n; i++) work[i] = data[i];
+        start = micros();
+        msd::heap_sort(work, work + n);
+        unsigned long heap = micros() - start;
+        TEST_ASSERT_TRUE(msd::is_sorted(work, work + n));
+
+        snprintf(name, sizeof(name), "bubble_sort n=%u", static_cast<unsigned>(n));
+        bench_report_time(name, bubble);
+        snprintf(name, sizeof(name), "sort n=%u", static_cast<unsigned>(n));
+        bench_report_time(name, intro);
+        snprintf(name, sizeof(name), "stable_sort n=%u", static_cast<unsigned>(n));
+        bench_report_time(name, stable);
+        snprintf(name, sizeof(name), "heap_sort n=%u", static_cast<unsigned>(n));
+        bench_report_time(name, heap);
+    }
+}
+
+void test_algorithm() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_algorithm_sort_pointer);
+    RUN_TEST(test_algorithm_sort_iterator);
+    RUN_TEST(test_algorithm_heap_sort);
+    RUN_TEST(test_algorithm_stable_sort);
+    RUN_TEST(test_algorithm_selection);
+    RUN_TEST(test_algorithm_bounds_unique);
+
+    RUN_TEST(test_algorithm_performance_sort);
+
+    UNITY_END();
+}
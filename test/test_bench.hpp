@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdio.h>
+
+// ==================== 基准测试辅助 ====================
+#ifndef ARDUINO
+#include <time.h>
+
+// 非Arduino环境的时间函数替代
+inline unsigned long micros() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long>(ts.tv_sec) * 1000000UL + static_cast<unsigned long>(ts.tv_nsec) / 1000UL;
+}
+
+inline void bench_report(const char* name, double value, const char* unit) {
+    printf("  [bench] %-40s %12.3f %s\n", name, value, unit);
+}
+
+inline void bench_report_time(const char* name, unsigned long us) { bench_report(name, us, "us"); }
+#else
+#include <Arduino.h>
+
+inline void bench_report(const char* name, double value, const char* unit) {
+    Serial.print(F("  [bench] "));
+    Serial.print(name);
+    Serial.print(' ');
+    Serial.print(value, 3);
+    Serial.print(' ');
+    Serial.println(unit);
+}
+
+// 板上 micros() 的分辨率是 4us，以 us 报告
+inline void bench_report_time(const char* name, unsigned long us) { bench_report(name, us, "us"); }
+#endif
+
+// 防止编译器把基准测试的结果优化掉
+template <typename T>
+inline void bench_keep(const T& v) {
+    asm volatile("" : : "r"(&v) : "memory");
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <string.h>
+#include <unity.h>
+
+#include <charconv>
+
+#include "test_bench.hpp"
+
+namespace msd_charconv_test {
+
+/// to_chars into a fresh buffer, as a string
+template <typename T>
+inline const char* text(T v) {
+    static char out[16];
+    char* end = msd::to_chars(out, out + sizeof(out) - 1, v).ptr;
+    *end      = '\0';
+    return out;
+}
+
+/// to_chars_fixed into a fresh buffer, as a string
+template <typename T>
+inline const char* fixed(T v, uint8_t decimals) {
+    static char out[16];
+    char* end = msd::to_chars_fixed(out, out + sizeof(out) - 1, v, decimals).ptr;
+    *end      = '\0';
+    return out;
+}
+
+/// to_chars_q into a fresh buffer, as a string
+inline const char* q(int32_t raw, uint8_t frac_bits, uint8_t decimals) {
+    static char out[16];
+    char* end = msd::to_chars_q(out, out + sizeof(out) - 1, raw, frac_bits, decimals).ptr;
+    *end      = '\0';
+    return out;
+}
+
+/// from_chars over a whole string, which must all be taken
+template <typename T>
+inline bool parse(const char* s, T& v) {
+    size_t len = strlen(s);
+    auto r     = msd::from_chars(s, s + len, v);
+    return r.ok && r.ptr == s + len;
+}
+
+/// Print::printNumber, one division per digit, for the benchmark
+inline char* print_number(char* buf, uint32_t n) {
+    char tmp[11];
+    char* p = tmp + sizeof(tmp);
+    do {
+        uint32_t m = n;
+        n /= 10;
+        *--p = static_cast<char>('0' + (m - n * 10));
+    } while (n);
+    size_t len = static_cast<size_t>(tmp + sizeof(tmp) - p);
+    memcpy(buf, p, len);
+    return buf + len;
+}
+
+} // namespace msd_charconv_test
+
+using namespace msd_charconv_test;
+
+// Test every width and sign at its limits, and every digit count
+void test_charconv_to_chars() {
+    TEST_ASSERT_EQUAL_STRING("-128", text(int8_t(-128)));
+    TEST_ASSERT_EQUAL_STRING("255", text(uint8_t(255)));
+    TEST_ASSERT_EQUAL_STRING("-32768", text(int16_t(-32768)));
+    TEST_ASSERT_EQUAL_STRING("65535", text(uint16_t(65535)));
+    TEST_ASSERT_EQUAL_STRING("-2147483648", text(int32_t(INT32_MIN)));
+    TEST_ASSERT_EQUAL_STRING("4294967295", text(uint32_t(UINT32_MAX)));
+
+    char expected[16];
+    uint32_t v = 1;
+    for (uint8_t digits = 1; digits <= 10; digits++, v = v * 10 + digits % 10) {
+        *print_number(expected, v) = '\0';
+        TEST_ASSERT_EQUAL_STRING(expected, text(v));
+        *print_number(expected, v - 1) = '\0';
+        TEST_ASSERT_EQUAL_STRING(expected, text(v - 1));
+    }
+    for (uint32_t i = 0; i < 70000; i += 7) { // across the 16-bit split of the chunks
+        *print_number(expected, i) = '\0';
+        TEST_ASSERT_EQUAL_STRING(expected, text(i));
+    }
+
+    for (uint32_t a = 1; a != 0 && a < 0xF0000000u; a = a * 3 + 1) // the AVR's high-half product
+        TEST_ASSERT_EQUAL_UINT32(static_cast<uint32_t>((static_cast<uint64_t>(a) * 3518437209u) >> 32), msd::__details::__mulhi32(a, 3518437209u));
+
+    char small[3];
+    TEST_ASSERT_FALSE(msd::to_chars(small, small + sizeof(small), 1000).ok);
+    TEST_ASSERT_TRUE(msd::to_chars(small, small + sizeof(small), -99).ok);
+}
+
+// Test decimal and binary fixed point
+void test_charconv_fixed() {
+    TEST_ASSERT_EQUAL_STRING("12.345", fixed(12345, 3));
+    TEST_ASSERT_EQUAL_STRING("-12.345", fixed(-12345, 3));
+    TEST_ASSERT_EQUAL_STRING("0.005", fixed(5, 3));
+    TEST_ASSERT_EQUAL_STRING("-0.050", fixed(-50, 3));
+    TEST_ASSERT_EQUAL_STRING("42", fixed(42, 0));
+    TEST_ASSERT_EQUAL_STRING("4294967.295", fixed(uint32_t(UINT32_MAX), 3));
+
+    TEST_ASSERT_EQUAL_STRING("1.50", q(3 << 7, 8, 2));   // Q8
+    TEST_ASSERT_EQUAL_STRING("-0.25", q(-(1 << 14), 16, 2)); // Q16
+    TEST_ASSERT_EQUAL_STRING("0.33", q(21845, 16, 2)); // rounded
+    TEST_ASSERT_EQUAL_STRING("0.334", q(21889, 16, 3));
+}
+
+// Test parsing: limits of every type, what ends a number and what is refused
+void test_charconv_from_chars() {
+    int8_t i8;
+    uint8_t u8;
+    int16_t i16;
+    uint16_t u16;
+    int32_t i32;
+    uint32_t u32;
+    TEST_ASSERT_TRUE(parse("-128", i8));
+    TEST_ASSERT_EQUAL(-128, i8);
+    TEST_ASSERT_FALSE(parse("128", i8));
+    TEST_ASSERT_FALSE(parse("-129", i8));
+    TEST_ASSERT_TRUE(parse("255", u8));
+    TEST_ASSERT_FALSE(parse("256", u8));
+    TEST_ASSERT_FALSE(parse("-1", u8));
+    TEST_ASSERT_TRUE(parse("-32768", i16));
+    TEST_ASSERT_EQUAL(-32768, i16);
+    TEST_ASSERT_TRUE(parse("65535", u16));
+    TEST_ASSERT_FALSE(parse("65536", u16));
+    TEST_ASSERT_TRUE(parse("-2147483648", i32));
+    TEST_ASSERT_EQUAL(INT32_MIN, i32);
+    TEST_ASSERT_FALSE(parse("2147483648", i32));
+    TEST_ASSERT_TRUE(parse("4294967295", u32));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, u32);
+    TEST_ASSERT_FALSE(parse("4294967296", u32));
+    TEST_ASSERT_FALSE(parse("99999999999", u32));
+    TEST_ASSERT_TRUE(parse("0007", u8));
+    TEST_ASSERT_EQUAL(7, u8);
+
+    const char* cmd = "M 250,x";
+    u16             = 1;
+    auto r          = msd::from_chars(cmd + 2, cmd + 7, u16);
+    TEST_ASSERT_TRUE(r.ok);
+    TEST_ASSERT_EQUAL(250, u16);
+    TEST_ASSERT_EQUAL_PTR(cmd + 5, r.ptr); // stops at the comma
+    r = msd::from_chars(cmd, cmd + 7, u16);
+    TEST_ASSERT_FALSE(r.ok); // no digits
+    TEST_ASSERT_EQUAL_PTR(cmd, r.ptr);
+    TEST_ASSERT_EQUAL(250, u16); // left alone
+    r = msd::from_chars(cmd, cmd, i32);
+    TEST_ASSERT_FALSE(r.ok);
+
+    TEST_ASSERT_TRUE(msd::from_chars_fixed("12.3", "12.3" + 4, i32, 3).ok);
+    TEST_ASSERT_EQUAL(12300, i32);
+    TEST_ASSERT_TRUE(msd::from_chars_fixed("-0.0567", "-0.0567" + 7, i32, 3).ok);
+    TEST_ASSERT_EQUAL(-56, i32); // digits past the precision are dropped
+    TEST_ASSERT_TRUE(msd::from_chars_fixed(".5", ".5" + 2, i32, 2).ok);
+    TEST_ASSERT_EQUAL(50, i32);
+    TEST_ASSERT_TRUE(msd::from_chars_fixed("7", "7" + 1, i32, 2).ok);
+    TEST_ASSERT_EQUAL(700, i32);
+    TEST_ASSERT_FALSE(msd::from_chars_fixed("3000000", "3000000" + 7, i32, 3).ok);
+    TEST_ASSERT_FALSE(msd::from_chars_fixed("-x", "-x" + 2, i32, 3).ok);
+    i32               = 42;
+    const char* point = ".";
+    auto bad          = msd::from_chars_fixed(point, point + 1, i32, 3);
+    TEST_ASSERT_FALSE(bad.ok);
+    TEST_ASSERT_EQUAL_PTR(point, bad.ptr);
+    const char* minus = "-.,";
+    bad               = msd::from_chars_fixed(minus, minus + 3, i32, 3);
+    TEST_ASSERT_FALSE(bad.ok);
+    TEST_ASSERT_EQUAL_PTR(minus, bad.ptr);
+    TEST_ASSERT_EQUAL(42, i32); // left alone
+    TEST_ASSERT_TRUE(msd::from_chars_fixed("5.", "5." + 2, i32, 1).ok);
+    TEST_ASSERT_EQUAL(50, i32);
+}
+
+// Test every 16-bit value survives the round trip
+void test_charconv_round_trip() {
+    char buf[8];
+    for (int32_t i = -32768; i <= 32767; i++) {
+        int16_t back = 0;
+        auto w       = msd::to_chars(buf, buf + sizeof(buf), static_cast<int16_t>(i));
+        auto r       = msd::from_chars(buf, w.ptr, back);
+        if (!r.ok || back != i) TEST_FAIL_MESSAGE("16-bit round trip");
+    }
+}
+
+// ==================== 性能测试 ====================
+
+// 32-bit values of every length, against Print::printNumber's divide per digit
+void test_charconv_performance() {
+#ifndef ARDUINO
+    const uint32_t n = 1000000;
+#else
+    const uint32_t n = 1000;
+#endif
+    static const uint32_t values[] = { 7, 42, 815, 4096, 65535, 123456, 9999999, 48151623, 2147483647, 4294967295u };
+    char a[16], b[16];
+    uint32_t sum_a = 0, sum_b = 0;
+
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < n; i++) {
+        sum_a += static_cast<uint32_t>(msd::to_chars(a, a + sizeof(a), values[i % 10]).ptr - a);
+        bench_keep(a);
+    }
+    unsigned long to_chars_us = micros() - start;
+
+    start = micros();
+    for (uint32_t i = 0; i < n; i++) {
+        sum_b += static_cast<uint32_t>(print_number(b, values[i % 10]) - b);
+        bench_keep(b);
+    }
+    unsigned long print_us = micros() - start;
+
+    uint32_t parsed = 0, total = 0;
+    start = micros();
+    for (uint32_t i = 0; i < n; i++) {
+        msd::from_chars(a, a + 10, parsed);
+        total += parsed;
+        bench_keep(a);
+    }
+    unsigned long from_chars_us = micros() - start;
+    bench_keep(&total);
+
+    TEST_ASSERT_EQUAL(sum_b, sum_a);
+    bench_report("msd::to_chars, ns per number", to_chars_us * 1000.0 / n, "ns");
+    bench_report("printNumber loop, ns per number", print_us * 1000.0 / n, "ns");
+    bench_report("msd::from_chars, ns per number", from_chars_us * 1000.0 / n, "ns");
+}
+
+void test_charconv() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_charconv_to_chars);
+    RUN_TEST(test_charconv_fixed);
+    RUN_TEST(test_charconv_from_chars);
+    RUN_TEST(test_charconv_round_trip);
+
+    RUN_TEST(test_charconv_performance);
+
+    UNITY_END();
+}
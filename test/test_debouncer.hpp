@@ -0,0 +1,172 @@
+#pragma once
+
+#include <unity.h>
+
+#include <arduino/pins/debouncer.hpp>
+
+#include "test_bench.hpp"
+#include "test_pins.hpp"
+
+namespace msd_debouncer_test {
+
+using firmware::basic_debouncer;
+using firmware::button_event;
+using firmware::PinMode;
+using namespace msd_pins_test;
+
+template <uint8_t PIN>
+using button = firmware::pins<PIN, PinMode::INPUT_PULLUP>;
+template <uint8_t PIN>
+using sensor = firmware::pins<PIN, PinMode::INPUT>;
+
+// two buttons to ground and an active-high limit switch on another port
+using panel  = firmware::debouncer<button<2>, button<3>, sensor<8>>;
+using keypad = firmware::debouncer<button<0>, button<1>, button<2>, button<3>, button<4>, button<5>, button<6>, button<7>>;
+
+// the released levels of the panel: pull-ups high, the switch low
+inline void idle() { reg(PIND) = 0x0C, reg(PINB) = 0x00; }
+
+inline void ticks(panel& p, uint8_t n) {
+    for (uint8_t i = 0; i < n; i++) p.tick();
+}
+
+} // namespace msd_debouncer_test
+
+using namespace msd_debouncer_test;
+
+// Test a counter flips only after 4 equal samples and a shorter glitch leaves it alone
+void test_debouncer_counter() {
+    firmware::__details::__vertical_counter c;
+    TEST_ASSERT_EQUAL_HEX8(0x00, c.update(0x01));
+    TEST_ASSERT_EQUAL_HEX8(0x00, c.update(0x01));
+    TEST_ASSERT_EQUAL_HEX8(0x00, c.update(0x00)); // bounce, starts over
+    for (int i = 0; i < 3; i++) TEST_ASSERT_EQUAL_HEX8(0x00, c.update(0x01));
+    TEST_ASSERT_EQUAL_HEX8(0x01, c.update(0x01));
+    TEST_ASSERT_EQUAL_HEX8(0x01, c.state);
+
+    // every bit counts on its own: bit 7 starts 2 samples after bit 1
+    c.update(0x03), c.update(0x03);
+    TEST_ASSERT_EQUAL_HEX8(0x00, c.update(0x83));
+    TEST_ASSERT_EQUAL_HEX8(0x02, c.update(0x83));
+    c.update(0x83);
+    TEST_ASSERT_EQUAL_HEX8(0x80, c.update(0x83));
+    TEST_ASSERT_EQUAL_HEX8(0x83, c.state);
+}
+
+// Test press and release become events, pull-up inputs count as pressed when low
+void test_debouncer_events() {
+    reset();
+    idle();
+    panel p;
+    p.init();
+    TEST_ASSERT_EQUAL_HEX8(0x00, reg(DDRD));
+    TEST_ASSERT_EQUAL_HEX8(0x0C, reg(PORTD)); // pull-ups on
+    TEST_ASSERT_EQUAL(0, p.pressed());
+
+    button_event e{};
+    reg(PIND) = 0x08; // D2 to ground
+    ticks(p, 3);
+    TEST_ASSERT_FALSE(p.poll(e));
+    p.tick();
+    TEST_ASSERT_TRUE(p.poll(e));
+    TEST_ASSERT_EQUAL(0, e.index);
+    TEST_ASSERT_TRUE(e.pressed);
+    TEST_ASSERT_TRUE(p.pressed(0));
+
+    idle();
+    reg(PINB) = 0x01; // D2 lets go, the limit switch closes
+    ticks(p, 4);
+    TEST_ASSERT_TRUE(p.poll(e));
+    TEST_ASSERT_EQUAL(0, e.index);
+    TEST_ASSERT_FALSE(e.pressed);
+    TEST_ASSERT_TRUE(p.poll(e));
+    TEST_ASSERT_EQUAL(2, e.index);
+    TEST_ASSERT_TRUE(e.pressed);
+    TEST_ASSERT_FALSE(p.poll(e));
+    TEST_ASSERT_EQUAL_HEX8(0x04, p.pressed());
+}
+
+// Test a contact chattering for a while gives one press and one release
+void test_debouncer_bounce() {
+    reset();
+    idle();
+    panel p;
+    p.init();
+    const uint8_t contact[] = { 1, 0, 1, 1, 0, 1, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0 };
+    for (uint8_t down : contact) {
+        reg(PIND) = down ? 0x04 : 0x0C; // D3 to ground
+        p.tick();
+    }
+    button_event e;
+    int presses = 0, releases = 0;
+    while (p.poll(e)) {
+        TEST_ASSERT_EQUAL(1, e.index);
+        (e.pressed ? presses : releases)++;
+    }
+    TEST_ASSERT_EQUAL(1, presses);
+    TEST_ASSERT_EQUAL(1, releases);
+}
+
+// Test events beyond the queue are counted, the state stays right
+void test_debouncer_overflow() {
+    reset();
+    reg(PIND) = 0xFF;
+    basic_debouncer<4, button<0>, button<1>, button<2>, button<3>, button<4>, button<5>, button<6>, button<7>> k;
+    k.init();
+    reg(PIND) = 0x00;
+    for (int i = 0; i < 4; i++) k.tick();
+    TEST_ASSERT_EQUAL_HEX8(0xFF, k.pressed());
+    TEST_ASSERT_EQUAL(4, k.dropped());
+    button_event e;
+    for (uint8_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(k.poll(e));
+        TEST_ASSERT_EQUAL(i, e.index);
+    }
+    TEST_ASSERT_FALSE(k.poll(e));
+}
+
+// ==================== 性能测试 ====================
+
+// One tick for a whole port of buttons, against delay() debouncing each pin
+void test_debouncer_performance() {
+    reset();
+    reg(PIND) = 0xFF;
+    keypad k;
+    k.init();
+#ifndef ARDUINO
+    const uint32_t n = 10000000;
+#else
+    const uint32_t n = 10000;
+#endif
+    details::io_reads        = 0;
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < n; i++) {
+        reg(PIND) = static_cast<uint8_t>(i >> 4); // slow enough to settle now and then
+        k.tick();
+    }
+    unsigned long us = micros() - start;
+    bench_keep(k.pressed());
+    TEST_ASSERT_EQUAL(n, details::io_reads);
+
+    button_event e;
+    uint32_t events = 0;
+    while (k.poll(e)) events++;
+    bench_report("debounce tick, 8 inputs, ns", us * 1000.0 / n, "ns");
+    bench_report("debounce tick, register reads", static_cast<double>(details::io_reads) / n, "");
+    // the loop it replaces: read, delay(20), read again, for each pin
+    bench_report("delay debounce, 8 inputs, ms blocked", 8 * 20, "ms");
+    bench_keep(events);
+}
+
+void test_debouncer() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_debouncer_counter);
+    RUN_TEST(test_debouncer_events);
+    RUN_TEST(test_debouncer_bounce);
+    RUN_TEST(test_debouncer_overflow);
+
+    RUN_TEST(test_debouncer_performance);
+
+    UNITY_END();
+}
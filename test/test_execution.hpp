@@ -0,0 +1,193 @@
+#pragma once
+
+#include <unity.h>
+
+#include <algorithm>
+#include <execution>
+#include <vector>
+
+#include "test_bench.hpp"
+
+namespace msd_execution_test {
+
+inline uint32_t xorshift(uint32_t& s) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+// a few dozen flops per element, stands in for the per-sample filters of the offline analysis
+inline float heavy(float x) {
+    float y = x;
+    for (int i = 0; i < 32; i++) y = y * 0.999f + x * 0.001f - y * y * 0.0001f;
+    return y;
+}
+
+#if MSD_THREADS
+// oversubscribed on small machines on purpose, the results must not depend on the schedule
+const size_t pool_sizes[] = { 1, 2, 3, 4, 8 };
+#endif
+
+} // namespace msd_execution_test
+
+using namespace msd_execution_test;
+
+// Test for_each touches every element exactly once
+void test_execution_for_each() {
+    msd::vector<int> v;
+    for (int i = 0; i < 10000; i++) v.push_back(i);
+
+    msd::for_each(msd::execution::par, v.begin(), v.end(), [](int& x) { x *= 2; });
+    for (int i = 0; i < 10000; i++) TEST_ASSERT_EQUAL(2 * i, v[i]);
+
+#if MSD_THREADS
+    for (size_t t : pool_sizes) {
+        msd::thread_pool pool(t);
+        long hits = 0;
+        msd::for_each(msd::execution::par.on(pool).with_grain(7), v.begin(), v.end(), [&hits](int&) { __atomic_add_fetch(&hits, 1, __ATOMIC_RELAXED); });
+        TEST_ASSERT_EQUAL(10000, hits);
+    }
+#endif
+
+    // empty range
+    msd::for_each(msd::execution::par, v.begin(), v.begin(), [](int& x) { x = -1; });
+    TEST_ASSERT_EQUAL(0, v[0]);
+}
+
+// Test transform and reduce match the sequenced results
+void test_execution_transform_reduce() {
+    const size_t n = 50000;
+    msd::vector<float> in, out, ref;
+    uint32_t seed = 1;
+    for (size_t i = 0; i < n; i++) in.push_back(static_cast<float>(xorshift(seed) % 1000) / 1000.0f);
+    out = in;
+    ref = in;
+
+    msd::transform(msd::execution::seq, in.begin(), in.end(), ref.begin(), heavy);
+    auto end = msd::transform(msd::execution::par, in.begin(), in.end(), out.begin(), heavy);
+    TEST_ASSERT_TRUE(end == out.end());
+    TEST_ASSERT_TRUE(out == ref);
+
+    msd::vector<int32_t> iv;
+    for (size_t i = 0; i < n; i++) iv.push_back(static_cast<int32_t>(i % 1000) - 500);
+    long long expect = msd::reduce(msd::execution::seq, iv.begin(), iv.end(), 10LL);
+    TEST_ASSERT_EQUAL(msd::accumulate(iv.begin(), iv.end(), 10LL), expect);
+    TEST_ASSERT_EQUAL(expect, msd::reduce(msd::execution::par, iv.begin(), iv.end(), 10LL));
+    TEST_ASSERT_EQUAL(42, msd::reduce(msd::execution::par, iv.begin(), iv.begin(), 42LL));
+
+#if MSD_THREADS
+    for (size_t t : pool_sizes) {
+        msd::thread_pool pool(t);
+        auto policy = msd::execution::par.on(pool);
+        TEST_ASSERT_EQUAL(expect, msd::reduce(policy, iv.begin(), iv.end(), 10LL));
+        int32_t hi = msd::reduce(policy.with_grain(100), iv.data(), iv.data() + n, INT32_MIN, [](int32_t a, int32_t b) { return a < b ? b : a; });
+        TEST_ASSERT_EQUAL(499, hi);
+    }
+#endif
+}
+
+// Test the parallel sort on random, sorted and all-equal input
+void test_execution_sort() {
+    const size_t n = 100000;
+    msd::vector<int32_t> v;
+    uint32_t seed = 2;
+    for (size_t i = 0; i < n; i++) v.push_back(static_cast<int32_t>(xorshift(seed)));
+
+    msd::sort(msd::execution::par, v.begin(), v.end());
+    TEST_ASSERT_TRUE(msd::is_sorted(v.begin(), v.end()));
+
+#if MSD_THREADS
+    for (size_t t : pool_sizes) {
+        msd::thread_pool pool(t);
+        auto policy = msd::execution::par.on(pool);
+
+        for (size_t i = 0; i < n; i++) v[i] = static_cast<int32_t>(xorshift(seed) % 100);
+        msd::sort(policy, v.begin(), v.end());
+        TEST_ASSERT_TRUE(msd::is_sorted(v.begin(), v.end()));
+
+        msd::sort(policy, v.begin(), v.end(), [](int32_t a, int32_t b) { return a > b; });
+        for (size_t i = 1; i < n; i++) TEST_ASSERT_TRUE(v[i - 1] >= v[i]);
+
+        for (size_t i = 0; i < n; i++) v[i] = 3;
+        msd::sort(policy, v.data(), v.data() + n);
+        TEST_ASSERT_TRUE(msd::is_sorted(v.data(), v.data() + n));
+    }
+#endif
+}
+
+#if MSD_THREADS
+// Test nested parallel calls from inside a task share the same pool
+void test_execution_nested() {
+    msd::thread_pool pool(4);
+    msd::vector<int> rows[16];
+    for (auto& r : rows)
+        for (int i = 0; i < 1000; i++) r.push_back(i);
+
+    long total = 0;
+    msd::for_each(msd::execution::par.on(pool).with_grain(1), rows, rows + 16, [&](msd::vector<int>& r) {
+        long s = msd::reduce(msd::execution::par.on(pool).with_grain(64), r.begin(), r.end(), 0L);
+        __atomic_add_fetch(&total, s, __ATOMIC_RELAXED);
+    });
+    TEST_ASSERT_EQUAL(16L * 999 * 1000 / 2, total);
+}
+#endif
+
+// ==================== 性能测试 ====================
+
+#if MSD_THREADS
+// Scaling of transform / reduce / sort over msd::vector from 1 to N participants
+void test_execution_performance_scaling() {
+    const size_t n = 2 * 1024 * 1024;
+    msd::vector<float> in, out;
+    msd::vector<int32_t> keys, work;
+    uint32_t seed = 3;
+    for (size_t i = 0; i < n; i++) {
+        in.push_back(static_cast<float>(xorshift(seed) % 1000) / 1000.0f);
+        keys.push_back(static_cast<int32_t>(xorshift(seed)));
+    }
+    out  = in;
+    work = keys;
+
+    size_t cores = msd::thread_pool::hardware_concurrency();
+    char name[48];
+    for (size_t t = 1;; t = (t * 2 < cores) ? t * 2 : cores) {
+        msd::thread_pool pool(t);
+        auto policy = msd::execution::par.on(pool);
+        unsigned long start;
+
+        start = micros();
+        msd::transform(policy, in.begin(), in.end(), out.begin(), heavy);
+        snprintf(name, sizeof(name), "transform heavy, %u threads", static_cast<unsigned>(t));
+        bench_report_time(name, micros() - start);
+
+        start = micros();
+        bench_keep(msd::reduce(policy, in.begin(), in.end(), 0.0));
+        snprintf(name, sizeof(name), "reduce float, %u threads", static_cast<unsigned>(t));
+        bench_report_time(name, micros() - start);
+
+        for (size_t i = 0; i < n; i++) work[i] = keys[i];
+        start = micros();
+        msd::sort(policy, work.begin(), work.end());
+        snprintf(name, sizeof(name), "sort int32, %u threads", static_cast<unsigned>(t));
+        bench_report_time(name, micros() - start);
+        TEST_ASSERT_TRUE(msd::is_sorted(work.begin(), work.end()));
+        if (t == cores) break;
+    }
+}
+#endif
+
+void test_execution() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_execution_for_each);
+    RUN_TEST(test_execution_transform_reduce);
+    RUN_TEST(test_execution_sort);
+#if MSD_THREADS
+    RUN_TEST(test_execution_nested);
+
+    RUN_TEST(test_execution_performance_scaling);
+#endif
+
+    UNITY_END();
+}
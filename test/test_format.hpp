@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stdio.h>
+#include <unity.h>
+
+#include <format>
+
+#include "test_bench.hpp"
+
+namespace msd_format_test {
+
+using msd::memory_sink;
+using namespace msd::literals;
+
+/// format into a fresh buffer, as a string
+template <typename Fmt, typename... Args>
+inline const char* fmt(Fmt f, Args... args) {
+    static char out[96];
+    msd::format_to(out, f, args...);
+    return out;
+}
+
+/// a sink that only counts, to see how a message reaches it
+struct counting_sink {
+    size_t puts = 0, writes = 0, bytes = 0;
+    void put(char) { puts++, bytes++; }
+    void write(const char*, size_t len) { writes++, bytes += len; }
+};
+
+// the parse happens at compile time
+static_assert(msd::__details::__fmt_parsed<'a', '{', '}', 'b'>::value.count == 3, "");
+static_assert(msd::__details::__fmt_parsed<'{', ':', '0', '8', 'x', '}'>::value.pieces[0].spec.width == 8, "");
+static_assert(!msd::__details::__fmt_parsed<'{', 'x'>::value.ok, "an open brace");
+static_assert(!msd::__details::__fmt_parsed<'a', '}'>::value.ok, "a lone closing brace");
+static_assert(!msd::__details::__fmt_accepts<float>('x'), "no hex floats");
+static_assert(!msd::__details::__fmt_accepts<const char*>('d'), "no numbers from strings");
+
+} // namespace msd_format_test
+
+using namespace msd_format_test;
+
+// Test integers of every width and sign, in every base and padding
+void test_format_integers() {
+    TEST_ASSERT_EQUAL_STRING("0 42 -42", fmt("{} {} {}"_fmt, 0, 42u, -42));
+    TEST_ASSERT_EQUAL_STRING("-128 255 -32768 65535", fmt("{} {} {} {}"_fmt, int8_t(-128), uint8_t(255), int16_t(-32768), uint16_t(65535)));
+    TEST_ASSERT_EQUAL_STRING("-2147483648 4294967295", fmt("{} {}"_fmt, int32_t(INT32_MIN), uint32_t(UINT32_MAX)));
+    TEST_ASSERT_EQUAL_STRING("-9223372036854775807 18446744073709551615", fmt("{} {}"_fmt, -9223372036854775807LL, 18446744073709551615ULL));
+    TEST_ASSERT_EQUAL_STRING("ff FF 11111111 377", fmt("{:x} {:X} {:b} {:o}"_fmt, 255, 255, 255, 255));
+    TEST_ASSERT_EQUAL_STRING("ffff fffffffe", fmt("{:x} {:x}"_fmt, int16_t(-1), -2)); // the bits of the type
+    TEST_ASSERT_EQUAL_STRING("[   7] [7   ] [0007] [-007] [00ff]", fmt("[{:4}] [{:-4}] [{:04}] [{:04}] [{:04x}]"_fmt, 7, 7, 7, -7, 255));
+}
+
+// Test floats, chars, bools, strings and escaped braces
+void test_format_others() {
+    TEST_ASSERT_EQUAL_STRING("3.14 -0.50 2.000 3", fmt("{} {} {:.3} {:.0}"_fmt, 3.14159, -0.5f, 2.0, 2.5));
+    TEST_ASSERT_EQUAL_STRING("[  1.25] nan ovf", fmt("[{:6}] {} {}"_fmt, 1.25f, 0.0 / 0.0, 1e12));
+    TEST_ASSERT_EQUAL_STRING("x 120 A", fmt("{} {:d} {:c}"_fmt, 'x', 'x', 65));
+    TEST_ASSERT_EQUAL_STRING("true 0", fmt("{} {:d}"_fmt, true, false));
+    TEST_ASSERT_EQUAL_STRING("[ab   ] [abc] (null)", fmt("[{:-5}] [{:.3}] {}"_fmt, "ab", "abcdef", static_cast<const char*>(nullptr)));
+    TEST_ASSERT_EQUAL_STRING("{x} {}", fmt("{{{}}} {{}}"_fmt, 'x'));
+    TEST_ASSERT_EQUAL_STRING("no arguments", fmt("no arguments"_fmt));
+}
+
+// Test the sink gets literal runs in one write and a short buffer truncates as snprintf does
+void test_format_sinks() {
+    counting_sink c;
+    msd::format(c, "motor {} stalled at {}"_fmt, 2, -15);
+    TEST_ASSERT_EQUAL(22, c.bytes);
+    TEST_ASSERT_EQUAL(4, c.writes); // "motor ", 2, " stalled at ", -15
+    TEST_ASSERT_EQUAL(0, c.puts);
+
+    char small[8];
+    TEST_ASSERT_EQUAL(13, msd::format_to(small, "value {}"_fmt, 1234567));
+    TEST_ASSERT_EQUAL_STRING("value 1", small);
+    memory_sink m(small);
+    msd::format(m, "{}"_fmt, 12);
+    TEST_ASSERT_FALSE(m.truncated());
+    TEST_ASSERT_EQUAL(2, m.size());
+}
+
+// ==================== 性能测试 ====================
+
+// One log-sized message formatted into memory, against snprintf with the same text
+void test_format_performance() {
+#ifndef ARDUINO
+    const uint32_t n = 1000000;
+#else
+    const uint32_t n = 1000;
+#endif
+    volatile uint16_t axis = 2;
+    volatile int32_t pos   = -123456;
+    volatile float speed   = 12.5f;
+    char a[64], b[64];
+
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < n; i++) msd::format_to(a, "axis {} at {} speed {:.2}"_fmt, static_cast<uint16_t>(axis), static_cast<int32_t>(pos), static_cast<float>(speed));
+    unsigned long format_us = micros() - start;
+
+    start = micros();
+    for (uint32_t i = 0; i < n; i++) snprintf(b, sizeof(b), "axis %u at %ld speed %.2f", static_cast<unsigned>(axis), static_cast<long>(pos), static_cast<double>(speed));
+    unsigned long printf_us = micros() - start;
+
+    TEST_ASSERT_EQUAL_STRING(b, a);
+    bench_report("msd::format, ns per message", format_us * 1000.0 / n, "ns");
+    bench_report("snprintf, ns per message", printf_us * 1000.0 / n, "ns");
+}
+
+void test_format() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_format_integers);
+    RUN_TEST(test_format_others);
+    RUN_TEST(test_format_sinks);
+
+    RUN_TEST(test_format_performance);
+
+    UNITY_END();
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <unity.h>
+
+#include <arduino/interrupts/interrupts.hpp>
+
+#include "test_bench.hpp"
+#include "test_pins.hpp"
+
+namespace msd_interrupts_test {
+
+using firmware::InterruptSense;
+using firmware::PinMode;
+using namespace msd_pins_test;
+
+template <uint8_t PIN>
+using in = firmware::pins<PIN, PinMode::INPUT_PULLUP>;
+
+constexpr uint8_t PCICR = 0x68, PCMSK0 = 0x6B, PCMSK1 = 0x6C, PCMSK2 = 0x6D, EICRA = 0x69, EIMSK = 0x3D;
+
+inline uint32_t probe_calls = 0, limit_calls = 0, index_calls = 0;
+inline bool probe_level = false;
+inline void probe(bool level) { probe_level = level, probe_calls++; }
+inline void limit() { limit_calls++; }
+inline void index_pulse() { index_calls++; }
+
+using encoder = firmware::quadrature<in<14>, in<15>>;
+using table   = firmware::interrupts<firmware::on_change<in<4>, &probe>, firmware::on_fall<in<9>, &limit>, encoder,
+                                     firmware::on_external<in<2>, InterruptSense::FALLING, &index_pulse>>;
+
+static_assert(table::mask_b == 0x02 && table::mask_c == 0x03 && table::mask_d == 0x10, "INT0 stays off PCMSK2");
+
+/// A and B of the encoder on PC0 / PC1, the other PINC bits as given
+inline void turn(uint8_t ab) { reg(PINC) = static_cast<uint8_t>((reg(PINC) & ~0x03) | (ab >> 1 & 1) | (ab & 1) << 1); }
+
+inline void clear_counts() { probe_calls = limit_calls = index_calls = 0; }
+
+} // namespace msd_interrupts_test
+
+using namespace msd_interrupts_test;
+
+// Test init enables exactly the bound pins on their ports and INT0 with its edge
+void test_interrupts_init() {
+    reset();
+    table::init();
+    TEST_ASSERT_EQUAL_HEX8(0x02, reg(PCMSK0));
+    TEST_ASSERT_EQUAL_HEX8(0x03, reg(PCMSK1));
+    TEST_ASSERT_EQUAL_HEX8(0x10, reg(PCMSK2));
+    TEST_ASSERT_EQUAL_HEX8(0x07, reg(PCICR));
+    TEST_ASSERT_EQUAL_HEX8(0x02, reg(EICRA)); // ISC01, falling
+    TEST_ASSERT_EQUAL_HEX8(0x01, reg(EIMSK));
+    TEST_ASSERT_EQUAL_HEX8(0x10, reg(PORTD) & 0x10); // pull-ups of the bound pins
+}
+
+// Test a vector calls only the handlers whose pins changed, edge handlers only on their edge
+void test_interrupts_dispatch() {
+    reset();
+    reg(PIND) = 0x10, reg(PINB) = 0x02;
+    table::init();
+    clear_counts();
+
+    reg(PIND) = 0x18; // D3 is not bound
+    table::on_port<details::PIND_ADDR>();
+    TEST_ASSERT_EQUAL(0, probe_calls);
+    reg(PIND) = 0x08;
+    table::on_port<details::PIND_ADDR>();
+    TEST_ASSERT_EQUAL(1, probe_calls);
+    TEST_ASSERT_FALSE(probe_level);
+
+    reg(PINB) = 0x00; // D9 falls
+    table::on_port<details::PINB_ADDR>();
+    reg(PINB) = 0x02; // and rises
+    table::on_port<details::PINB_ADDR>();
+    reg(PINB) = 0x22; // D13 is not bound
+    table::on_port<details::PINB_ADDR>();
+    TEST_ASSERT_EQUAL(1, limit_calls);
+
+    table::on_int0();
+    table::on_int1(); // nothing on INT1
+    TEST_ASSERT_EQUAL(1, index_calls);
+    TEST_ASSERT_EQUAL(1, probe_calls);
+}
+
+// Test the encoder counts 4 a line both ways and tallies transitions it could not follow
+void test_interrupts_quadrature() {
+    reset();
+    table::init();
+    encoder::set_position(0);
+    const uint8_t forward[] = { 0b10, 0b11, 0b01, 0b00 }; // A leads B
+    for (int line = 0; line < 100; line++)
+        for (uint8_t ab : forward) turn(ab), table::on_port<details::PINC_ADDR>();
+    TEST_ASSERT_EQUAL(400, encoder::position());
+
+    for (int line = 0; line < 30; line++)
+        for (int i = 3; i >= 0; i--) turn(forward[(i + 3) & 3]), table::on_port<details::PINC_ADDR>();
+    TEST_ASSERT_EQUAL(280, encoder::position());
+    TEST_ASSERT_EQUAL(0, encoder::errors());
+
+    // 00 -> 11 skips a state
+    turn(0b00), table::on_port<details::PINC_ADDR>();
+    turn(0b11), table::on_port<details::PINC_ADDR>();
+    TEST_ASSERT_EQUAL(280, encoder::position());
+    TEST_ASSERT_EQUAL(1, encoder::errors());
+
+    // a change on another PORTC pin is not an edge
+    reg(PINC) |= 0x20;
+    table::on_port<details::PINC_ADDR>();
+    TEST_ASSERT_EQUAL(280, encoder::position());
+}
+
+// ==================== 性能测试 ====================
+
+// Encoder edge decoded through the table against the usual if-else, on a shaky shaft that
+// changes direction at random so the branches can not be predicted
+void test_interrupts_performance() {
+    reset();
+    table::init();
+    encoder::set_position(0);
+    uint16_t errors = encoder::errors();
+#ifndef ARDUINO
+    constexpr uint32_t n = 4096;
+    const int rounds     = 2000;
+#else
+    constexpr uint32_t n = 256;
+    const int rounds     = 4;
+#endif
+    static uint8_t port[n + 3];
+    const uint8_t forward[] = { 0b10, 0b11, 0b01, 0b00 };
+    uint32_t seed = 12345, m = 0;
+    uint8_t phase = 3; // AB = 00, where init() left the encoder
+    // a random walk, then forward back to 00 so the rounds join up
+    while (m < n || phase != 3) {
+        seed      = seed * 1103515245u + 12345u;
+        phase     = static_cast<uint8_t>((phase + (m >= n || (seed >> 16) & 1 ? 1 : 3)) & 3);
+        port[m++] = static_cast<uint8_t>((forward[phase] >> 1 & 1) | (forward[phase] & 1) << 1);
+    }
+
+    unsigned long start = micros();
+    for (int r = 0; r < rounds; r++)
+        for (uint32_t i = 0; i < m; i++) encoder::fire(port[i]);
+    unsigned long table_us = micros() - start;
+
+    // compare A with the old B to tell the direction
+    volatile int32_t pos = 0;
+    uint8_t last         = 0;
+    start                = micros();
+    for (int r = 0; r < rounds; r++) {
+        for (uint32_t i = 0; i < m; i++) {
+            uint8_t now = port[i] & 0x03;
+            if (now != last) {
+                bool a = now & 0x01, b_old = last & 0x02;
+                if (a != b_old) pos = pos + 1;
+                else pos = pos - 1;
+            }
+            last = now;
+        }
+    }
+    unsigned long branch_us = micros() - start;
+
+    TEST_ASSERT_EQUAL(pos, encoder::position());
+    TEST_ASSERT_EQUAL(errors, encoder::errors());
+    bench_report("quadrature edge, table, ns", table_us * 1000.0 / (m * rounds), "ns");
+    bench_report("quadrature edge, if-else, ns", branch_us * 1000.0 / (m * rounds), "ns");
+}
+
+void test_interrupts() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_interrupts_init);
+    RUN_TEST(test_interrupts_dispatch);
+    RUN_TEST(test_interrupts_quadrature);
+
+    RUN_TEST(test_interrupts_performance);
+
+    UNITY_END();
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include <arduino/logger/log_binary.hpp>
+#ifndef ARDUINO
+#include <arduino/logger/log_decoder.hpp>
+#endif
+
+#include "test_bench.hpp"
+
+namespace msd_log_binary_test {
+
+using firmware::log_frame;
+namespace log = firmware::__details;
+
+constexpr uint8_t WARN = 2, INFO = 3;
+
+// the checks FIRMWARE_LOG_BIN makes
+static_assert(log::__log_count("x=%d y=%5.2f %s %%") == 3, "");
+static_assert(log::__log_kinds("%ld %lu %f %s %c") == (1 | 0 << 2 | 2 << 4 | 3 << 6 | 0 << 8), "");
+static_assert(log::__log_check("%d %u", decltype(log::__log_sig(uint8_t(1), -1L)){}), "any integer for an integer");
+static_assert(log::__log_check("%s=%.1f", decltype(log::__log_sig("v", 1.5f)){}), "");
+static_assert(!log::__log_check("%d", decltype(log::__log_sig(1.5)){}), "float for %d");
+static_assert(!log::__log_check("%s", decltype(log::__log_sig(1)){}), "integer for %s");
+static_assert(!log::__log_check("%d %d", decltype(log::__log_sig(1)){}), "too few");
+static_assert(!log::__log_check("%p", decltype(log::__log_sig("")){}), "not sent");
+static_assert(log::__log_id("motor %u stalled") != log::__log_id("motor %u stalle"), "");
+
+/// a log target writing frames to memory, the clock set by hand
+struct capture {
+    uint8_t bytes[1024];
+    size_t size   = 0;
+    uint32_t now  = 0;
+
+    template <uint32_t Kinds, uint16_t Id, typename L, typename... Args>
+    void log_binary(L level, Args... args) {
+        log_frame f;
+        if (!f.encode<Kinds>(static_cast<uint8_t>(level), Id, now, args...)) return;
+        memcpy(bytes + size, f.data(), f.size());
+        size += f.size();
+    }
+};
+
+#ifndef ARDUINO
+// the string table: every FIRMWARE_LOG_BIN format of this binary
+extern "C" const char __start_fwlog[];
+extern "C" const char __stop_fwlog[];
+
+inline firmware::log_decoder decoder;
+
+/// decode the next line of a capture
+inline const char* next(const capture& c, size_t& at) {
+    static char text[128];
+    size_t end = at;
+    while (end < c.size && c.bytes[end] != '\n') end++;
+    bool ok = decoder.decode(c.bytes + at, end - at, text, sizeof(text));
+    at      = end + 1;
+    return ok ? text : "<undecodable>";
+}
+#endif
+
+} // namespace msd_log_binary_test
+
+using namespace msd_log_binary_test;
+
+// Test a frame is the mark, the id, the time and the arguments, one '\n' at the end
+void test_log_binary_frame() {
+    log_frame f;
+    TEST_ASSERT_TRUE(f.encode<log::__log_kinds("%u %d")>(WARN, 0x1234, 300, 5u, -3));
+    const uint8_t want[] = { 0x12, 0x34, 0x12, 0xAC, 0x02, 5, 5, '\n' };
+    TEST_ASSERT_EQUAL(sizeof(want), f.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(want, f.data(), sizeof(want));
+
+    // '\n' and the escape byte inside are escaped, so the last byte is the only '\n'
+    TEST_ASSERT_TRUE(f.encode<log::__log_kinds("%u %u %s")>(INFO, 0x0A7D, 10, 10u, 0x7Du, "a\nb"));
+    const uint8_t escaped[] = { 0x13, 0x7D, 0x5D, 0x7D, 0x2A, 0x7D, 0x2A, 0x7D, 0x2A, 0x7D, 0x5D, 3, 'a', 0x7D, 0x2A, 'b', '\n' };
+    TEST_ASSERT_EQUAL(sizeof(escaped), f.size());
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(escaped, f.data(), sizeof(escaped));
+
+    // too long for a frame: not sent
+    TEST_ASSERT_FALSE(f.encode<log::__log_kinds("%s")>(INFO, 1, 0, "0123456789012345678901234567890123456789012345678901234567"));
+}
+
+#ifndef ARDUINO
+// Test the decoder gives back the text line of every message, with the format only in the table
+void test_log_binary_round_trip() {
+    decoder = firmware::log_decoder();
+    TEST_ASSERT_GREATER_OR_EQUAL(4, decoder.load(__start_fwlog, static_cast<size_t>(__stop_fwlog - __start_fwlog)));
+    TEST_ASSERT_EQUAL(0, decoder.collisions());
+
+    capture c;
+    c.now = 1500;
+    FIRMWARE_LOG_BIN_TO(c, WARN, "motor %u stalled", 2);
+    c.now = 1502;
+    FIRMWARE_LOG_BIN_TO(c, INFO, "pos=%ld err=%+d v=%.2f", -123456L, -7, 1.25f);
+    c.now = 61000;
+    FIRMWARE_LOG_BIN_TO(c, INFO, "cmd '%s' [%c] 0x%04X 100%%", "G1\nX5", 'k', 0x7Du);
+    FIRMWARE_LOG_BIN_TO(c, 4, "ready");
+
+    size_t at = 0;
+    TEST_ASSERT_EQUAL_STRING("[1.500][ WARN]motor 2 stalled", next(c, at));
+    TEST_ASSERT_EQUAL_STRING("[1.502][ INFO]pos=-123456 err=-7 v=1.25", next(c, at));
+    TEST_ASSERT_EQUAL_STRING("[61.000][ INFO]cmd 'G1\nX5' [k] 0x007D 100%", next(c, at));
+    TEST_ASSERT_EQUAL_STRING("[61.000][DEBUG]ready", next(c, at));
+    TEST_ASSERT_EQUAL(c.size, at);
+
+    // a text line and a cut frame are not decoded, the next frame still is
+    const uint8_t text[] = "[1.000][ INFO]hello";
+    char out[64];
+    TEST_ASSERT_FALSE(decoder.decode(text, sizeof(text) - 1, out, sizeof(out)));
+    TEST_ASSERT_FALSE(decoder.decode(c.bytes, 5, out, sizeof(out)));
+    at = 0;
+    TEST_ASSERT_EQUAL_STRING("[1.500][ WARN]motor 2 stalled", next(c, at));
+
+    // the first three frames lost, or a capture joined late: the last one still has the device's time
+    at = 0;
+    for (int lost = 0; lost < 3; at++)
+        if (c.bytes[at] == '\n') lost++;
+    TEST_ASSERT_EQUAL_STRING("[61.000][DEBUG]ready", next(c, at));
+}
+
+// Test formats seen twice are kept once and unknown ids are refused
+void test_log_binary_table() {
+    firmware::log_decoder d;
+    const char table[] = "a %u\0\0\0\0b %s\0a %u\0";
+    TEST_ASSERT_EQUAL(2, d.load(table, sizeof(table) - 1));
+    TEST_ASSERT_EQUAL(0, d.collisions());
+    TEST_ASSERT_EQUAL_STRING("b %s", d.find(log::__log_id("b %s")));
+    TEST_ASSERT_NULL(d.find(log::__log_id("c")));
+
+    capture c;
+    FIRMWARE_LOG_BIN_TO(c, INFO, "not in that table %u", 1u);
+    char out[64];
+    TEST_ASSERT_FALSE(d.decode(c.bytes, c.size - 1, out, sizeof(out)));
+}
+#endif
+
+// ==================== 性能测试 ====================
+
+// Bytes on the wire and time in the log call, a binary frame against the text line snprintf builds
+void test_log_binary_performance() {
+#ifndef ARDUINO
+    const uint32_t n = 1000000;
+#else
+    const uint32_t n = 1000;
+#endif
+    log_frame f;
+    volatile uint16_t axis = 2;
+    volatile int32_t pos   = -123456;
+    unsigned long start    = micros();
+    for (uint32_t i = 0; i < n; i++) f.encode<log::__log_kinds("axis %u stalled at %ld")>(WARN, 0x5A5A, 12345, axis, pos);
+    unsigned long binary_us = micros() - start;
+    size_t binary           = f.size();
+
+    char line[64];
+    int text = 0;
+    start    = micros();
+    for (uint32_t i = 0; i < n; i++)
+        text = snprintf(line, sizeof(line), "[%lu.%03lu][%s]axis %u stalled at %ld\n", 12ul, 345ul, " WARN", static_cast<unsigned>(axis), static_cast<long>(pos));
+    unsigned long text_us = micros() - start;
+    bench_keep(line);
+
+    TEST_ASSERT_EQUAL(10, binary); // 12345 ms takes two varint bytes
+    bench_report("binary frame, bytes", binary, "B");
+    bench_report("text line, bytes", text, "B");
+    bench_report("bandwidth saved, x", static_cast<double>(text) / binary, "x");
+    bench_report("binary encode, ns per message", binary_us * 1000.0 / n, "ns");
+    bench_report("snprintf, ns per message", text_us * 1000.0 / n, "ns");
+}
+
+void test_log_binary() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_log_binary_frame);
+#ifndef ARDUINO
+    RUN_TEST(test_log_binary_round_trip);
+    RUN_TEST(test_log_binary_table);
+#endif
+
+    RUN_TEST(test_log_binary_performance);
+
+    UNITY_END();
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <string.h>
+#include <unity.h>
+
+#include <arduino/logger/log_buffer.hpp>
+
+#include "test_bench.hpp"
+
+namespace msd_log_buffer_test {
+
+using firmware::log_buffer;
+using firmware::LogOverflow;
+
+template <size_t N>
+inline bool put(log_buffer<N>& b, const char* line) {
+    return b.write(line, strlen(line));
+}
+
+/// everything queued, as a string
+template <size_t N>
+inline const char* drain(log_buffer<N>& b) {
+    static char out[512];
+    size_t n = 0, got;
+    // small pieces, like a UART drain would take them
+    while ((got = b.read(out + n, 5)) != 0) n += got;
+    out[n] = '\0';
+    return out;
+}
+
+// the BLOCK wait hook: a drain that takes one byte a call, like a slow UART
+inline log_buffer<32>* slow_buffer = nullptr;
+inline uint32_t waits              = 0;
+inline char sent[256];
+inline size_t sent_len = 0;
+inline void slow_drain() { waits++, sent_len += slow_buffer->read(sent + sent_len, 1); }
+
+} // namespace msd_log_buffer_test
+
+using namespace msd_log_buffer_test;
+
+// Test messages come out whole and in order across the end of the storage
+void test_log_buffer_order() {
+    log_buffer<32> b;
+    TEST_ASSERT_TRUE(put(b, "[0.001][ INFO]a\n"));
+    TEST_ASSERT_EQUAL_STRING("[0.001][ INFO]a\n", drain(b));
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(put(b, "one\n"));
+        TEST_ASSERT_TRUE(put(b, "two two\n"));
+        TEST_ASSERT_EQUAL_STRING("one\ntwo two\n", drain(b));
+    }
+    TEST_ASSERT_TRUE(b.empty());
+    TEST_ASSERT_EQUAL(0, b.dropped());
+}
+
+// Test drop-newest keeps the queue and drop-oldest makes room by whole messages
+void test_log_buffer_overflow() {
+    log_buffer<16> b;
+    TEST_ASSERT_TRUE(put(b, "aaaaa\n"));
+    TEST_ASSERT_TRUE(put(b, "bbbbb\n"));
+    TEST_ASSERT_FALSE(put(b, "ccccc\n"));
+    TEST_ASSERT_EQUAL(1, b.dropped());
+    TEST_ASSERT_EQUAL_STRING("aaaaa\nbbbbb\n", drain(b));
+
+    b.set_policy(LogOverflow::DROP_OLDEST);
+    put(b, "aaaaa\n"), put(b, "bb\n"), put(b, "cc\n");
+    TEST_ASSERT_TRUE(put(b, "dddddddd\n")); // 9 bytes, 4 free: aaaaa goes
+    TEST_ASSERT_EQUAL(2, b.dropped());
+    TEST_ASSERT_TRUE(put(b, "eeeee\n")); // 6 bytes, 1 free: bb and cc go
+    TEST_ASSERT_EQUAL(4, b.dropped());
+    TEST_ASSERT_EQUAL_STRING("dddddddd\neeeee\n", drain(b));
+
+    // longer than the whole buffer, never fits
+    TEST_ASSERT_FALSE(put(b, "0123456789abcdefg\n"));
+    TEST_ASSERT_EQUAL(5, b.dropped());
+    b.reset_dropped();
+    TEST_ASSERT_EQUAL(0, b.dropped());
+}
+
+// Test block waits on the drain until the message fits, and loses nothing
+void test_log_buffer_block() {
+    log_buffer<32> b;
+    slow_buffer = &b;
+    waits = sent_len = 0;
+    b.set_policy(LogOverflow::BLOCK, &slow_drain);
+    for (int i = 0; i < 8; i++) TEST_ASSERT_TRUE(put(b, "0123456789\n"));
+    TEST_ASSERT_EQUAL(0, b.dropped());
+    TEST_ASSERT_EQUAL(8 * 11 - 32, waits); // room for the lines past the first 32 bytes, one byte a call
+    sent_len += b.read(sent + sent_len, sizeof(sent) - sent_len);
+    sent[sent_len] = '\0';
+    TEST_ASSERT_EQUAL(8 * 11, sent_len);
+    for (int i = 0; i < 8; i++) TEST_ASSERT_EQUAL_MEMORY("0123456789\n", sent + 11 * i, 11);
+}
+
+// Test a message appended in pieces shows up whole on commit, or not at all when it runs out of room
+void test_log_buffer_stream() {
+    log_buffer<16> b;
+    b.begin();
+    b.append("[1.000]", 7);
+    b.put('x');
+    TEST_ASSERT_TRUE(b.empty()); // nothing readable before commit
+    b.put('\n');
+    TEST_ASSERT_TRUE(b.commit());
+    TEST_ASSERT_EQUAL_STRING("[1.000]x\n", drain(b));
+
+    put(b, "aaaaaaaaaaaa\n");
+    b.begin();
+    b.append("bbbb", 4); // 3 free
+    b.put('\n');
+    TEST_ASSERT_FALSE(b.commit());
+    TEST_ASSERT_EQUAL(1, b.dropped());
+    TEST_ASSERT_EQUAL_STRING("aaaaaaaaaaaa\n", drain(b));
+
+    b.set_policy(LogOverflow::DROP_OLDEST);
+    put(b, "aaaaaaaaaa\n");
+    b.begin();
+    b.append("bbbbbbb", 7); // the queued line goes
+    b.put('\n');
+    TEST_ASSERT_TRUE(b.commit());
+    TEST_ASSERT_EQUAL(2, b.dropped());
+    TEST_ASSERT_EQUAL_STRING("bbbbbbb\n", drain(b));
+}
+
+// ==================== 性能测试 ====================
+
+// A burst of log lines: queued against waiting for the UART at 115200 baud
+void test_log_buffer_performance() {
+#ifndef ARDUINO
+    static log_buffer<1024> b;
+    const uint32_t n = 1000000;
+#else
+    static log_buffer<256> b;
+    const uint32_t n = 1000;
+#endif
+    const char line[] = "[12.345][ WARN]motor 2 stalled\n"; // 31 bytes
+    const size_t len  = sizeof(line) - 1;
+    char sink[64];
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < n; i++) {
+        b.write(line, len);
+        if (b.size() > b.capacity / 2) bench_keep(b.read(sink, sizeof(sink)));
+    }
+    unsigned long us = micros() - start;
+    TEST_ASSERT_EQUAL(0, b.dropped());
+
+    // once Serial's 64-byte TX buffer is full, a synchronous print waits 10 bits a byte
+    bench_report("async log call, ns per line", us * 1000.0 / n, "ns");
+    bench_report("blocking log call at 115200, us per line", len * 10 * 1e6 / 115200, "us");
+    bench_report("burst of 20 lines, caller blocked, ms", (20 * len - 64) * 10 * 1e3 / 115200, "ms");
+}
+
+void test_log_buffer() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_log_buffer_order);
+    RUN_TEST(test_log_buffer_overflow);
+    RUN_TEST(test_log_buffer_block);
+    RUN_TEST(test_log_buffer_stream);
+
+    RUN_TEST(test_log_buffer_performance);
+
+    UNITY_END();
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdio.h>
+#include <unity.h>
+
+#include <arduino/logger/log_binary.hpp>
+#include <arduino/logger/log_level.hpp>
+
+#include "test_bench.hpp"
+#include "test_log_binary.hpp"
+
+namespace msd_log_level_test {
+
+using firmware::is_compiled;
+using firmware::is_enabled;
+using firmware::Level;
+
+} // namespace msd_log_level_test
+
+using namespace msd_log_level_test;
+
+// Test the compiled-in levels come from FIRMWARE_LOG_LEVEL and the runtime level filters the rest
+void test_log_level_filter() {
+    TEST_ASSERT_EQUAL(FIRMWARE_LOG_LEVEL, static_cast<int>(firmware::compiled_level));
+    TEST_ASSERT_EQUAL(FIRMWARE_LOG_LEVEL >= 4, is_compiled(Level::DEBUG));
+    TEST_ASSERT_EQUAL(FIRMWARE_LOG_LEVEL >= 0, is_compiled(Level::FATAL));
+    TEST_ASSERT_FALSE(is_compiled(Level::DISABLE)); // not a level a message can have
+
+    TEST_ASSERT_EQUAL(is_compiled(Level::WARN), is_enabled(Level::WARN, Level::INFO));
+    TEST_ASSERT_FALSE(is_enabled(Level::DEBUG, Level::INFO));
+    TEST_ASSERT_FALSE(is_enabled(Level::FATAL, Level::DISABLE));
+}
+
+#ifndef ARDUINO
+// Test a message that is not compiled in leaves neither a call nor its format behind
+void test_log_level_elimination() {
+    capture c;
+    FIRMWARE_LOG_BIN_TO(c, Level::DISABLE, "compiled out %u", 1u);
+    TEST_ASSERT_EQUAL(0, c.size);
+
+    firmware::log_decoder d;
+    d.load(__start_fwlog, static_cast<size_t>(__stop_fwlog - __start_fwlog));
+    TEST_ASSERT_NULL(d.find(firmware::__details::__log_id("compiled out %u")));
+    TEST_ASSERT_NOT_NULL(d.find(firmware::__details::__log_id("motor %u stalled")));
+}
+#endif
+
+// ==================== 性能测试 ====================
+
+// A debug call under a runtime level of INFO: formatted and then dropped, as before, against
+// the level checked first
+void test_log_level_performance() {
+#ifndef ARDUINO
+    const uint32_t n = 1000000;
+#else
+    const uint32_t n = 1000;
+#endif
+    volatile Level runtime = Level::INFO;
+    volatile int32_t pos   = -123456;
+    char buf[64];
+    uint32_t sent = 0;
+
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < n; i++) {
+        snprintf(buf, sizeof(buf), "pos %ld", static_cast<long>(pos));
+        if (is_enabled(Level::DEBUG, runtime)) sent++;
+    }
+    unsigned long format_first_us = micros() - start;
+    bench_keep(buf);
+
+    start = micros();
+    for (uint32_t i = 0; i < n; i++) {
+        if (!is_enabled(Level::DEBUG, runtime)) continue;
+        snprintf(buf, sizeof(buf), "pos %ld", static_cast<long>(pos));
+        sent++;
+    }
+    unsigned long check_first_us = micros() - start;
+
+    TEST_ASSERT_EQUAL(0, sent);
+    bench_report("disabled debug, formatted first, ns", format_first_us * 1000.0 / n, "ns");
+    bench_report("disabled debug, level first, ns", check_first_us * 1000.0 / n, "ns");
+}
+
+void test_log_level() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_log_level_filter);
+#ifndef ARDUINO
+    RUN_TEST(test_log_level_elimination);
+#endif
+
+    RUN_TEST(test_log_level_performance);
+
+    UNITY_END();
+}
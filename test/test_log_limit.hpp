@@ -0,0 +1,200 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include <arduino/logger/log_limit.hpp>
+#include <format>
+
+#include "test_bench.hpp"
+
+namespace msd_log_limit_test {
+
+using firmware::Level;
+using firmware::log_key;
+using firmware::log_rate;
+using firmware::log_repeat;
+using namespace msd::literals;
+
+/// a log target keeping its lines, filtered by the logger's own log_filter
+struct lines {
+    char text[2048];
+    msd::memory_sink out{ text };
+    uint32_t now  = 0;
+    uint16_t sent = 0;
+    firmware::log_filter filter;
+
+    // what log_filter writes a line through
+    void begin_line(Level) { sent++; }
+    void put(char c) { out.put(c); }
+    void write(const char* s, size_t len) { out.write(s, len); }
+    void end_line() { out.put('\n'); }
+
+    // what the logger forwards to it
+    template <char... Cs, typename... Args>
+    void line(Level level, msd::fmt_string<Cs...> fmt, Args... args) {
+        filter.line(*this, now, level, fmt, args...);
+    }
+    template <typename Rate, char... Cs, typename... Args>
+    void log_limited(Rate& rate, Level level, msd::fmt_string<Cs...> fmt, Args... args) {
+        filter.limited(*this, rate, now, level, fmt, args...);
+    }
+    const char* c_str() {
+        out.put('\0');
+        return text;
+    }
+};
+
+/// one call site, the same every time it is called
+inline void fault(lines& l, int id) { FIRMWARE_LOG_LIMITED_TO(l, Level::WARN, 2, 100, "fault {}"_fmt, id); }
+
+} // namespace msd_log_limit_test
+
+using namespace msd_log_limit_test;
+
+// Test the bucket: a burst, then one per period, and a full bucket again after a long quiet
+void test_log_limit_rate() {
+    static log_rate<3, 100> rate; // all zero, as at a call site
+    uint16_t passed = 0;
+    for (uint32_t t = 5000; t < 5010; t++) passed += rate.allow(t);
+    TEST_ASSERT_EQUAL(3, passed);
+    TEST_ASSERT_EQUAL(7, rate.take_suppressed());
+    TEST_ASSERT_EQUAL(0, rate.take_suppressed());
+
+    TEST_ASSERT_FALSE(rate.allow(5099));
+    TEST_ASSERT_TRUE(rate.allow(5100)); // one token per 100 ms
+    TEST_ASSERT_FALSE(rate.allow(5150));
+    TEST_ASSERT_TRUE(rate.allow(5200));
+
+    passed = 0;
+    for (uint32_t t = 90000; t < 90010; t++) passed += rate.allow(t); // quiet for longer than 16 bits of ms
+    TEST_ASSERT_EQUAL(3, passed);
+
+    log_rate<1, 10> wrap{}; // across the wrap of millis()
+    TEST_ASSERT_TRUE(wrap.allow(0xFFFFFFF0u));
+    TEST_ASSERT_FALSE(wrap.allow(0xFFFFFFF5u));
+    TEST_ASSERT_TRUE(wrap.allow(4));
+}
+
+// Test the macro keeps one bucket per call site and reports what it held back
+void test_log_limit_sites() {
+    static lines l;
+    for (int i = 0; i < 50; i++) fault(l, i);
+    TEST_ASSERT_EQUAL(2, l.sent);
+    l.now = 100;
+    fault(l, 99);
+    TEST_ASSERT_EQUAL_STRING("fault 0\nfault 1\nfault 99 (48 suppressed)\n", l.c_str());
+
+    // another site has a bucket of its own
+    FIRMWARE_LOG_LIMITED_TO(l, Level::WARN, 1, 100, "other"_fmt);
+    TEST_ASSERT_EQUAL(4, l.sent);
+    FIRMWARE_LOG_LIMITED_TO(l, Level::DISABLE, 1, 100, "compiled out"_fmt);
+    TEST_ASSERT_EQUAL(4, l.sent);
+}
+
+// Test consecutive equal messages are counted once coalescing is on, and what counts as equal
+void test_log_limit_repeat() {
+    static lines l;
+    for (int i = 0; i < 3; i++) l.line(Level::INFO, "status {}"_fmt, 1); // off by default: all sent
+    TEST_ASSERT_EQUAL(3, l.sent);
+    TEST_ASSERT_FALSE(l.filter.is_coalescing());
+
+    l.filter.set_coalesce(l, true);
+    for (int i = 0; i < 1000; i++) l.line(Level::WARN, "sensor {} fault {}"_fmt, 3, -1);
+    l.line(Level::WARN, "sensor {} fault {}"_fmt, 4, -1); // another argument
+    l.line(Level::ERROR, "sensor {} fault {}"_fmt, 4, -1); // another level
+    l.line(Level::ERROR, "sensor {} fault {}"_fmt, 4, -1);
+    l.line(Level::ERROR, "name {}"_fmt, "abc");
+    char name[] = "abc";
+    l.line(Level::ERROR, "name {}"_fmt, static_cast<const char*>(name)); // the same text elsewhere
+    name[2] = 'd';
+    l.line(Level::ERROR, "name {}"_fmt, static_cast<const char*>(name));
+    TEST_ASSERT_EQUAL_STRING("status 1\nstatus 1\nstatus 1\n"
+                             "sensor 3 fault -1\nlast message repeated 999 times\nsensor 4 fault -1\nsensor 4 fault -1\n"
+                             "last message repeated 1 times\nname abc\nlast message repeated 1 times\nname abd\n",
+                             l.c_str());
+}
+
+// Test a repeat goes out again after FIRMWARE_LOG_REPEAT_MS, and pending repeats at flush and switch-off
+void test_log_limit_repeat_flush() {
+    static lines l;
+    l.filter.set_coalesce(l, true);
+    for (l.now = 0; l.now < 25000; l.now += 1000) l.line(Level::INFO, "status {}"_fmt, 1); // once a second
+    l.filter.flush(l);
+    l.line(Level::INFO, "status {}"_fmt, 1); // after flush, never a repeat
+    l.line(Level::INFO, "status {}"_fmt, 1);
+    l.filter.set_coalesce(l, false);
+    TEST_ASSERT_EQUAL_STRING("status 1\nlast message repeated 9 times\nstatus 1\nlast message repeated 9 times\nstatus 1\n"
+                             "last message repeated 4 times\nstatus 1\nlast message repeated 1 times\n",
+                             l.c_str());
+    TEST_ASSERT_FALSE(l.filter.is_coalescing());
+}
+
+// Test the key and the count on their own
+void test_log_limit_key() {
+    // more argument bytes than a key holds: never a repeat
+    log_key big(nullptr, Level::INFO, 1.0, 2.0);
+    TEST_ASSERT_FALSE(big == big);
+    TEST_ASSERT_FALSE(log_key() == log_key());
+    log_repeat r;
+    r.replace(log_key(nullptr, Level::INFO, 7));
+    for (uint32_t i = 0; i < 0xFFFF; i++) r.repeat(log_key(nullptr, Level::INFO, 7));
+    TEST_ASSERT_EQUAL(0xFFFF, r.count());
+    TEST_ASSERT_FALSE(r.repeat(log_key(nullptr, Level::INFO, 7))); // saturated: goes out to report
+}
+
+// ==================== 性能测试 ====================
+
+// A flood from one site: a suppressed call, by the bucket and as a repeat, against formatting it
+void test_log_limit_performance() {
+#ifndef ARDUINO
+    const uint32_t n = 1000000;
+#else
+    const uint32_t n = 1000;
+#endif
+    static log_rate<1, 1000> rate;
+    rate.allow(0);
+    volatile int id = 3;
+    uint32_t passed = 0;
+
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < n; i++) passed += rate.allow(i / 4096);
+    unsigned long rate_us = micros() - start;
+
+    log_repeat last;
+    last.replace(log_key(nullptr, Level::WARN, 3));
+    start = micros();
+    uint32_t reported = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        log_key key(nullptr, Level::WARN, static_cast<int>(id));
+        if (!last.repeat(key)) last.replace(key), reported++; // every 65536th, to report the count
+    }
+    unsigned long repeat_us = micros() - start;
+
+    char buf[32];
+    start = micros();
+    for (uint32_t i = 0; i < n; i++) msd::format_to(buf, "sensor {} fault"_fmt, static_cast<int>(id));
+    unsigned long format_us = micros() - start;
+    bench_keep(buf);
+
+    TEST_ASSERT_EQUAL(0, passed);
+    TEST_ASSERT_EQUAL(n / 0x10000, reported);
+    bench_report("rate-limited call, ns", rate_us * 1000.0 / n, "ns");
+    bench_report("coalesced repeat, ns", repeat_us * 1000.0 / n, "ns");
+    bench_report("the message formatted, ns", format_us * 1000.0 / n, "ns");
+}
+
+void test_log_limit() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_log_limit_rate);
+    RUN_TEST(test_log_limit_sites);
+    RUN_TEST(test_log_limit_repeat);
+    RUN_TEST(test_log_limit_repeat_flush);
+    RUN_TEST(test_log_limit_key);
+
+    RUN_TEST(test_log_limit_performance);
+
+    UNITY_END();
+}
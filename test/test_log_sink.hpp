@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include <arduino/logger/log_sink.hpp>
+#include <format>
+
+#include "test_bench.hpp"
+
+namespace msd_log_sink_test {
+
+using firmware::log_to;
+using firmware::ram_sink;
+using namespace msd::literals;
+
+/// a sink with a limited room, as Serial's TX buffer
+struct small_sink {
+    char text[64];
+    size_t size  = 0;
+    size_t space = 64;
+    void put(char c) { text[size++] = c; }
+    void write(const char* s, size_t len) { memcpy(text + size, s, len), size += len; }
+    size_t room() const { return space; }
+};
+
+/// the same sink behind a virtual interface, for the benchmark
+struct virtual_sink {
+    virtual void write(const char* s, size_t len) = 0;
+};
+template <size_t N>
+struct virtual_ram : virtual_sink {
+    ram_sink<N>& ram;
+    explicit virtual_ram(ram_sink<N>& r) : ram(r) {}
+    void write(const char* s, size_t len) override { ram.write(s, len); }
+};
+
+inline ram_sink<16> ring; // static storage, all zero like .noinit after a clear
+inline ram_sink<64> big;
+inline small_sink small;
+
+/// what a ram_sink holds, oldest first, as a string
+template <size_t N>
+inline const char* held(const ram_sink<N>& r) {
+    static char text[128];
+    text[0] = '\0';
+    msd::memory_sink out(text);
+    r.dump(out);
+    return out.c_str();
+}
+
+} // namespace msd_log_sink_test
+
+using namespace msd_log_sink_test;
+
+// Test the RAM ring keeps the last bytes, and tells a warm reset's log from noise
+void test_log_sink_ram() {
+    TEST_ASSERT_FALSE(ring.begin()); // all zero: not a log
+    msd::format(ring, "motor {} stalled\n"_fmt, 2);
+    TEST_ASSERT_EQUAL(16, ring.size());
+    TEST_ASSERT_EQUAL_STRING("motor 2 stalled\n", held(ring));
+    ring.write("abcdef", 6);
+    TEST_ASSERT_EQUAL_STRING("2 stalled\nabcdef", held(ring)); // the oldest went first
+    ring.write("0123456789abcdefXYZ", 19);
+    TEST_ASSERT_EQUAL_STRING("3456789abcdefXYZ", held(ring));
+
+    // a warm reset: the bytes are where they were, begin() keeps them
+    TEST_ASSERT_TRUE(ring.begin());
+    TEST_ASSERT_EQUAL_STRING("3456789abcdefXYZ", held(ring));
+
+    // power on: whatever RAM held is not taken for a log
+    static ram_sink<16> noise;
+    memset(static_cast<void*>(&noise), 0xA5, sizeof(noise));
+    noise.put('x'); // before begin(), stays inside the buffer
+    TEST_ASSERT_FALSE(noise.begin());
+    TEST_ASSERT_EQUAL(0, noise.size());
+}
+
+// Test log_to writes every sink and keeps to the least room among them
+void test_log_sink_fan_out() {
+    big.clear();
+    log_to<big, small> both;
+    msd::format(both, "axis {} at {}\n"_fmt, 1, -250);
+    TEST_ASSERT_EQUAL_STRING("axis 1 at -250\n", held(big));
+    TEST_ASSERT_EQUAL(15, small.size);
+    TEST_ASSERT_EQUAL_MEMORY("axis 1 at -250\n", small.text, 15);
+
+    TEST_ASSERT_EQUAL(~static_cast<size_t>(0), (log_to<big>::room())); // no room(): never waits
+    small.space = 12;
+    TEST_ASSERT_EQUAL(12, (log_to<big, small>::room()));
+}
+
+#ifndef ARDUINO
+// Test the stdio sink
+void test_log_sink_file() {
+    FILE* f = tmpfile();
+    TEST_ASSERT_NOT_NULL(f);
+    firmware::file_sink out(f);
+    msd::format(out, "[{}][{}] {}\n"_fmt, "0.005", " WARN", 42);
+    out.flush();
+    rewind(f);
+    char text[32] = {};
+    fread(text, 1, sizeof(text) - 1, f);
+    fclose(f);
+    TEST_ASSERT_EQUAL_STRING("[0.005][ WARN] 42\n", text);
+}
+#endif
+
+// ==================== 性能测试 ====================
+
+// One line into the RAM ring: called directly, through log_to, and through a virtual call
+void test_log_sink_performance() {
+#ifndef ARDUINO
+    const uint32_t n = 1000000;
+#else
+    const uint32_t n = 1000;
+#endif
+    static const char line[] = "[12.345][ WARN] sensor 3 fault\n";
+    const size_t len         = sizeof(line) - 1;
+    big.clear();
+
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < n; i++) big.write(line, len);
+    unsigned long direct_us = micros() - start;
+
+    start = micros();
+    for (uint32_t i = 0; i < n; i++) log_to<big>::write(line, len);
+    unsigned long static_us = micros() - start;
+
+    virtual_ram<64> impl(big);
+    virtual_sink* volatile sink = &impl;
+    start = micros();
+    for (uint32_t i = 0; i < n; i++) sink->write(line, len);
+    unsigned long virtual_us = micros() - start;
+
+    TEST_ASSERT_EQUAL(64, big.size());
+    bench_report("ram_sink called directly, ns per line", direct_us * 1000.0 / n, "ns");
+    bench_report("ram_sink through log_to, ns per line", static_us * 1000.0 / n, "ns");
+    bench_report("ram_sink through a virtual call, ns", virtual_us * 1000.0 / n, "ns");
+}
+
+void test_log_sink() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_log_sink_ram);
+    RUN_TEST(test_log_sink_fan_out);
+#ifndef ARDUINO
+    RUN_TEST(test_log_sink_file);
+#endif
+
+    RUN_TEST(test_log_sink_performance);
+
+    UNITY_END();
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <string.h>
+#include <unity.h>
+
+#include <arduino/logger/logger.hpp>
+#include <format>
+
+#include "test_bench.hpp"
+
+namespace msd_logger_test {
+
+using firmware::Level;
+using firmware::logger;
+using namespace msd::literals;
+
+inline uint32_t now_ms;
+inline uint32_t test_clock() { return now_ms; }
+
+/// the logger on the test clock, everything enabled, and the RAM sink emptied
+inline logger& fresh() {
+    logger& log = logger::instance();
+    log.set_clock(&test_clock);
+    log.init(firmware::BaudRate::BAUD_115200, Level::DEBUG);
+    log.set_level(Level::DEBUG);
+    test_log_ram.clear();
+    return log;
+}
+
+/// what reached the sinks, oldest first
+inline const char* logged() {
+    static char text[600];
+    msd::memory_sink out(text);
+    test_log_ram.dump(out);
+    return out.c_str();
+}
+
+} // namespace msd_logger_test
+
+using namespace msd_logger_test;
+
+// Test a line goes to log_output with its time stamp from the clock hook, and the level filters
+void test_logger_sync() {
+    logger& log = fresh();
+    now_ms      = 12345;
+    log.info("axis {} at {:.1}"_fmt, 2, 1.5);
+    log.warn("plain");
+    log.set_level(Level::WARN);
+    log.info("dropped {}"_fmt, 1);
+    TEST_ASSERT_EQUAL_STRING("[12.345][ INFO]axis 2 at 1.5\n[12.345][ WARN]plain\n", logged());
+}
+
+// Test async lines wait in the buffer for poll(), and a line too long for a stack line is cut
+void test_logger_async() {
+    logger& log = fresh();
+    now_ms      = 7;
+    log.set_async(true);
+    log.info("queued {}"_fmt, 1);
+    log.error("queued {}"_fmt, 2);
+    TEST_ASSERT_EQUAL(0, test_log_ram.size());
+    log.poll();
+    TEST_ASSERT_EQUAL_STRING("[0.007][ INFO]queued 1\n[0.007][ERROR]queued 2\n", logged());
+
+    test_log_ram.clear();
+    char lon[FIRMWARE_LOG_LINE * 2];
+    memset(lon, 'x', sizeof(lon) - 1);
+    lon[sizeof(lon) - 1] = '\0';
+    log.info("{}"_fmt, static_cast<const char*>(lon));
+    log.poll();
+    TEST_ASSERT_EQUAL(FIRMWARE_LOG_LINE, test_log_ram.size());
+    TEST_ASSERT_EQUAL('\n', logged()[FIRMWARE_LOG_LINE - 1]);
+    TEST_ASSERT_EQUAL(0, log.dropped());
+
+    test_log_ram.clear();
+    log.info("left {}"_fmt, 3);
+    log.set_async(false); // flushes
+    TEST_ASSERT_FALSE(log.is_async());
+    TEST_ASSERT_EQUAL_STRING("[0.007][ INFO]left 3\n", logged());
+}
+
+// Test repeats are counted instead of sent, and reported before the next message
+void test_logger_coalesce() {
+    logger& log = fresh();
+    now_ms      = 1000;
+    log.set_coalesce(true);
+    for (int i = 0; i < 4; i++) log.warn("stall {}"_fmt, 3);
+    now_ms = 2000;
+    log.warn("stall {}"_fmt, 4);
+    log.set_coalesce(false);
+    TEST_ASSERT_FALSE(log.is_coalescing());
+    TEST_ASSERT_EQUAL_STRING("[1.000][ WARN]stall 3\n"
+                             "[2.000][ WARN]last message repeated 3 times\n"
+                             "[2.000][ WARN]stall 4\n",
+                             logged());
+}
+
+// ==================== 性能测试 ====================
+
+// Test the cost of an async line, formatted, queued and drained by poll()
+void test_logger_performance() {
+    logger& log = fresh();
+    log.set_async(true);
+    const uint32_t n    = 100000;
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < n; i++) {
+        log.info("axis {} at {}"_fmt, static_cast<int>(i & 3), static_cast<int>(i));
+        log.poll();
+    }
+    unsigned long us = micros() - start;
+    log.set_async(false);
+    TEST_ASSERT_EQUAL(0, log.dropped());
+    bench_report("async line queued and polled, ns", us * 1000.0 / n, "ns");
+}
+
+void test_logger() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_logger_sync);
+    RUN_TEST(test_logger_async);
+    RUN_TEST(test_logger_coalesce);
+
+    RUN_TEST(test_logger_performance);
+
+    UNITY_END();
+}
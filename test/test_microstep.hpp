@@ -0,0 +1,158 @@
+#pragma once
+
+#include <math.h>
+#include <unity.h>
+
+#include <microstep.hpp>
+
+#include "test_bench.hpp"
+
+namespace msd_microstep_test {
+
+using firmware::step_motor::CoilDuty;
+using firmware::step_motor::DriveMode;
+using firmware::step_motor::PhaseSequencer;
+using firmware::step_motor::__details::half_table;
+using firmware::step_motor::__details::sine_positions;
+using firmware::step_motor::__details::sine_table;
+using firmware::step_motor::__details::SINE_POSITIONS;
+
+// the tables are built by the compiler
+static_assert(sine_table<64>().at[0].ap == 255, "cos 0");
+static_assert(sine_table<64>().at[8].ap == 180 && sine_table<64>().at[8].bp == 180, "45 degrees");
+static_assert(half_table().at[1].ap == 255 && half_table().at[1].bp == 255, "A+ B+");
+
+// signed current of coil A and B in duty units
+inline int coil_a(const CoilDuty& d) { return d.ap - d.an; }
+inline int coil_b(const CoilDuty& d) { return d.bp - d.bn; }
+
+inline bool same(const CoilDuty& d, uint8_t ap, uint8_t an, uint8_t bp, uint8_t bn) {
+    return d.ap == ap && d.an == an && d.bp == bp && d.bn == bn;
+}
+
+} // namespace msd_microstep_test
+
+using namespace msd_microstep_test;
+
+// Test the sine table follows cos / sin within one duty count, never drives both ends of a coil, and keeps the current vector constant
+void test_microstep_sine_waveform() {
+    const auto& t = sine_positions;
+    for (size_t i = 0; i < SINE_POSITIONS; i++) {
+        const CoilDuty& d = t.at[i];
+        double th         = 2 * 3.14159265358979 * i / SINE_POSITIONS;
+        TEST_ASSERT_INT_WITHIN(1, lround(255 * cos(th)), coil_a(d));
+        TEST_ASSERT_INT_WITHIN(1, lround(255 * sin(th)), coil_b(d));
+        TEST_ASSERT_TRUE(d.ap == 0 || d.an == 0);
+        TEST_ASSERT_TRUE(d.bp == 0 || d.bn == 0);
+        double magnitude = sqrt(double(coil_a(d)) * coil_a(d) + double(coil_b(d)) * coil_b(d));
+        TEST_ASSERT_DOUBLE_WITHIN(2.0, 255.0, magnitude);
+    }
+}
+
+// Test wave, full and half step walk the classic sequences, wave in the order of the old full step controller
+void test_microstep_square_modes() {
+    PhaseSequencer p;
+    TEST_ASSERT_EQUAL(static_cast<int>(DriveMode::WAVE), static_cast<int>(p.mode()));
+    // A+, B+, A-, B-
+    TEST_ASSERT_TRUE(same(p.current(), 255, 0, 0, 0));
+    p.forward();
+    TEST_ASSERT_TRUE(same(p.current(), 0, 0, 255, 0));
+    p.forward();
+    TEST_ASSERT_TRUE(same(p.current(), 0, 255, 0, 0));
+    p.forward();
+    TEST_ASSERT_TRUE(same(p.current(), 0, 0, 0, 255));
+    p.forward();
+    TEST_ASSERT_TRUE(same(p.current(), 255, 0, 0, 0));
+    p.backward();
+    TEST_ASSERT_TRUE(same(p.current(), 0, 0, 0, 255));
+    p.forward();
+
+    // two coils on at every full step
+    p.set_mode(DriveMode::FULL);
+    for (int i = 0; i < 4; i++, p.forward()) {
+        CoilDuty d = p.current();
+        TEST_ASSERT_EQUAL(2, (d.ap > 0) + (d.an > 0) + (d.bp > 0) + (d.bn > 0));
+    }
+
+    // half steps alternate one and two coils
+    p.set_mode(DriveMode::HALF);
+    TEST_ASSERT_EQUAL(8, p.steps_per_cycle());
+    for (int i = 0; i < 8; i++, p.forward()) {
+        CoilDuty d = p.current();
+        TEST_ASSERT_EQUAL((p.index() & 1) ? 2 : 1, (d.ap > 0) + (d.an > 0) + (d.bp > 0) + (d.bn > 0));
+    }
+}
+
+// Test every mode goes round a cycle in the right number of steps, and backward undoes forward
+void test_microstep_cycles() {
+    const DriveMode modes[] = { DriveMode::WAVE, DriveMode::FULL, DriveMode::HALF, DriveMode::MICRO_4, DriveMode::MICRO_8, DriveMode::MICRO_16 };
+    const uint8_t steps[]   = { 4, 4, 8, 16, 32, 64 };
+    PhaseSequencer p;
+    for (size_t m = 0; m < 6; m++) {
+        p.set_mode(modes[m]);
+        TEST_ASSERT_EQUAL(steps[m], p.steps_per_cycle());
+        uint8_t start = p.index();
+        for (uint8_t i = 0; i < steps[m]; i++) {
+            p.forward();
+            if (i + 1 < steps[m]) TEST_ASSERT_NOT_EQUAL(start, p.index());
+        }
+        TEST_ASSERT_EQUAL(start, p.index());
+        for (int i = 0; i < 5; i++) p.forward();
+        for (int i = 0; i < 5; i++) p.backward();
+        TEST_ASSERT_EQUAL(start, p.index());
+    }
+}
+
+// Test switching modes keeps the electrical angle, so the rotor does not jump
+void test_microstep_mode_switch() {
+    PhaseSequencer p;
+    p.set_mode(DriveMode::HALF);
+    p.forward(); // A+ B+, 45 degrees
+    p.set_mode(DriveMode::MICRO_16);
+    TEST_ASSERT_EQUAL(8, p.index());
+    TEST_ASSERT_EQUAL(coil_a(p.current()), coil_b(p.current()));
+
+    for (int i = 0; i < 3; i++) p.forward();
+    p.set_mode(DriveMode::MICRO_4); // 11 / 64 rounds to 12
+    TEST_ASSERT_EQUAL(12, p.index());
+    p.set_mode(DriveMode::WAVE); // 67.5 degrees rounds to B+
+    TEST_ASSERT_TRUE(same(p.current(), 0, 0, 255, 0));
+    p.set_mode(DriveMode::FULL); // no single coil position, half a step over
+    TEST_ASSERT_EQUAL(3, p.index());
+}
+
+// ==================== 性能测试 ====================
+
+// Cost of one step: index update and table read
+void test_microstep_performance() {
+    PhaseSequencer p;
+    p.set_mode(DriveMode::MICRO_16);
+#ifndef ARDUINO
+    const uint32_t n = 10000000;
+#else
+    const uint32_t n = 10000;
+#endif
+    uint32_t sum        = 0;
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < n; i++) {
+        (i & 256) ? p.backward() : p.forward();
+        CoilDuty d = p.current();
+        sum += d.ap + d.an + d.bp + d.bn;
+    }
+    unsigned long us = micros() - start;
+    bench_keep(sum);
+    bench_report("microstep, ns per step", us * 1000.0 / n, "ns");
+}
+
+void test_microstep() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_microstep_sine_waveform);
+    RUN_TEST(test_microstep_square_modes);
+    RUN_TEST(test_microstep_cycles);
+    RUN_TEST(test_microstep_mode_switch);
+
+    RUN_TEST(test_microstep_performance);
+
+    UNITY_END();
+}
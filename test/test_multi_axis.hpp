@@ -0,0 +1,231 @@
+#pragma once
+
+#include <unity.h>
+
+#include <multi_axis.hpp>
+
+#include "test_bench.hpp"
+#include "test_speed_ramp.hpp"
+
+namespace msd_multi_axis_test {
+
+using firmware::step_motor::MultiAxisDriver;
+using firmware::step_motor::RampDriver;
+using firmware::step_motor::RampState;
+using msd_speed_ramp_test::sim_timer;
+
+constexpr size_t AXES = 3;
+using driver          = MultiAxisDriver<AXES, sim_timer>;
+
+// one recorded coordinated move: tick of every interrupt and which interrupt stepped each axis
+struct axis_log {
+    static constexpr size_t cap = 20000;
+    uint32_t at[cap];           // tick of interrupt k
+    uint32_t step_of[AXES][cap]; // interrupt that emitted step j of an axis
+    size_t ticks = 0;
+    size_t n[AXES]{};
+    int32_t pos[AXES]{};
+    double max_path_error = 0; // steps away from the ideal line, over all axes and interrupts
+    uint32_t t            = 0;
+};
+
+// fire the ISR until the timer stops; after each interrupt compare every axis with the straight line
+inline void simulate(driver& d, axis_log& log, const int32_t (&steps)[AXES]) {
+    uint32_t major = 0;
+    for (int32_t s : steps) major = (s < 0 ? -s : s) > static_cast<int32_t>(major) ? (s < 0 ? -s : s) : major;
+    while (sim_timer::running) {
+        log.t += sim_timer::period;
+        size_t k = log.ticks;
+        d.isr([&log, k](uint8_t axis, bool forward) {
+            if (log.n[axis] < axis_log::cap) log.step_of[axis][log.n[axis]] = static_cast<uint32_t>(k);
+            log.n[axis]++;
+            log.pos[axis] += forward ? 1 : -1;
+        });
+        if (log.ticks < axis_log::cap) log.at[log.ticks] = log.t;
+        log.ticks++;
+        for (size_t i = 0; i < AXES; i++) {
+            double ideal = static_cast<double>(log.ticks) * steps[i] / major;
+            double err   = log.pos[i] - ideal;
+            if (err < 0) err = -err;
+            if (err > log.max_path_error) log.max_path_error = err;
+        }
+    }
+}
+
+// tick at which the major axis would be at continuous position x (1 = first interrupt)
+inline double ideal_tick(const axis_log& log, double x) {
+    size_t lo = static_cast<size_t>(x);
+    double f  = x - lo;
+    if (lo == 0) return log.at[0] * x;
+    if (lo >= log.ticks) return log.at[log.ticks - 1];
+    return log.at[lo - 1] + f * (static_cast<double>(log.at[lo]) - log.at[lo - 1]);
+}
+
+struct jitter {
+    double max_ticks    = 0; // worst step time against the ideal line
+    double max_fraction = 0; // same, as a fraction of the major step interval at that point
+    double max_cruise   = 0; // worst ticks while the major axis runs at cruise speed
+};
+
+// step j of an axis should land where the line crosses j + 1/2 steps, i.e. at major position (j + 1/2) * major / delta
+inline jitter measure_jitter(const axis_log& log, size_t axis, uint32_t delta, uint32_t major, uint32_t cruise_gap) {
+    jitter r;
+    for (size_t j = 0; j < log.n[axis]; j++) {
+        double x     = (j + 0.5) * major / delta;
+        size_t k     = log.step_of[axis][j];
+        double err   = log.at[k] - ideal_tick(log, x);
+        if (err < 0) err = -err;
+        double gap = k ? static_cast<double>(log.at[k]) - log.at[k - 1] : log.at[0];
+        if (err > r.max_ticks) r.max_ticks = err;
+        if (err / gap > r.max_fraction) r.max_fraction = err / gap;
+        if (gap == cruise_gap && err > r.max_cruise) r.max_cruise = err;
+    }
+    return r;
+}
+
+} // namespace msd_multi_axis_test
+
+using namespace msd_multi_axis_test;
+
+// Test every axis reaches its endpoint, in its own direction, and move() only arms the timer
+void test_multi_axis_endpoints() {
+    const int32_t moves[][AXES] = {
+        { 1000, 500, 250 }, { -300, 299, 1 }, { 7, -7, 7 }, { 0, 0, 50 }, { 12345, -6789, 1011 }, { 1, 0, 0 },
+    };
+    driver d;
+    static axis_log log;
+    int32_t pos[AXES] = {};
+    for (auto& m : moves) {
+        log = axis_log{};
+        d.move(m, 3000, 5000, 5000);
+        TEST_ASSERT_TRUE(sim_timer::running);
+        TEST_ASSERT_EQUAL(pos[0], d.position(0));
+        simulate(d, log, m);
+        TEST_ASSERT_FALSE(d.is_running());
+        for (size_t i = 0; i < AXES; i++) {
+            pos[i] += m[i];
+            TEST_ASSERT_EQUAL(m[i], log.pos[i]);
+            TEST_ASSERT_EQUAL(m[i] < 0 ? -m[i] : m[i], static_cast<int32_t>(log.n[i]));
+            TEST_ASSERT_EQUAL(pos[i], d.position(i));
+        }
+    }
+
+    const int32_t none[AXES] = {};
+    d.move(none, 1000, 1000, 1000);
+    TEST_ASSERT_FALSE(d.is_running());
+    TEST_ASSERT_FALSE(sim_timer::running);
+}
+
+// Test the axes stay on the straight line: never more than half a step off, and none finishes early
+void test_multi_axis_path_error() {
+    const int32_t m[AXES] = { 10000, -3333, 7071 };
+    driver d;
+    static axis_log log;
+    log = axis_log{};
+    d.move(m, 4000, 8000, 8000);
+    simulate(d, log, m);
+
+    TEST_ASSERT_TRUE(log.max_path_error <= 0.5 + 1e-9);
+    // the last step of every axis lands within half of its own step of the end of the move
+    for (size_t i = 1; i < AXES; i++) {
+        uint32_t delta = static_cast<uint32_t>(m[i] < 0 ? -m[i] : m[i]);
+        TEST_ASSERT_TRUE(log.ticks - 1 - log.step_of[i][log.n[i] - 1] <= 10000 / (2 * delta) + 1);
+    }
+    bench_report("multi axis max path error", log.max_path_error, "steps");
+}
+
+// Test minor axis steps land within one major interval of where the line says, through the whole ramp
+void test_multi_axis_jitter() {
+    const int32_t m[AXES] = { 10000, -3333, 7071 };
+    driver d;
+    static axis_log log;
+    log = axis_log{};
+    d.move(m, 4000, 8000, 8000);
+    simulate(d, log, m);
+
+    // 4000 steps/s on the major axis is 62 ticks, 250 us per interrupt
+    const uint32_t cruise_gap = sim_timer::frequency / 4000;
+    double worst = 0, worst_cruise = 0;
+    for (size_t i = 1; i < AXES; i++) {
+        jitter j = measure_jitter(log, i, static_cast<uint32_t>(m[i] < 0 ? -m[i] : m[i]), 10000, cruise_gap);
+        TEST_ASSERT_TRUE(j.max_fraction <= 1.0);
+        TEST_ASSERT_TRUE(j.max_cruise <= cruise_gap);
+        if (j.max_fraction > worst) worst = j.max_fraction;
+        if (j.max_cruise > worst_cruise) worst_cruise = j.max_cruise;
+    }
+    bench_report("multi axis max jitter, of major interval", worst, "");
+    bench_report("multi axis max jitter at cruise", worst_cruise * 1e6 / sim_timer::frequency, "us");
+}
+
+// Test one axis times exactly like RampDriver, and stop() halts every axis together
+void test_multi_axis_single_and_stop() {
+    MultiAxisDriver<1, sim_timer> one;
+    RampDriver<sim_timer> ref;
+    const int32_t s[1] = { 777 };
+    static uint32_t periods[777];
+    size_t n = 0;
+    ref.move(777, 2500, 3000, 1500);
+    while (sim_timer::running && n < 777) {
+        periods[n++] = sim_timer::period;
+        ref.isr([](bool) {});
+    }
+    one.move(s, 2500, 3000, 1500);
+    size_t k = 0;
+    while (sim_timer::running) {
+        TEST_ASSERT_EQUAL(periods[k++], sim_timer::period);
+        one.isr([](uint8_t, bool) {});
+    }
+    TEST_ASSERT_EQUAL(777, k);
+    TEST_ASSERT_EQUAL(777, one.position(0));
+
+    driver d;
+    const int32_t m[AXES] = { 100, 50, -100 };
+    d.move(m, 1000, 1000, 1000);
+    for (int i = 0; i < 10; i++) d.isr([](uint8_t, bool) {});
+    d.stop();
+    TEST_ASSERT_FALSE(d.is_running());
+    TEST_ASSERT_FALSE(sim_timer::running);
+    TEST_ASSERT_EQUAL(10, d.position(0));
+    TEST_ASSERT_EQUAL(5, d.position(1));
+    TEST_ASSERT_EQUAL(-10, d.position(2));
+    TEST_ASSERT_EQUAL(90, d.steps_left());
+    d.set_position(1, 0);
+    TEST_ASSERT_EQUAL(0, d.position(1));
+}
+
+// ==================== 性能测试 ====================
+
+// Cost of one interrupt: ramp update plus the Bresenham terms of three axes
+void test_multi_axis_performance() {
+    driver d;
+#ifndef ARDUINO
+    const int32_t m[AXES] = { 1000000, 654321, -123456 };
+#else
+    const int32_t m[AXES] = { 1000, 654, -123 };
+#endif
+    uint32_t emitted    = 0;
+    d.move(m, 60000, 100, 100); // ramping the whole time, the slow path of the recurrence
+    unsigned long start = micros();
+    uint32_t isrs       = 0;
+    while (sim_timer::running) {
+        d.isr([&emitted](uint8_t axis, bool forward) { emitted += axis + forward; });
+        isrs++;
+    }
+    unsigned long us = micros() - start;
+    bench_keep(emitted);
+    TEST_ASSERT_EQUAL(m[0], isrs);
+    bench_report("multi axis ISR, ns per interrupt", us * 1000.0 / isrs, "ns");
+}
+
+void test_multi_axis() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_multi_axis_endpoints);
+    RUN_TEST(test_multi_axis_path_error);
+    RUN_TEST(test_multi_axis_jitter);
+    RUN_TEST(test_multi_axis_single_and_stop);
+
+    RUN_TEST(test_multi_axis_performance);
+
+    UNITY_END();
+}
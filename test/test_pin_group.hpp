@@ -0,0 +1,157 @@
+#pragma once
+
+#include <unity.h>
+
+#include <arduino/pins/pin_group.hpp>
+
+#include "test_bench.hpp"
+#include "test_pins.hpp"
+
+namespace msd_pin_group_test {
+
+using firmware::pin_group;
+using firmware::PinMode;
+using namespace msd_pins_test;
+
+template <uint8_t PIN>
+using out = firmware::pins<PIN, PinMode::OUTPUT>;
+
+// a coil driver on D8-D11 and a bus owning all of PORTD
+using coils = pin_group<out<8>, out<9>, out<10>, out<11>>;
+using bus   = pin_group<out<0>, out<1>, out<2>, out<3>, out<4>, out<5>, out<6>, out<7>>;
+// out of order, over three ports
+using mixed = pin_group<out<13>, out<2>, out<14>, out<9>, out<19>>;
+
+static_assert(coils::mask_b == 0x0F && coils::mask_c == 0 && coils::mask_d == 0, "PB0-PB3");
+static_assert(bus::mask_d == 0xFF, "all of PORTD");
+static_assert(mixed::mask_b == 0x22 && mixed::mask_c == 0x21 && mixed::mask_d == 0x04, "PB5 PB1, PC0 PC5, PD2");
+
+} // namespace msd_pin_group_test
+
+using namespace msd_pin_group_test;
+
+// Test a write on one port is a single read-modify-write and keeps the other pins of the port
+void test_pin_group_write() {
+    reset();
+    reg(PORTB) = 0xA0;
+    coils::write(0b0110);
+    TEST_ASSERT_EQUAL_HEX8(0xA6, reg(PORTB));
+    TEST_ASSERT_EQUAL(1, details::io_reads);
+    TEST_ASSERT_EQUAL(3, details::io_writes); // PORTB, and TCCR1A and TCCR2A for D9-D11
+    coils::write(0b1001);
+    TEST_ASSERT_EQUAL_HEX8(0xA9, reg(PORTB));
+
+    // owning the port is one store, no read
+    reset();
+    bus::write(0x5A);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, reg(PORTD));
+    TEST_ASSERT_EQUAL(0, details::io_reads);
+    TEST_ASSERT_EQUAL(3, details::io_writes); // PORTD, and TCCR0A and TCCR2A for D3, D5, D6
+}
+
+// Test pins in any order and on several ports each get their own bit
+void test_pin_group_mixed() {
+    reset();
+    for (uint16_t v = 0; v < 32; v++) {
+        mixed::write(v);
+        TEST_ASSERT_EQUAL(bool(v & 1), bool(reg(PORTB) & 0x20));
+        TEST_ASSERT_EQUAL(bool(v & 2), bool(reg(PORTD) & 0x04));
+        TEST_ASSERT_EQUAL(bool(v & 4), bool(reg(PORTC) & 0x01));
+        TEST_ASSERT_EQUAL(bool(v & 8), bool(reg(PORTB) & 0x02));
+        TEST_ASSERT_EQUAL(bool(v & 16), bool(reg(PORTC) & 0x20));
+    }
+    TEST_ASSERT_EQUAL(4 * 32, details::io_writes); // a port each, and TCCR1A for D9
+
+    mixed::write(0);
+    mixed::set(0b10001);
+    TEST_ASSERT_EQUAL_HEX8(0x20, reg(PORTB) & 0x22);
+    TEST_ASSERT_EQUAL_HEX8(0x20, reg(PORTC) & 0x21);
+    mixed::clear(0b00001);
+    TEST_ASSERT_EQUAL_HEX8(0x00, reg(PORTB) & 0x22);
+
+    reg(PINB) = 0x02, reg(PINC) = 0x20, reg(PIND) = 0x04;
+    TEST_ASSERT_EQUAL(0b11010, mixed::read());
+}
+
+// Test the PWM pins driven are taken off their timer, as dwrite() does, and only those
+void test_pin_group_pwm() {
+    reset();
+    reg(details::TCCR1A_ADDR) = 0xA1; // analogWrite on D9 and D10
+    reg(details::TCCR2A_ADDR) = 0x83; // and on D11
+    coils::set(0b0010);               // D9
+    TEST_ASSERT_EQUAL_HEX8(0x21, reg(details::TCCR1A_ADDR));
+    TEST_ASSERT_EQUAL_HEX8(0x83, reg(details::TCCR2A_ADDR));
+    coils::clear(0b1000); // D11
+    TEST_ASSERT_EQUAL_HEX8(0x03, reg(details::TCCR2A_ADDR));
+    coils::write(0);
+    TEST_ASSERT_EQUAL_HEX8(0x01, reg(details::TCCR1A_ADDR));
+
+    // no PWM pin in the group: PORTB only
+    reset();
+    pin_group<out<8>, out<12>, out<13>>::write(0b111);
+    TEST_ASSERT_EQUAL_HEX8(0x31, reg(PORTB));
+    TEST_ASSERT_EQUAL(1, details::io_writes);
+}
+
+// Test toggle is a single store to PINx per port, and the atomic variants write the same
+void test_pin_group_toggle_atomic() {
+    reset();
+    coils::toggle(0b0011);
+    TEST_ASSERT_EQUAL_HEX8(0x03, reg(PORTB));
+    TEST_ASSERT_EQUAL(0, details::io_reads);
+    coils::toggle(0b0110);
+    TEST_ASSERT_EQUAL_HEX8(0x05, reg(PORTB));
+
+    coils::write_atomic(0b1000);
+    TEST_ASSERT_EQUAL_HEX8(0x08, reg(PORTB));
+    coils::set_atomic(0b0001);
+    coils::clear_atomic(0b1000);
+    TEST_ASSERT_EQUAL_HEX8(0x01, reg(PORTB));
+
+    bus::init();
+    TEST_ASSERT_EQUAL_HEX8(0xFF, reg(DDRD));
+}
+
+// ==================== 性能测试 ====================
+
+// Register accesses and states the port passes through, pin by pin against the group
+void test_pin_group_performance() {
+    // switching every coil: 0b0101 -> 0b1010
+    reset();
+    reg(PORTB)   = 0x05;
+    uint8_t seen = 0;
+    out<8>::dwrite(false), seen += reg(PORTB) != 0x05 && reg(PORTB) != 0x0A;
+    out<9>::dwrite(true), seen += reg(PORTB) != 0x05 && reg(PORTB) != 0x0A;
+    out<10>::dwrite(false), seen += reg(PORTB) != 0x05 && reg(PORTB) != 0x0A;
+    out<11>::dwrite(true);
+    uint32_t sequential = details::io_reads + details::io_writes;
+    TEST_ASSERT_EQUAL_HEX8(0x0A, reg(PORTB));
+    TEST_ASSERT_EQUAL(3, seen);
+
+    reset();
+    coils::write(0b0101);
+    reset();
+    coils::write(0b1010);
+    uint32_t group = details::io_reads + details::io_writes;
+    TEST_ASSERT_EQUAL_HEX8(0x0A, reg(PORTB));
+
+    // on AVR a dwrite of a runtime level is a test and sbi or cbi, ~4 cycles a pin;
+    // the group is in, andi, shift / or, out, ~5 cycles for the whole port. Both also take
+    // D9-D11 off their timers, a lds / andi / sts per timer for the group
+    bench_report("4 pins one by one, register accesses", sequential, "");
+    bench_report("4 pins as a group, register accesses", group, "");
+    bench_report("4 pins one by one, invalid states", seen, "");
+}
+
+void test_pin_group() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_pin_group_write);
+    RUN_TEST(test_pin_group_mixed);
+    RUN_TEST(test_pin_group_pwm);
+    RUN_TEST(test_pin_group_toggle_atomic);
+
+    RUN_TEST(test_pin_group_performance);
+
+    UNITY_END();
+}
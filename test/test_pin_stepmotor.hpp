@@ -0,0 +1,168 @@
+#pragma once
+
+#include <unity.h>
+
+#include <pin_stepmotor.hpp>
+
+#include "test_bench.hpp"
+#include "test_speed_ramp.hpp"
+
+namespace msd_pin_stepmotor_test {
+
+using firmware::step_motor::BasicPinStepMotor;
+using firmware::step_motor::DriveMode;
+using firmware::step_motor::PhaseSequencer;
+using firmware::step_motor::RampDriver;
+using msd_speed_ramp_test::sim_timer;
+
+// stands in for firmware::pins<PIN, MODE>: all state is static, per pin type
+template <uint8_t PIN>
+struct mock_pin {
+    static inline bool ready     = false;
+    static inline bool level     = false;
+    static inline uint8_t duty   = 0;
+    static inline uint32_t writes = 0;
+
+    static void init() noexcept { ready = true; }
+    static void dwrite(bool v) noexcept { level = v, writes++; }
+    static void awrite(uint8_t v) noexcept { duty = v, writes++; }
+};
+
+using AP    = mock_pin<8>;
+using AN    = mock_pin<9>;
+using BP    = mock_pin<10>;
+using BN    = mock_pin<11>;
+using motor = BasicPinStepMotor<AP, AN, BP, BN, sim_timer>;
+// another motor on the same timer, a type of its own
+using other = BasicPinStepMotor<mock_pin<2>, mock_pin<3>, mock_pin<4>, mock_pin<5>, sim_timer>;
+
+// the same state a motor needs without any pin
+struct motor_state {
+    PhaseSequencer phase;
+    RampDriver<sim_timer> driver;
+    uint16_t speed, accel;
+    uint8_t power;
+    bool enable_power;
+};
+
+// which coil ends are high, A+ B+ A- B- in bits 0 to 3
+inline uint8_t levels() { return AP::level | BP::level << 1 | AN::level << 2 | BN::level << 3; }
+
+} // namespace msd_pin_stepmotor_test
+
+using namespace msd_pin_stepmotor_test;
+
+// Test the motor carries no pin state and initialises its pins
+void test_pin_stepmotor_no_pin_state() {
+    motor m;
+    TEST_ASSERT_EQUAL(sizeof(motor_state), sizeof(motor));
+    TEST_ASSERT_TRUE(AP::ready && AN::ready && BP::ready && BN::ready);
+}
+
+// Test digital stepping walks A+, B+, A-, B- on the right pins, backward reverses it
+void test_pin_stepmotor_digital() {
+    motor m;
+    m.state_open();
+    TEST_ASSERT_EQUAL(0b0001, levels());
+    const uint8_t expect[] = { 0b0010, 0b0100, 0b1000, 0b0001 };
+    for (uint8_t e : expect) {
+        m.step_once(true);
+        TEST_ASSERT_EQUAL(e, levels());
+    }
+    m.step_once(false);
+    TEST_ASSERT_EQUAL(0b1000, levels());
+    m.state_close();
+    TEST_ASSERT_EQUAL(0, levels());
+
+    m.set_mode(DriveMode::FULL);
+    TEST_ASSERT_EQUAL(0b1001, levels()); // B- and A+
+}
+
+// Test PWM duties follow the microstep table, scaled by the power setting
+void test_pin_stepmotor_pwm() {
+    motor m;
+    m.enable_power();
+    m.set_power(128);
+    m.set_mode(DriveMode::MICRO_8);
+    m.step_once(true);
+    m.step_once(true); // 4 / 64 of the cycle, 22.5 degrees
+    TEST_ASSERT_INT_WITHIN(1, 128 * 0.924, AP::duty);
+    TEST_ASSERT_INT_WITHIN(1, 128 * 0.383, BP::duty);
+    TEST_ASSERT_EQUAL(0, AN::duty);
+    TEST_ASSERT_EQUAL(0, BN::duty);
+}
+
+// Test step() returns at once and the timer ISR walks the coils to the end of the move
+void test_pin_stepmotor_move() {
+    motor m;
+    m.set_speed(2000);
+    m.set_acceleration(8000);
+    m.state_open();
+    uint8_t start = levels();
+    m.step(-402);
+    TEST_ASSERT_TRUE(m.is_moving());
+    TEST_ASSERT_EQUAL(0, m.get_position());
+    TEST_ASSERT_EQUAL(start, levels());
+
+    uint32_t writes = AP::writes;
+    while (sim_timer::running) sim_timer::handler();
+    TEST_ASSERT_FALSE(m.is_moving());
+    TEST_ASSERT_EQUAL(-402, m.get_position());
+    TEST_ASSERT_EQUAL(writes + 402, AP::writes);
+    // 402 = 100 cycles and two steps back: B- then A-
+    TEST_ASSERT_EQUAL(0b0100, levels());
+}
+
+// Test a motor of another type taking the timer stops the one that held it
+void test_pin_stepmotor_shared_timer() {
+    motor a;
+    other b;
+    a.set_speed(2000), b.set_speed(2000);
+    a.step(100);
+    for (int i = 0; i < 10; i++) sim_timer::handler();
+    b.step(-50);
+    TEST_ASSERT_FALSE(a.is_moving());
+    TEST_ASSERT_EQUAL(10, a.get_position());
+    TEST_ASSERT_TRUE(b.is_moving());
+    while (sim_timer::running) sim_timer::handler();
+    TEST_ASSERT_EQUAL(-50, b.get_position());
+    TEST_ASSERT_EQUAL(10, a.get_position());
+
+    a.step(5); // and back
+    TEST_ASSERT_FALSE(b.is_moving());
+    while (sim_timer::running) sim_timer::handler();
+    TEST_ASSERT_EQUAL(15, a.get_position());
+}
+
+// ==================== 性能测试 ====================
+
+// Cost of one step, table lookup and four pin writes
+void test_pin_stepmotor_performance() {
+    motor m;
+    m.enable_power();
+    m.set_mode(DriveMode::MICRO_16);
+#ifndef ARDUINO
+    const uint32_t n = 10000000;
+#else
+    const uint32_t n = 10000;
+#endif
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < n; i++) m.step_once(i & 512);
+    unsigned long us = micros() - start;
+    bench_keep(AP::duty + BN::duty);
+    bench_report("pin step motor, ns per step", us * 1000.0 / n, "ns");
+}
+
+void test_pin_stepmotor() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_pin_stepmotor_no_pin_state);
+    RUN_TEST(test_pin_stepmotor_digital);
+    RUN_TEST(test_pin_stepmotor_pwm);
+    RUN_TEST(test_pin_stepmotor_move);
+    RUN_TEST(test_pin_stepmotor_shared_timer);
+
+    RUN_TEST(test_pin_stepmotor_performance);
+
+    UNITY_END();
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <string.h>
+#include <unity.h>
+
+#include <arduino/pins/pins.hpp>
+
+namespace msd_pins_test {
+
+using firmware::PinMode;
+namespace details = firmware::__details;
+
+// the Uno map, resolved by the compiler
+static_assert(details::__pin_register(13) == details::PINB_ADDR && details::__pin_mask(13) == 0x20, "D13 is PB5");
+static_assert(details::__port_register(2) == 0x2B && details::__pin_mask(2) == 0x04, "D2 is PD2 on PORTD");
+static_assert(details::__ddr_register(14) == 0x27 && details::__pin_mask(14) == 0x01, "A0 is PC0 on DDRC");
+static_assert(details::__pin_register(19) == details::PINC_ADDR && details::__pin_mask(19) == 0x20, "A5 is PC5");
+static_assert(!details::__has_port(20), "no port past A5");
+static_assert(details::__pwm_register(9) == details::TCCR1A_ADDR && details::__pwm_mask(9) == 0x80, "D9 is OC1A");
+static_assert(details::__pwm_register(3) == details::TCCR2A_ADDR && details::__pwm_mask(3) == 0x20, "D3 is OC2B");
+static_assert(details::__pwm_register(8) == 0, "no PWM on D8");
+
+constexpr uint8_t PINB = 0x23, DDRB = 0x24, PORTB = 0x25;
+constexpr uint8_t PIND = 0x29, DDRD = 0x2A, PORTD = 0x2B;
+constexpr uint8_t PINC = 0x26, DDRC = 0x27, PORTC = 0x28;
+
+inline uint8_t& reg(uint8_t addr) { return details::io_registers[addr]; }
+inline void reset() {
+    memset(details::io_registers, 0, sizeof(details::io_registers));
+    details::io_reads = details::io_writes = 0;
+}
+
+} // namespace msd_pins_test
+
+using namespace msd_pins_test;
+
+// Test init sets the direction and pull-up bits of its own pin only
+void test_pins_init() {
+    reset();
+    reg(PORTC) = 0xFF;
+    firmware::pins<13, PinMode::OUTPUT>::init();
+    firmware::pins<7, PinMode::INPUT_PULLUP>::init();
+    firmware::pins<15, PinMode::INPUT>::init();
+    TEST_ASSERT_EQUAL_HEX8(0x20, reg(DDRB));
+    TEST_ASSERT_EQUAL_HEX8(0x00, reg(DDRD));
+    TEST_ASSERT_EQUAL_HEX8(0x80, reg(PORTD));
+    TEST_ASSERT_EQUAL_HEX8(0x00, reg(DDRC));
+    TEST_ASSERT_EQUAL_HEX8(0xFD, reg(PORTC));
+}
+
+// Test dwrite sets and clears one bit of PORTx and leaves its neighbours alone
+void test_pins_write() {
+    reset();
+    using D8  = firmware::pins<8, PinMode::OUTPUT>;
+    using D12 = firmware::pins<12, PinMode::OUTPUT>;
+    reg(PORTB) = 0x42;
+    D8::dwrite(true);
+    D12::dwrite(true);
+    TEST_ASSERT_EQUAL_HEX8(0x53, reg(PORTB));
+    D8::dwrite(false);
+    TEST_ASSERT_EQUAL_HEX8(0x52, reg(PORTB));
+    TEST_ASSERT_EQUAL_HEX8(0x00, reg(PORTD));
+}
+
+// Test dwrite on a PWM pin detaches its timer output, and only that one
+void test_pins_write_pwm() {
+    reset();
+    using D6  = firmware::pins<6, PinMode::OUTPUT>;
+    using D10 = firmware::pins<10, PinMode::OUTPUT>;
+    using D8  = firmware::pins<8, PinMode::OUTPUT>;
+    reg(details::TCCR0A_ADDR) = 0xA3; // OC0A and OC0B connected, fast PWM
+    reg(details::TCCR1A_ADDR) = 0xA1;
+    D6::dwrite(false);
+    TEST_ASSERT_EQUAL_HEX8(0x23, reg(details::TCCR0A_ADDR));
+    D10::dwrite(true);
+    TEST_ASSERT_EQUAL_HEX8(0x81, reg(details::TCCR1A_ADDR));
+    TEST_ASSERT_EQUAL_HEX8(0x04, reg(PORTB));
+
+    uint32_t writes = details::io_writes;
+    D8::dwrite(true);
+    TEST_ASSERT_EQUAL(writes + 1, details::io_writes); // a plain pin pays nothing
+}
+
+// Test dread samples PINx and toggle writes PINx, which flips the PORTx bit
+void test_pins_read_toggle() {
+    reset();
+    using D3  = firmware::pins<3, PinMode::INPUT>;
+    using D13 = firmware::pins<13, PinMode::OUTPUT>;
+    reg(PIND) = 0x08;
+    TEST_ASSERT_TRUE(D3::dread());
+    reg(PIND) = 0xF7;
+    TEST_ASSERT_FALSE(D3::dread());
+
+    reg(PORTB) = 0x01;
+    D13::toggle();
+    TEST_ASSERT_EQUAL_HEX8(0x21, reg(PORTB));
+    D13::toggle();
+    TEST_ASSERT_EQUAL_HEX8(0x01, reg(PORTB));
+    TEST_ASSERT_EQUAL_HEX8(0x00, reg(PINB)); // the write itself is not stored
+}
+
+void test_pins() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_pins_init);
+    RUN_TEST(test_pins_write);
+    RUN_TEST(test_pins_write_pwm);
+    RUN_TEST(test_pins_read_toggle);
+
+    UNITY_END();
+}
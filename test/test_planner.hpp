@@ -0,0 +1,214 @@
+#pragma once
+
+#include <math.h>
+#include <unity.h>
+
+#include <multi_axis.hpp>
+#include <planner.hpp>
+
+#include "test_bench.hpp"
+#include "test_speed_ramp.hpp"
+
+namespace msd_planner_test {
+
+using firmware::step_motor::Motion;
+using firmware::step_motor::MultiAxisDriver;
+using firmware::step_motor::Planner;
+using msd_speed_ramp_test::sim_timer;
+
+using planner = Planner<2, 16>;
+
+// polygon through a circle of radius r, segment k of n
+inline void circle_segment(size_t k, size_t n, float r, int32_t (&out)[2]) {
+    const float step = 2 * 3.14159265f / n;
+    int32_t x0       = static_cast<int32_t>(lroundf(r * cosf(k * step))), y0 = static_cast<int32_t>(lroundf(r * sinf(k * step)));
+    int32_t x1 = static_cast<int32_t>(lroundf(r * cosf((k + 1) * step))), y1 = static_cast<int32_t>(lroundf(r * sinf((k + 1) * step)));
+    out[0] = x1 - x0;
+    out[1] = y1 - y0;
+}
+
+// the plan a full two-pass replan over the whole buffer gives, with the front entry held
+inline void reference_plan(const planner& p, float accel, float* out) {
+    size_t n   = p.size();
+    out[0]     = p[0].entry_sq;
+    if (n == 1) return;
+    out[n - 1] = fminf(p[n - 1].max_entry_sq, 2 * accel * p[n - 1].length);
+    for (size_t i = n - 2; i >= 1; i--) out[i] = fminf(p[i].max_entry_sq, out[i + 1] + 2 * accel * p[i].length);
+    for (size_t i = 0; i + 1 < n; i++) out[i + 1] = fminf(out[i + 1], out[i] + 2 * accel * p[i].length);
+}
+
+inline bool close(float a, float b) { return fabsf(a - b) <= 1e-3f * fmaxf(fabsf(a), fabsf(b)) + 1.0f; }
+
+// run the buffered path on the simulated timer, chaining segments like StepMotorGroup's ISR does
+template <typename Source>
+uint32_t run_path(planner& p, int32_t (&pos)[2], Source&& refill) {
+    MultiAxisDriver<2, sim_timer> d;
+    Motion<2> m;
+    uint32_t t = 0;
+    refill();
+    if (p.pop(m)) d.move(m.steps, m.entry, m.speed, m.exit, m.accel);
+    while (sim_timer::running) {
+        t += sim_timer::period;
+        d.isr([&pos](uint8_t axis, bool forward) { pos[axis] += forward ? 1 : -1; });
+        refill();
+        if (!d.is_running() && p.pop(m)) d.move(m.steps, m.entry, m.speed, m.exit, m.accel);
+    }
+    return t;
+}
+
+} // namespace msd_planner_test
+
+using namespace msd_planner_test;
+
+// Test a straight line split in segments never slows down at the joints, and stops at the end
+void test_planner_collinear() {
+    planner p(4000, 1.0f);
+    const int32_t seg[2] = { 400, 200 };
+    for (int i = 0; i < 8; i++) TEST_ASSERT_TRUE(p.push(seg, 2000));
+
+    const float nominal = 2000.0f * 2000.0f;
+    TEST_ASSERT_EQUAL_FLOAT(0, p[0].entry_sq);
+    // 2000 steps/s needs 500 steps of path to reach, a segment is 447
+    TEST_ASSERT_FLOAT_WITHIN(1, 2 * 4000 * p[0].length, p[1].entry_sq);
+    for (size_t i = 2; i < 7; i++) TEST_ASSERT_FLOAT_WITHIN(1, nominal, p[i].entry_sq);
+    TEST_ASSERT_FLOAT_WITHIN(1, 2 * 4000 * p[7].length, p[7].entry_sq);
+
+    // popped segments chain: each exit is the next entry, in major axis units
+    Motion<2> prev, m;
+    TEST_ASSERT_TRUE(p.pop(prev));
+    TEST_ASSERT_EQUAL(0, prev.entry);
+    TEST_ASSERT_EQUAL(1789, prev.speed); // 2000 along the path is 2000 * 400 / 447 on x
+    while (p.pop(m)) {
+        TEST_ASSERT_EQUAL(prev.exit, m.entry);
+        prev = m;
+    }
+    TEST_ASSERT_EQUAL(0, prev.exit);
+    TEST_ASSERT_FALSE(p.pop(m));
+}
+
+// Test corners slow down by the junction deviation rule and reversals stop
+void test_planner_junctions() {
+    planner p(4000, 1.0f);
+    const int32_t x[2] = { 1000, 0 }, y[2] = { 0, 1000 }, back[2] = { 0, -1000 };
+    p.push(x, 3000);
+    p.push(y, 3000);
+    p.push(back, 3000);
+
+    // 90 degrees: a * deviation * sin(45) / (1 - sin(45))
+    TEST_ASSERT_FLOAT_WITHIN(1, 4000 * 0.70710678f / (1 - 0.70710678f), p[1].entry_sq);
+    TEST_ASSERT_EQUAL_FLOAT(0, p[2].entry_sq);
+
+    // nominal speed of either side caps the junction
+    planner q(4000, 1000.0f);
+    q.push(x, 3000);
+    q.push(y, 500);
+    TEST_ASSERT_FLOAT_WITHIN(1, 500.0f * 500.0f, q[1].max_entry_sq);
+
+    // full buffer and empty segments are refused
+    const int32_t none[2] = {};
+    TEST_ASSERT_FALSE(q.push(none, 1000));
+    while (!q.full()) q.push(x, 1000);
+    TEST_ASSERT_FALSE(q.push(x, 1000));
+}
+
+// Test incremental replanning gives the same speeds as replanning everything, pushing and popping at random
+void test_planner_incremental() {
+    planner p(3000, 2.0f);
+    static float ref[16];
+    uint32_t seed = 12345;
+    for (int round = 0; round < 2000; round++) {
+        seed ^= seed << 13, seed ^= seed >> 17, seed ^= seed << 5;
+        if (!p.full() && (seed & 3) != 0) {
+            int32_t s[2] = { static_cast<int32_t>(seed % 401) - 200, static_cast<int32_t>((seed >> 9) % 401) - 200 };
+            p.push(s, static_cast<uint16_t>(500 + (seed >> 20) % 3000));
+        } else {
+            Motion<2> m;
+            p.pop(m);
+        }
+        if (p.empty()) continue;
+
+        reference_plan(p, 3000, ref);
+        for (size_t i = 0; i < p.size(); i++) TEST_ASSERT_TRUE(close(ref[i], p[i].entry_sq));
+        // the finished prefix really is final: it never exceeds the limits of a full plan
+        TEST_ASSERT_TRUE(p.planned() < p.size());
+    }
+}
+
+// Test a segmented circle runs through the driver with every step emitted and far faster than stopping at each joint
+void test_planner_path() {
+    const size_t n = 64;
+    planner p(20000, 1.0f);
+    int32_t pos[2] = {}, expect[2] = {};
+    size_t next    = 0;
+    auto refill    = [&]() {
+        int32_t s[2];
+        while (next < n && !p.full()) {
+            circle_segment(next, n, 2000, s);
+            TEST_ASSERT_TRUE(p.push(s, 4000));
+            expect[0] += s[0], expect[1] += s[1];
+            next++;
+        }
+    };
+    uint32_t lookahead = run_path(p, pos, refill);
+    TEST_ASSERT_EQUAL(n, next);
+    TEST_ASSERT_EQUAL(expect[0], pos[0]);
+    TEST_ASSERT_EQUAL(expect[1], pos[1]);
+
+    // the same path one segment at a time, stopping at every joint
+    pos[0] = pos[1] = 0;
+    next            = 0;
+    auto one        = [&]() {
+        int32_t s[2];
+        if (next < n && p.empty()) {
+            circle_segment(next++, n, 2000, s);
+            p.push(s, 4000);
+        }
+    };
+    uint32_t stop_go = 0;
+    while (next < n) stop_go += run_path(p, pos, one);
+    TEST_ASSERT_EQUAL(expect[0], pos[0]);
+    TEST_ASSERT_TRUE(lookahead * 2 < stop_go);
+    bench_report("circle with lookahead", lookahead * 1000.0 / sim_timer::frequency, "ms");
+    bench_report("circle stopping at joints", stop_go * 1000.0 / sim_timer::frequency, "ms");
+}
+
+// ==================== 性能测试 ====================
+
+// Cost of planning one segment with a full lookahead buffer
+void test_planner_performance() {
+    planner p(20000, 1.0f);
+#ifndef ARDUINO
+    const uint32_t rounds = 1000000;
+#else
+    const uint32_t rounds = 200;
+#endif
+    static int32_t segs[64][2];
+    for (size_t k = 0; k < 64; k++) circle_segment(k, 64, 2000, segs[k]);
+
+    Motion<2> m;
+    uint32_t sum        = 0;
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < rounds; i++) {
+        if (p.full()) {
+            p.pop(m);
+            sum += m.exit;
+        }
+        p.push(segs[i & 63], 4000);
+    }
+    unsigned long us = micros() - start;
+    bench_keep(sum);
+    bench_report("planner push + pop, ns per segment", us * 1000.0 / rounds, "ns");
+}
+
+void test_planner() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_planner_collinear);
+    RUN_TEST(test_planner_junctions);
+    RUN_TEST(test_planner_incremental);
+    RUN_TEST(test_planner_path);
+
+    RUN_TEST(test_planner_performance);
+
+    UNITY_END();
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <unity.h>
+
+#include <arduino/pwm/pwm.hpp>
+
+#include "test_bench.hpp"
+#include "test_pins.hpp"
+
+namespace msd_pwm_test {
+
+using firmware::pwm;
+using firmware::pwm_timer1;
+using firmware::pwm_timer2;
+using firmware::PwmMode;
+using namespace msd_pins_test;
+
+constexpr uint8_t TCCR0A = 0x44, OCR0A = 0x47;
+constexpr uint8_t TCCR1A = 0x80, TCCR1B = 0x81, ICR1L = 0x86, ICR1H = 0x87;
+constexpr uint8_t OCR1AL = 0x88, OCR1AH = 0x89, OCR1BL = 0x8A, OCR1BH = 0x8B;
+constexpr uint8_t TCCR2A = 0xB0, TCCR2B = 0xB1, OCR2B = 0xB4;
+
+static_assert(msd::is_same<pwm<9>::timer, pwm_timer1>::value && msd::is_same<pwm<10>::timer, pwm_timer1>::value, "OC1A OC1B");
+static_assert(msd::is_same<pwm<3>::timer, pwm_timer2>::value && msd::is_same<pwm<11>::timer, pwm_timer2>::value, "OC2B OC2A");
+static_assert(firmware::__details::__timer1_for(20000, PwmMode::FAST).top == 799, "20 kHz is 800 steps");
+static_assert(firmware::__details::__timer1_for(50, PwmMode::FAST).cs == 2, "50 Hz needs /8");
+static_assert(firmware::__details::__timer1_for(20000000, PwmMode::FAST).cs == 0, "past F_CPU / 2");
+
+inline uint16_t reg16(uint8_t lo) { return static_cast<uint16_t>(reg(lo) | reg(lo + 1) << 8); }
+
+} // namespace msd_pwm_test
+
+using namespace msd_pwm_test;
+
+// Test Timer1 picks the finest prescaler reaching the frequency and programs the ICR1 modes
+void test_pwm_timer1_configure() {
+    reset();
+    reg(TCCR1A) = 0xA0; // D9 and D10 already connected
+    TEST_ASSERT_EQUAL(799, pwm_timer1::configure(20000));
+    TEST_ASSERT_EQUAL(799, reg16(ICR1L));
+    TEST_ASSERT_EQUAL_HEX8(0xA2, reg(TCCR1A)); // outputs kept, WGM11
+    TEST_ASSERT_EQUAL_HEX8(0x19, reg(TCCR1B)); // WGM13 WGM12, clk / 1
+    TEST_ASSERT_EQUAL(799, pwm_timer1::top());
+
+    TEST_ASSERT_EQUAL(400, pwm_timer1::configure(20000, PwmMode::PHASE_CORRECT));
+    TEST_ASSERT_EQUAL_HEX8(0xA0, reg(TCCR1A));
+    TEST_ASSERT_EQUAL_HEX8(0x11, reg(TCCR1B)); // mode 8, clk / 1
+
+    TEST_ASSERT_EQUAL(39999, pwm_timer1::configure(50)); // servo frame, 0.5 us steps
+    TEST_ASSERT_EQUAL_HEX8(0x1A, reg(TCCR1B));
+
+    TEST_ASSERT_EQUAL(0xFFFF, pwm_timer1::configure_top(0xFFFF, 1)); // full 16 bits at 244 Hz
+    TEST_ASSERT_EQUAL(0xFFFF, reg16(ICR1L));
+
+    TEST_ASSERT_EQUAL(0, pwm_timer1::configure(0));
+    TEST_ASSERT_EQUAL_HEX8(0x00, reg(TCCR1B)); // left stopped
+}
+
+// Test init connects the pin, write is a plain store to the compare register, release disconnects
+void test_pwm_write() {
+    reset();
+    pwm<9>::init();
+    pwm<10>::init();
+    TEST_ASSERT_EQUAL_HEX8(0x06, reg(DDRB));
+    TEST_ASSERT_EQUAL_HEX8(0xA0, reg(TCCR1A));
+
+    details::io_reads = details::io_writes = 0;
+    pwm<9>::write(0x1234);
+    TEST_ASSERT_EQUAL(0x1234, reg16(OCR1AL));
+    TEST_ASSERT_EQUAL(2, details::io_writes);
+    TEST_ASSERT_EQUAL(0, details::io_reads);
+    pwm<10>::write(7);
+    TEST_ASSERT_EQUAL(7, reg16(OCR1BL));
+
+    pwm<3>::init();
+    details::io_reads = details::io_writes = 0;
+    pwm<3>::write(200);
+    TEST_ASSERT_EQUAL(200, reg(OCR2B));
+    TEST_ASSERT_EQUAL(1, details::io_writes);
+    TEST_ASSERT_EQUAL(0, details::io_reads);
+    TEST_ASSERT_EQUAL_HEX8(0x20, reg(TCCR2A));
+    TEST_ASSERT_EQUAL_HEX8(0x08, reg(DDRD));
+
+    pwm<6>::init();
+    pwm<6>::write(17);
+    TEST_ASSERT_EQUAL(17, reg(OCR0A));
+    TEST_ASSERT_EQUAL_HEX8(0x80, reg(TCCR0A));
+
+    pwm<9>::release();
+    TEST_ASSERT_EQUAL_HEX8(0x20, reg(TCCR1A));
+}
+
+// Test scaled duty maps 0 to 0xFFFF onto whatever TOP the timer runs with
+void test_pwm_scaled() {
+    reset();
+    pwm_timer1::configure(20000);
+    pwm<9>::write_scaled(0x8000);
+    TEST_ASSERT_EQUAL(400, reg16(OCR1AL));
+    pwm<9>::write_scaled(0xFFFF);
+    TEST_ASSERT_EQUAL(799, reg16(OCR1AL));
+    pwm<9>::write_scaled(0);
+    TEST_ASSERT_EQUAL(0, reg16(OCR1AL));
+
+    pwm<11>::write_scaled(0x4000);
+    TEST_ASSERT_EQUAL(64, reg(0xB3));
+}
+
+// Test Timer2 takes the prescaler closest to the asked frequency
+void test_pwm_timer2_configure() {
+    reset();
+    reg(TCCR2A) = 0x20;
+    TEST_ASSERT_EQUAL(7812, pwm_timer2::configure(8000));
+    TEST_ASSERT_EQUAL_HEX8(0x23, reg(TCCR2A));
+    TEST_ASSERT_EQUAL_HEX8(0x02, reg(TCCR2B));
+    TEST_ASSERT_EQUAL(31372, pwm_timer2::configure(30000, PwmMode::PHASE_CORRECT));
+    TEST_ASSERT_EQUAL_HEX8(0x21, reg(TCCR2A));
+    TEST_ASSERT_EQUAL_HEX8(0x01, reg(TCCR2B));
+}
+
+// ==================== 性能测试 ====================
+
+// Resolution at an inaudible frequency and the cost of a duty update
+void test_pwm_performance() {
+    reset();
+    uint16_t top = pwm_timer1::configure(20000);
+    details::io_reads = details::io_writes = 0;
+    pwm<9>::write(top / 3);
+    uint32_t timer1_stores = details::io_reads + details::io_writes;
+    details::io_reads = details::io_writes = 0;
+    pwm<3>::write(85);
+    uint32_t timer2_stores = details::io_reads + details::io_writes;
+
+    double bits = 0;
+    for (uint32_t t = top + 1u; t > 1; t >>= 1) bits++;
+    // analogWrite() looks the pin up in flash tables and sets the COM bits on every call, ~60 cycles
+    bench_report("Timer1 PWM at 20 kHz, duty steps", top + 1.0, "");
+    bench_report("analogWrite at 490 Hz, duty steps", 256, "");
+    bench_report("Timer1 duty update, register accesses", timer1_stores, "");
+    bench_report("Timer2 duty update, register accesses", timer2_stores, "");
+    TEST_ASSERT_EQUAL(2, timer1_stores);
+    TEST_ASSERT_EQUAL(1, timer2_stores);
+    TEST_ASSERT_GREATER_OR_EQUAL(9, bits);
+}
+
+void test_pwm() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_pwm_timer1_configure);
+    RUN_TEST(test_pwm_write);
+    RUN_TEST(test_pwm_scaled);
+    RUN_TEST(test_pwm_timer2_configure);
+
+    RUN_TEST(test_pwm_performance);
+
+    UNITY_END();
+}
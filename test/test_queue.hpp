@@ -188,6 +188,20 @@ void test_queue_large_scale() {
     TEST_ASSERT_TRUE(q.empty());
 }
 
+// Test indexing from the front across the wrap of the ring
+void test_queue_index() {
+    queue<int, 8> q;
+    for (int i = 0; i < 6; i++) q.push_back(i);
+    for (int i = 0; i < 4; i++) q.pop_front();
+    for (int i = 6; i < 12; i++) q.push_back(i);
+    TEST_ASSERT_EQUAL(8, q.size());
+    for (size_t i = 0; i < q.size(); i++) TEST_ASSERT_EQUAL(static_cast<int>(i) + 4, q[i]);
+    q[7] = 100;
+    TEST_ASSERT_EQUAL(100, q.back());
+    const auto& c = q;
+    TEST_ASSERT_EQUAL(4, c[0]);
+}
+
 void test_queue() {
     UNITY_BEGIN();
 
@@ -200,6 +214,7 @@ void test_queue() {
     RUN_TEST(test_queue_edge_cases);
     RUN_TEST(test_queue_copy_and_assignment);
     RUN_TEST(test_queue_large_scale);
+    RUN_TEST(test_queue_index);
 
     UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <unity.h>
+
+#include <queue>
+#include <ring_buffer>
+#include <thread_pool>
+
+#include "test_bench.hpp"
+
+namespace msd_ring_buffer_test {
+
+using msd::ring_buffer;
+
+static_assert(sizeof(ring_buffer<uint16_t, 64>) == 64 * 2 + 2, "one byte counters up to 128");
+
+#if MSD_THREADS
+constexpr uint32_t stress_count = 1000000;
+
+struct stress {
+    ring_buffer<uint32_t, 256> ring;
+    uint32_t bad = 0;
+};
+inline stress stress_state;
+
+inline void* stress_producer(void* arg) {
+    auto* s = static_cast<stress*>(arg);
+    for (uint32_t i = 0; i < stress_count;)
+        if (s->ring.push(i)) i++;
+    return nullptr;
+}
+#endif
+
+} // namespace msd_ring_buffer_test
+
+using namespace msd_ring_buffer_test;
+
+// Test elements come out in order, push fails when full and pop when empty
+void test_ring_buffer_fifo() {
+    ring_buffer<int, 8> r;
+    TEST_ASSERT_TRUE(r.empty());
+    TEST_ASSERT_EQUAL(8, r.capacity());
+    for (int i = 0; i < 8; i++) TEST_ASSERT_TRUE(r.push(i));
+    TEST_ASSERT_TRUE(r.full());
+    TEST_ASSERT_FALSE(r.push(99));
+
+    int v = -1;
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT_TRUE(r.pop(v));
+        TEST_ASSERT_EQUAL(i, v);
+    }
+    TEST_ASSERT_FALSE(r.pop(v));
+    TEST_ASSERT_EQUAL(7, v);
+}
+
+// Test the counters wrap past their type's range without losing elements
+void test_ring_buffer_wrap() {
+    ring_buffer<uint16_t, 4> r;
+    uint16_t next = 0, expect = 0, v = 0;
+    for (int round = 0; round < 1000; round++) {
+        while (r.push(next)) next++;
+        TEST_ASSERT_EQUAL(4, r.size());
+        for (int i = 0; i < 3; i++) {
+            TEST_ASSERT_TRUE(r.pop(v));
+            TEST_ASSERT_EQUAL(expect++, v);
+        }
+    }
+    TEST_ASSERT_EQUAL(1, r.size());
+}
+
+// Test a batch pop takes what is there up to max, across the end of the storage
+void test_ring_buffer_batch() {
+    ring_buffer<int, 16> r;
+    int out[16];
+    for (int i = 0; i < 12; i++) r.push(i);
+    TEST_ASSERT_EQUAL(10, r.pop(out, 10));
+    for (int i = 12; i < 24; i++) r.push(i);
+    TEST_ASSERT_EQUAL(14, r.size());
+
+    TEST_ASSERT_EQUAL(14, r.pop(out, 16));
+    for (int i = 0; i < 14; i++) TEST_ASSERT_EQUAL(10 + i, out[i]);
+    TEST_ASSERT_EQUAL(0, r.pop(out, 16));
+
+    r.push(5);
+    TEST_ASSERT_EQUAL(5, *r.peek());
+    r.clear();
+    TEST_ASSERT_NULL(r.peek());
+}
+
+// Test a producer thread and a consumer thread hand over every element once, in order
+void test_ring_buffer_threads() {
+#if MSD_THREADS
+    stress& s = stress_state;
+    pthread_t producer;
+    pthread_create(&producer, nullptr, stress_producer, &s);
+    uint32_t expect = 0, batch[32];
+    while (expect < stress_count) {
+        size_t n = s.ring.pop(batch, 32);
+        for (size_t i = 0; i < n; i++) s.bad += batch[i] != expect++;
+    }
+    pthread_join(producer, nullptr);
+    TEST_ASSERT_EQUAL(0, s.bad);
+    TEST_ASSERT_TRUE(s.ring.empty());
+#else
+    TEST_IGNORE_MESSAGE("no threads");
+#endif
+}
+
+// ==================== 性能测试 ====================
+
+// push and pop of a 16-bit sample, ring against msd::queue
+void test_ring_buffer_performance() {
+#ifndef ARDUINO
+    const uint32_t n = 10000000;
+#else
+    const uint32_t n = 10000;
+#endif
+    ring_buffer<uint16_t, 64> r;
+    uint16_t v = 0, sum = 0;
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < n; i++) {
+        r.push(static_cast<uint16_t>(i));
+        r.pop(v);
+        sum += v;
+    }
+    unsigned long ring_us = micros() - start;
+    bench_keep(sum);
+
+    msd::queue<uint16_t, 64> q;
+    start = micros();
+    for (uint32_t i = 0; i < n; i++) {
+        q.push_back(static_cast<uint16_t>(i));
+        sum += q.front();
+        q.pop_front();
+    }
+    unsigned long queue_us = micros() - start;
+    bench_keep(sum);
+
+    bench_report("ring_buffer push + pop, ns", ring_us * 1000.0 / n, "ns");
+    bench_report("queue push + pop, ns", queue_us * 1000.0 / n, "ns");
+}
+
+void test_ring_buffer() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_ring_buffer_fifo);
+    RUN_TEST(test_ring_buffer_wrap);
+    RUN_TEST(test_ring_buffer_batch);
+    RUN_TEST(test_ring_buffer_threads);
+
+    RUN_TEST(test_ring_buffer_performance);
+
+    UNITY_END();
+}
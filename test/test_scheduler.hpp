@@ -0,0 +1,270 @@
+#pragma once
+
+#include <unity.h>
+
+#include <literals>
+#include <scheduler>
+
+#include "test_bench.hpp"
+
+namespace msd_scheduler_test {
+
+using namespace msd::literals;
+
+// the scheduler only reads time, tests move it by hand
+struct virtual_clock {
+    static inline uint32_t now = 0;
+    static uint32_t now_us() noexcept { return now; }
+};
+
+using scheduler = msd::scheduler<virtual_clock>;
+
+// advance the clock to the next deadline and poll, like an idle MCU would
+inline void step_to_next(scheduler& s) {
+    uint32_t wake;
+    if (s.next_wake(wake) && static_cast<int32_t>(wake - virtual_clock::now) > 0) virtual_clock::now = wake;
+    s.poll();
+}
+
+// records (time, id) whenever it toggles
+struct trace {
+    uint32_t at[64];
+    uint8_t id[64];
+    size_t n = 0;
+    void add(uint8_t who) {
+        if (n < 64) at[n] = virtual_clock::now, id[n++] = who;
+    }
+};
+
+struct blink : msd::task {
+    trace& log;
+    uint8_t who;
+    uint8_t i;
+    msd::literals::Seconds period;
+    uint8_t times;
+
+    blink(trace& t, uint8_t w, msd::literals::Seconds p, uint8_t n) : log(t), who(w), i(0), period(p), times(n) {}
+
+    msd::task_status run() override {
+        MSD_TASK_BEGIN();
+        for (i = 0; i < times; i++) {
+            log.add(who);
+            MSD_TASK_AWAIT(period);
+        }
+        MSD_TASK_END();
+    }
+};
+
+struct waiter : msd::task {
+    const bool& flag;
+    bool finished = false;
+    explicit waiter(const bool& f) : flag(f) {}
+
+    msd::task_status run() override {
+        MSD_TASK_BEGIN();
+        MSD_TASK_AWAIT_UNTIL(flag);
+        finished = true;
+        MSD_TASK_END();
+    }
+};
+
+struct counter : msd::task {
+    uint32_t count = 0;
+    msd::task_status run() override {
+        MSD_TASK_BEGIN();
+        while (true) {
+            count++;
+            MSD_TASK_YIELD();
+        }
+        MSD_TASK_END();
+    }
+};
+
+// spawns a child once and cancels it after a while
+struct parent : msd::task {
+    scheduler& sched;
+    counter& child;
+    explicit parent(scheduler& s, counter& c) : sched(s), child(c) {}
+
+    msd::task_status run() override {
+        MSD_TASK_BEGIN();
+        sched.spawn(child);
+        MSD_TASK_AWAIT(10_ms);
+        sched.cancel(child);
+        MSD_TASK_END();
+    }
+};
+
+// the smallest useful task, one byte of its own state
+struct tick : msd::task {
+    uint8_t n = 0;
+    msd::task_status run() override {
+        MSD_TASK_BEGIN();
+        while (n < 10) {
+            n++;
+            MSD_TASK_AWAIT(1_ms);
+        }
+        MSD_TASK_END();
+    }
+};
+
+} // namespace msd_scheduler_test
+
+using namespace msd_scheduler_test;
+
+// Test two periodic tasks interleave in time order instead of running back to back
+void test_scheduler_interleave() {
+    virtual_clock::now = 0;
+    scheduler s;
+    trace t;
+    blink fast(t, 1, 2_ms, 3);
+    blink slow(t, 2, 5_ms, 2);
+    s.spawn(fast);
+    s.spawn(slow);
+    TEST_ASSERT_EQUAL(2, s.size());
+
+    while (!s.empty()) step_to_next(s);
+
+    // fast at 0, 2, 4 ms; slow at 0, 5 ms
+    const uint32_t at[] = { 0, 0, 2000, 4000, 5000 };
+    const uint8_t id[]  = { 1, 2, 1, 1, 2 };
+    TEST_ASSERT_EQUAL(5, t.n);
+    for (size_t i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL(at[i], t.at[i]);
+        TEST_ASSERT_EQUAL(id[i], t.id[i]);
+    }
+    TEST_ASSERT_FALSE(fast.is_running());
+}
+
+// Test a task is not resumed before its deadline
+void test_scheduler_await_not_early() {
+    virtual_clock::now = 100;
+    scheduler s;
+    trace t;
+    blink b(t, 7, 1.5_ms, 2);
+    s.spawn(b);
+
+    TEST_ASSERT_EQUAL(1, s.poll());
+    virtual_clock::now += 1499;
+    TEST_ASSERT_EQUAL(0, s.poll());
+    TEST_ASSERT_EQUAL(1, t.n);
+    virtual_clock::now += 1;
+    TEST_ASSERT_EQUAL(1, s.poll());
+    TEST_ASSERT_EQUAL(2, t.n);
+    TEST_ASSERT_EQUAL(1600, t.at[1]);
+}
+
+// Test deadlines survive the 32-bit microsecond counter wrapping
+void test_scheduler_wraparound() {
+    virtual_clock::now = 0xFFFFFFFFu - 500;
+    scheduler s;
+    trace t;
+    blink b(t, 1, 1_ms, 3);
+    s.spawn(b);
+
+    s.poll();
+    virtual_clock::now += 999;
+    TEST_ASSERT_EQUAL(0, s.poll());
+    while (!s.empty()) step_to_next(s);
+    TEST_ASSERT_EQUAL(3, t.n);
+    TEST_ASSERT_EQUAL(0xFFFFFFFFu - 500 + 2000, t.at[2]);
+}
+
+// Test await_until, yield, spawn and cancel from inside a task
+void test_scheduler_until_yield_cancel() {
+    virtual_clock::now = 0;
+    scheduler s;
+    bool flag = false;
+    waiter w(flag);
+    counter c;
+    parent p(s, c);
+    s.spawn(w);
+    s.spawn(p);
+
+    for (int i = 0; i < 5; i++) s.poll();
+    TEST_ASSERT_FALSE(w.finished);
+    TEST_ASSERT_TRUE(c.is_running());
+    TEST_ASSERT_EQUAL(3, s.size());
+    uint32_t before = c.count;
+    TEST_ASSERT_TRUE(before >= 4);
+
+    flag = true;
+    s.poll();
+    TEST_ASSERT_TRUE(w.finished);
+    TEST_ASSERT_FALSE(w.is_running());
+
+    virtual_clock::now = 10000;
+    s.poll();
+    TEST_ASSERT_FALSE(c.is_running());
+    TEST_ASSERT_TRUE(s.empty());
+    uint32_t after = c.count;
+    s.poll();
+    TEST_ASSERT_EQUAL(after, c.count);
+
+    // a finished task can be spawned again and starts over
+    flag = false;
+    s.spawn(w);
+    s.spawn(w);
+    TEST_ASSERT_EQUAL(1, s.size());
+    TEST_ASSERT_TRUE(s.cancel(w));
+    TEST_ASSERT_FALSE(s.cancel(w));
+}
+
+// Test many tasks cost a few bytes each and all finish
+void test_scheduler_many_tasks() {
+    virtual_clock::now = 0;
+    scheduler s;
+#ifndef ARDUINO
+    tick tasks[200];
+#else
+    tick tasks[20];
+#endif
+    for (auto& t : tasks) s.spawn(t);
+    TEST_ASSERT_EQUAL(sizeof(tasks) / sizeof(tasks[0]), s.size());
+
+    while (!s.empty()) step_to_next(s);
+    for (auto& t : tasks) TEST_ASSERT_EQUAL(10, t.n);
+    TEST_ASSERT_EQUAL(10000, virtual_clock::now);
+
+    // vptr, resume line, deadline, two links, queued flag
+    TEST_ASSERT_TRUE(sizeof(msd::task) <= 4 * sizeof(void*) + 8);
+}
+
+// ==================== 性能测试 ====================
+
+// Cost of one resume through the scheduler
+void test_scheduler_performance() {
+    virtual_clock::now = 0;
+    scheduler s;
+#ifndef ARDUINO
+    counter tasks[64];
+    const uint32_t rounds = 100000;
+#else
+    counter tasks[8];
+    const uint32_t rounds = 100;
+#endif
+    for (auto& t : tasks) s.spawn(t);
+
+    unsigned long start = micros();
+    for (uint32_t r = 0; r < rounds; r++) s.poll();
+    unsigned long us = micros() - start;
+
+    const size_t n = sizeof(tasks) / sizeof(tasks[0]);
+    TEST_ASSERT_EQUAL(rounds, tasks[n - 1].count);
+    bench_report("resume, ns per task", us * 1000.0 / (static_cast<double>(rounds) * n), "ns");
+    bench_report("sizeof(msd::task)", sizeof(msd::task), "B");
+}
+
+void test_scheduler() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_scheduler_interleave);
+    RUN_TEST(test_scheduler_await_not_early);
+    RUN_TEST(test_scheduler_wraparound);
+    RUN_TEST(test_scheduler_until_yield_cancel);
+    RUN_TEST(test_scheduler_many_tasks);
+
+    RUN_TEST(test_scheduler_performance);
+
+    UNITY_END();
+}
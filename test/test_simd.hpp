@@ -0,0 +1,256 @@
+#pragma once
+
+#include <unity.h>
+
+#include <algorithm>
+#include <array>
+#include <simd>
+#include <vector>
+
+#include "test_bench.hpp"
+
+namespace msd_simd_test {
+
+// every length up to a few vectors, at every misalignment inside one vector
+template <typename T>
+void check_kernels() {
+    const size_t max_len = 100;
+    T buf[max_len + 32], other[max_len + 32];
+
+    for (size_t offset = 0; offset < 32 / sizeof(T) + 1; offset++) {
+        for (size_t n = 0; n <= max_len; n++) {
+            T* a = buf + offset;
+            T* b = other + offset;
+            for (size_t i = 0; i < n; i++) a[i] = b[i] = static_cast<T>((i * 7 + offset) % 13);
+
+            // find / count, present and absent
+            const T* hit = msd::simd::find(a, a + n, static_cast<T>(5));
+            size_t ref   = 0;
+            const T* exp = a + n;
+            for (size_t i = n; i-- > 0;) {
+                if (a[i] == static_cast<T>(5)) exp = a + i, ref++;
+            }
+            TEST_ASSERT_EQUAL_PTR(exp, hit);
+            TEST_ASSERT_EQUAL(ref, msd::simd::count(a, a + n, static_cast<T>(5)));
+            TEST_ASSERT_EQUAL_PTR(a + n, msd::simd::find(a, a + n, static_cast<T>(99)));
+
+            // min / max return the first extreme element
+            if (n > 0) {
+                a[n / 2]   = static_cast<T>(-1 < T(0) ? -3 : 0);
+                a[n - 1]   = static_cast<T>(-1 < T(0) ? -3 : 0);
+                a[n / 3]   = static_cast<T>(50);
+                size_t lo  = 0, hi = 0;
+                for (size_t i = 1; i < n; i++) {
+                    if (a[i] < a[lo]) lo = i;
+                    if (a[hi] < a[i]) hi = i;
+                }
+                TEST_ASSERT_EQUAL_PTR(a + lo, msd::simd::min_element(a, a + n));
+                TEST_ASSERT_EQUAL_PTR(a + hi, msd::simd::max_element(a, a + n));
+                for (size_t i = 0; i < n; i++) b[i] = a[i];
+            } else {
+                TEST_ASSERT_EQUAL_PTR(a, msd::simd::min_element(a, a));
+            }
+
+            // equal, and a single differing element anywhere
+            TEST_ASSERT_TRUE(msd::simd::equal(a, a + n, b));
+            if (n > 0) {
+                b[n - 1] = static_cast<T>(b[n - 1] + 1);
+                TEST_ASSERT_FALSE(msd::simd::equal(a, a + n, b));
+            }
+
+            // fill must not write past the end
+            a[n] = static_cast<T>(77);
+            msd::simd::fill(a, a + n, static_cast<T>(9));
+            for (size_t i = 0; i < n; i++) TEST_ASSERT_EQUAL(9, a[i]);
+            TEST_ASSERT_EQUAL(77, a[n]);
+            TEST_ASSERT_EQUAL(9 * n, msd::simd::sum<int64_t>(a, a + n));
+        }
+    }
+}
+
+// the loops msd::simd replaces, kept scalar so the comparison is fair
+__attribute__((optimize("no-tree-vectorize"))) inline size_t count_loop(const float* p, size_t n, float v) {
+    size_t c = 0;
+    for (size_t i = 0; i < n; i++) c += p[i] == v;
+    return c;
+}
+__attribute__((optimize("no-tree-vectorize"))) inline bool equal_loop(const float* a, const float* b, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        if (a[i] != b[i]) return false;
+    return true;
+}
+__attribute__((optimize("no-tree-vectorize"))) inline const float* min_loop(const float* p, size_t n) {
+    const float* best = p;
+    for (size_t i = 1; i < n; i++)
+        if (p[i] < *best) best = p + i;
+    return best;
+}
+__attribute__((optimize("no-tree-vectorize"))) inline const float* find_loop(const float* p, size_t n, float v) {
+    for (size_t i = 0; i < n; i++)
+        if (p[i] == v) return p + i;
+    return p + n;
+}
+__attribute__((optimize("no-tree-vectorize"))) inline double sum_loop(const int16_t* p, size_t n) {
+    int32_t s = 0;
+    for (size_t i = 0; i < n; i++) s += p[i];
+    return s;
+}
+
+inline void report_rate(const char* name, size_t bytes, unsigned long us) {
+    bench_report(name, us ? static_cast<double>(bytes) / us / 1000.0 : 0.0, "GB/s");
+}
+
+} // namespace msd_simd_test
+
+using namespace msd_simd_test;
+
+void test_simd_kernels_integral() {
+    check_kernels<uint8_t>();
+    check_kernels<int8_t>();
+    check_kernels<uint16_t>();
+    check_kernels<int32_t>();
+    check_kernels<int64_t>();
+}
+
+void test_simd_kernels_floating() {
+    check_kernels<float>();
+    check_kernels<double>();
+
+    // -0.0 and 0.0 compare equal, NaN never does
+    float a[40] = {}, b[40] = {};
+    for (int i = 0; i < 40; i++) b[i] = -0.0f;
+    TEST_ASSERT_TRUE(msd::simd::equal(a, a + 40, b));
+    a[20] = b[20] = __builtin_nanf("");
+    TEST_ASSERT_FALSE(msd::simd::equal(a, a + 40, b));
+}
+
+// Test count does not overflow its per-lane byte counters
+void test_simd_count_large() {
+    const size_t n = 100000;
+    static uint8_t data[n];
+    msd::simd::fill(data, data + n, static_cast<uint8_t>(3));
+    data[n - 1] = 4;
+    TEST_ASSERT_EQUAL(n - 1, msd::simd::count(data, data + n, static_cast<uint8_t>(3)));
+    TEST_ASSERT_EQUAL(3 * (n - 1) + 4, (msd::simd::sum<uint32_t>(data, data + n)));
+}
+
+// Test the kernels are reached through algorithm and the containers
+void test_simd_wiring() {
+    msd::vector<int16_t> v;
+    for (int i = 0; i < 100; i++) v.push_back(static_cast<int16_t>(i - 50));
+
+    TEST_ASSERT_EQUAL(60, msd::find(v.begin(), v.end(), 10) - v.begin());
+    TEST_ASSERT_TRUE(msd::find(v.begin(), v.end(), 70000) == v.end());
+    TEST_ASSERT_EQUAL(1, msd::count(v.begin(), v.end(), -50));
+    TEST_ASSERT_EQUAL(-50, *msd::min_element(v.begin(), v.end()));
+    TEST_ASSERT_EQUAL(49, *msd::max_element(v.data(), v.data() + v.size()));
+    TEST_ASSERT_EQUAL(-50, msd::accumulate(v.begin(), v.end(), 0L));
+
+    // init = init + *it: an int total over floats drops the fraction of each partial sum
+    float halves[16];
+    msd::fill(halves, halves + 16, -0.5f);
+    TEST_ASSERT_EQUAL(0, msd::accumulate(halves, halves + 16, 5));
+    TEST_ASSERT_EQUAL_FLOAT(-3.0f, msd::accumulate(halves, halves + 16, 5.0f));
+
+    // floating point is added left to right, not reordered across lanes: 1 + 1e8 loses the 1
+    float big[64];
+    msd::vector<float> big_v;
+    float fold = 0;
+    for (int i = 0; i < 64; i++) {
+        big[i] = i % 3 == 0 ? 1.0f : i % 3 == 1 ? 1e8f : -1e8f;
+        big_v.push_back(big[i]);
+        fold = fold + big[i];
+    }
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, fold);
+    TEST_ASSERT_EQUAL_FLOAT(fold, msd::accumulate(big, big + 64, 0.0f));
+    TEST_ASSERT_EQUAL_FLOAT(fold, msd::accumulate(big_v.begin(), big_v.end(), 0.0f));
+
+    msd::vector<int16_t> w(v);
+    TEST_ASSERT_TRUE(v == w);
+    w[99] = 0;
+    TEST_ASSERT_TRUE(v != w);
+    TEST_ASSERT_FALSE(msd::equal(v.begin(), v.end(), w.begin()));
+
+    msd::array<float, 37> a, b;
+    a.fill(1.5f);
+    b.fill(1.5f);
+    TEST_ASSERT_TRUE(a == b);
+    TEST_ASSERT_FALSE(a != b);
+    b[36] = 0.0f;
+    TEST_ASSERT_TRUE(a != b);
+    msd::fill(b.begin(), b.end(), 1.5);
+    TEST_ASSERT_TRUE(a == b);
+}
+
+// ==================== 性能测试 ====================
+
+void test_simd_performance() {
+#ifndef ARDUINO
+    const size_t n = 4 * 1024 * 1024; // 16 MB of float
+#else
+    const size_t n = 256;
+#endif
+    static float a[n], b[n];
+    static int16_t s[n];
+    for (size_t i = 0; i < n; i++) a[i] = b[i] = static_cast<float>(i % 1000), s[i] = static_cast<int16_t>(i % 1000);
+
+    unsigned long start;
+    size_t c1, c2;
+
+    start = micros();
+    bench_keep(find_loop(a, n, -1.0f));
+    report_rate("find float, scalar", n * sizeof(float), micros() - start);
+    start = micros();
+    bench_keep(msd::simd::find(a, a + n, -1.0f));
+    report_rate("find float, simd", n * sizeof(float), micros() - start);
+
+    start = micros();
+    c1 = count_loop(a, n, 7.0f);
+    report_rate("count float, scalar", n * sizeof(float), micros() - start);
+    start = micros();
+    c2 = msd::simd::count(a, a + n, 7.0f);
+    report_rate("count float, simd", n * sizeof(float), micros() - start);
+    TEST_ASSERT_EQUAL(c1, c2);
+
+    start = micros();
+    const float* m1 = min_loop(a, n);
+    report_rate("min_element float, scalar", n * sizeof(float), micros() - start);
+    start = micros();
+    const float* m2 = msd::simd::min_element(a, a + n);
+    report_rate("min_element float, simd", n * sizeof(float), micros() - start);
+    TEST_ASSERT_EQUAL_PTR(m1, m2);
+
+    start = micros();
+    bool e1 = equal_loop(a, b, n);
+    report_rate("equal float, scalar", 2 * n * sizeof(float), micros() - start);
+    start = micros();
+    bool e2 = msd::simd::equal(a, a + n, b);
+    report_rate("equal float, simd", 2 * n * sizeof(float), micros() - start);
+    TEST_ASSERT_TRUE(e1 && e2);
+
+    start = micros();
+    msd::simd::fill(b, b + n, 2.0f);
+    report_rate("fill float, simd", n * sizeof(float), micros() - start);
+    bench_keep(b[n - 1]);
+
+    start = micros();
+    double r1 = sum_loop(s, n);
+    report_rate("sum int16 -> int32, scalar", n * sizeof(int16_t), micros() - start);
+    start = micros();
+    double r2 = msd::simd::sum<int32_t>(s, s + n);
+    report_rate("sum int16 -> int32, simd", n * sizeof(int16_t), micros() - start);
+    TEST_ASSERT_EQUAL_DOUBLE(r1, r2);
+}
+
+void test_simd() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_simd_kernels_integral);
+    RUN_TEST(test_simd_kernels_floating);
+    RUN_TEST(test_simd_count_large);
+    RUN_TEST(test_simd_wiring);
+
+    RUN_TEST(test_simd_performance);
+
+    UNITY_END();
+}
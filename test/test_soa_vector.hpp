@@ -0,0 +1,167 @@
+#pragma once
+
+#include <unity.h>
+
+#include <soa_vector>
+#include <tuple>
+#include <vector>
+
+#include "test_bench.hpp"
+
+// Test default construction and push_back
+void test_soa_vector_push_back() {
+    msd::soa_vector<uint32_t, float, char> v;
+    TEST_ASSERT_TRUE(v.empty());
+    TEST_ASSERT_EQUAL(0, v.size());
+
+    for (uint32_t i = 0; i < 100; i++) v.push_back(i, i * 0.5f, static_cast<char>('a' + i % 26));
+
+    TEST_ASSERT_EQUAL(100, v.size());
+    TEST_ASSERT_TRUE(v.capacity() >= 100);
+    for (uint32_t i = 0; i < 100; i++) {
+        TEST_ASSERT_EQUAL(i, msd::get<0>(v[i]));
+        TEST_ASSERT_EQUAL_FLOAT(i * 0.5f, msd::get<1>(v[i]));
+        TEST_ASSERT_EQUAL('a' + i % 26, msd::get<2>(v[i]));
+    }
+}
+
+// Test row access returns references into the columns
+void test_soa_vector_row_access() {
+    msd::soa_vector<int, double> v;
+    v.push_back(1, 1.5);
+    v.push_back(2, 2.5);
+
+    msd::get<0>(v[1]) = 20;
+    auto [i, d]       = v[0];
+    d                 = 10.5;
+
+    TEST_ASSERT_EQUAL(20, v.data<0>()[1]);
+    TEST_ASSERT_EQUAL_DOUBLE(10.5, v.data<1>()[0]);
+
+    auto row = v.emplace_back(3, 3.5);
+    TEST_ASSERT_EQUAL(3, msd::get<0>(row));
+    TEST_ASSERT_EQUAL(3, v.size());
+
+    // tie / apply on a row
+    int a    = 0;
+    double b = 0;
+    msd::tie(a, b) = v[2];
+    TEST_ASSERT_EQUAL(3, a);
+    TEST_ASSERT_EQUAL_DOUBLE(3.5, b);
+}
+
+// Test each column is one contiguous array
+void test_soa_vector_columns() {
+    msd::soa_vector<uint16_t, int32_t> v;
+    for (int i = 0; i < 50; i++) v.push_back(static_cast<uint16_t>(i), -i);
+
+    auto c0 = v.column<0>();
+    auto c1 = v.column<1>();
+    TEST_ASSERT_EQUAL(50, c0.size());
+    TEST_ASSERT_EQUAL(50, c1.size());
+    TEST_ASSERT_EQUAL_PTR(v.data<0>(), c0.data());
+
+    int32_t sum = 0;
+    for (auto x : c1) sum += x;
+    TEST_ASSERT_EQUAL(-1225, sum);
+
+    // column writes are visible through rows
+    c0[10] = 999;
+    TEST_ASSERT_EQUAL(999, msd::get<0>(v[10]));
+}
+
+// Test copy, move, clear and pop_back
+void test_soa_vector_copy_move() {
+    msd::soa_vector<int, float> a;
+    for (int i = 0; i < 20; i++) a.push_back(i, i * 2.0f);
+
+    msd::soa_vector<int, float> b(a);
+    TEST_ASSERT_EQUAL(20, b.size());
+    TEST_ASSERT_EQUAL(19, msd::get<0>(b[19]));
+    TEST_ASSERT_TRUE(a.data<0>() != b.data<0>());
+
+    msd::soa_vector<int, float> c(msd::move(a));
+    TEST_ASSERT_EQUAL(20, c.size());
+    TEST_ASSERT_EQUAL(0, a.size());
+    TEST_ASSERT_NULL(a.data<0>());
+
+    c.pop_back();
+    TEST_ASSERT_EQUAL(19, c.size());
+
+    b = c;
+    TEST_ASSERT_EQUAL(19, b.size());
+    TEST_ASSERT_EQUAL_FLOAT(36.0f, msd::get<1>(b[18]));
+
+    c.clear();
+    TEST_ASSERT_TRUE(c.empty());
+}
+
+// Test non trivially copyable columns survive growth
+void test_soa_vector_complex_types() {
+    msd::soa_vector<msd::vector<int>, int> v;
+    for (int i = 0; i < 40; i++) {
+        msd::vector<int> inner;
+        for (int j = 0; j <= i; j++) inner.push_back(j);
+        v.push_back(inner, i);
+    }
+
+    TEST_ASSERT_EQUAL(40, v.size());
+    TEST_ASSERT_EQUAL(40, msd::get<0>(v[39]).size());
+    TEST_ASSERT_EQUAL(39, msd::get<0>(v[39])[39]);
+}
+
+// ==================== 性能测试 ====================
+
+// Sum one column across many rows, structure of arrays vs array of structs
+void test_soa_vector_performance_column_sum() {
+#ifndef ARDUINO
+    const size_t rows = 10000000UL;
+#else
+    const size_t rows = 200;
+#endif
+    using Row = msd::tuple<uint32_t, float, float, float>; // timestamp, x, y, z
+
+    uint64_t aos_sum = 0, soa_sum = 0;
+    unsigned long aos_us = 0, soa_us = 0;
+    {
+        msd::vector<Row> aos;
+        aos.reserve(rows);
+        for (size_t i = 0; i < rows; i++) aos.emplace_back(static_cast<uint32_t>(i), 1.0f, 2.0f, 3.0f);
+
+        unsigned long start = micros();
+        for (size_t i = 0; i < rows; i++) aos_sum += msd::get<0>(aos[i]);
+        aos_us = micros() - start;
+        bench_keep(aos_sum);
+    }
+    {
+        msd::soa_vector<uint32_t, float, float, float> soa;
+        soa.reserve(rows);
+        for (size_t i = 0; i < rows; i++) soa.push_back(static_cast<uint32_t>(i), 1.0f, 2.0f, 3.0f);
+
+        unsigned long start = micros();
+        auto ts             = soa.column<0>();
+        for (size_t i = 0; i < ts.size(); i++) soa_sum += ts[i];
+        soa_us = micros() - start;
+        bench_keep(soa_sum);
+    }
+
+    TEST_ASSERT_EQUAL_UINT64(static_cast<uint64_t>(rows) * (rows - 1) / 2, aos_sum);
+    TEST_ASSERT_EQUAL_UINT64(aos_sum, soa_sum);
+
+    bench_report("column sum, vector<tuple>", aos_us, "us");
+    bench_report("column sum, soa_vector", soa_us, "us");
+}
+
+void test_soa_vector() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_soa_vector_push_back);
+    RUN_TEST(test_soa_vector_row_access);
+    RUN_TEST(test_soa_vector_columns);
+    RUN_TEST(test_soa_vector_copy_move);
+    RUN_TEST(test_soa_vector_complex_types);
+
+    RUN_TEST(test_soa_vector_performance_column_sum);
+
+    UNITY_END();
+}
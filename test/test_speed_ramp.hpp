@@ -0,0 +1,282 @@
+#pragma once
+
+#include <unity.h>
+
+#include <speed_ramp.hpp>
+
+#include "test_bench.hpp"
+
+namespace msd_speed_ramp_test {
+
+using firmware::step_motor::RampDriver;
+using firmware::step_motor::RampState;
+using firmware::step_motor::SpeedRamp;
+
+// Timer1 stand-in: the test loop plays the hardware and fires the ISR when the period elapses
+struct sim_timer {
+    static constexpr uint32_t frequency = 250000; // 16 MHz / 64
+    static inline bool running          = false;
+    static inline bool enabled          = false;
+    static inline uint16_t period       = 0;
+    static inline uint32_t starts       = 0;
+    static inline void (*handler)()     = nullptr;
+
+    static void attach(void (*h)()) noexcept { handler = h; }
+
+    static void start(uint16_t p) noexcept { running = enabled = true, period = p, starts++; }
+    static void set_period(uint16_t p) noexcept { period = p; }
+    static void stop() noexcept { running = enabled = false; }
+    static bool mask() noexcept {
+        bool e  = enabled;
+        enabled = false;
+        return e;
+    }
+    static void unmask(bool e) noexcept { enabled = enabled || e; }
+};
+
+// one recorded move: tick of every step and its direction
+struct run_log {
+    static constexpr size_t cap = 20000;
+    uint32_t at[cap];
+    size_t n   = 0;
+    int fwd    = 0;
+    int back   = 0;
+    uint32_t t = 0;
+};
+
+// fire the ISR until the timer stops, the ISR reprograms the period for the following interrupt
+inline void simulate(RampDriver<sim_timer>& d, run_log& log) {
+    while (sim_timer::running) {
+        log.t += sim_timer::period;
+        d.isr([&log](bool forward) {
+            if (log.n < run_log::cap) log.at[log.n] = log.t;
+            log.n++;
+            (forward ? log.fwd : log.back)++;
+        });
+    }
+}
+
+// interval between step i and i + 1 in ticks
+inline uint32_t gap(const run_log& log, size_t i) { return log.at[i + 1] - log.at[i]; }
+
+} // namespace msd_speed_ramp_test
+
+using namespace msd_speed_ramp_test;
+
+// Test move() only arms the timer, nothing is emitted until the ISR fires
+void test_speed_ramp_non_blocking() {
+    RampDriver<sim_timer> d;
+    sim_timer::starts = 0;
+    d.move(100, 1000, 2000, 2000);
+
+    TEST_ASSERT_TRUE(sim_timer::running);
+    TEST_ASSERT_EQUAL(1, sim_timer::starts);
+    TEST_ASSERT_TRUE(d.is_running());
+    TEST_ASSERT_EQUAL(static_cast<int>(RampState::ACCEL), static_cast<int>(d.state()));
+    TEST_ASSERT_EQUAL(0, d.position());
+    TEST_ASSERT_EQUAL(100, d.steps_left());
+
+    static run_log log;
+    log = run_log{};
+    simulate(d, log);
+    TEST_ASSERT_FALSE(d.is_running());
+    TEST_ASSERT_EQUAL(static_cast<int>(RampState::STOP), static_cast<int>(d.state()));
+    TEST_ASSERT_EQUAL(100, log.n);
+    TEST_ASSERT_EQUAL(100, d.position());
+    TEST_ASSERT_EQUAL(0, d.steps_left());
+}
+
+// Test every move emits exactly the requested steps, in the requested direction
+void test_speed_ramp_exact_count() {
+    const int32_t moves[] = { 1, 2, 3, 7, 10, 99, 100, 1000, 12345, -1, -2, -500 };
+    RampDriver<sim_timer> d;
+    static run_log log;
+    int32_t pos = 0;
+    for (int32_t m : moves) {
+        log = run_log{};
+        d.move(m, 3000, 5000, 2500);
+        simulate(d, log);
+        pos += m;
+        TEST_ASSERT_EQUAL(m < 0 ? -m : m, static_cast<int32_t>(log.n));
+        TEST_ASSERT_EQUAL(m < 0 ? 0 : m, log.fwd);
+        TEST_ASSERT_EQUAL(pos, d.position());
+    }
+    d.move(0, 1000, 1000, 1000);
+    TEST_ASSERT_FALSE(d.is_running());
+}
+
+// Test the profile is a trapezoid: faster while accelerating, flat at cruise, slower while decelerating
+void test_speed_ramp_trapezoid() {
+    const uint16_t speed = 2000, accel = 4000;
+    RampDriver<sim_timer> d;
+    static run_log log;
+    log = run_log{};
+    d.move(5000, speed, accel, accel);
+    simulate(d, log);
+    TEST_ASSERT_EQUAL(5000, log.n);
+
+    const uint32_t min_delay = sim_timer::frequency / speed;
+    size_t i = 0;
+    for (; i + 1 < log.n && gap(log, i) > min_delay; i++) TEST_ASSERT_TRUE(i == 0 || gap(log, i) <= gap(log, i - 1));
+    size_t cruise_start = i;
+    for (; i + 1 < log.n && gap(log, i) == min_delay; i++) {}
+    size_t cruise_end = i;
+    for (; i + 1 < log.n; i++) TEST_ASSERT_TRUE(gap(log, i) >= gap(log, i - 1));
+
+    // v^2 / 2a = 500 steps to reach cruise speed, and as many to stop
+    TEST_ASSERT_INT_WITHIN(10, 500, cruise_start);
+    TEST_ASSERT_INT_WITHIN(10, 500, log.n - cruise_end);
+
+    // reaching cruise takes v / a = 0.5 s
+    double t_accel = static_cast<double>(log.at[cruise_start]) / sim_timer::frequency;
+    TEST_ASSERT_DOUBLE_WITHIN(0.02, 0.5, t_accel);
+
+    // whole move: two ramps of 0.5 s plus 4000 steps at 2000 steps/s
+    double total = static_cast<double>(log.at[log.n - 1]) / sim_timer::frequency;
+    TEST_ASSERT_DOUBLE_WITHIN(0.03, 3.0, total);
+}
+
+// Test short moves never reach cruise speed and peak half way, uneven accel / decel split the move
+void test_speed_ramp_triangle() {
+    RampDriver<sim_timer> d;
+    static run_log log;
+    log = run_log{};
+    d.move(200, 5000, 4000, 4000);
+    simulate(d, log);
+    TEST_ASSERT_EQUAL(200, log.n);
+
+    size_t fastest = 0;
+    for (size_t i = 1; i + 1 < log.n; i++)
+        if (gap(log, i) < gap(log, fastest)) fastest = i;
+    TEST_ASSERT_TRUE(gap(log, fastest) > sim_timer::frequency / 5000);
+    TEST_ASSERT_INT_WITHIN(3, 100, fastest);
+
+    // decelerating at a third of the acceleration leaves a quarter of the move for accelerating
+    log = run_log{};
+    d.move(400, 5000, 3000, 1000);
+    simulate(d, log);
+    fastest = 0;
+    for (size_t i = 1; i + 1 < log.n; i++)
+        if (gap(log, i) < gap(log, fastest)) fastest = i;
+    TEST_ASSERT_INT_WITHIN(4, 100, fastest);
+}
+
+// Test zero acceleration and deceleration run at constant speed
+void test_speed_ramp_constant() {
+    RampDriver<sim_timer> d;
+    static run_log log;
+    log = run_log{};
+    d.move(-50, 1000, 0, 0);
+    TEST_ASSERT_EQUAL(static_cast<int>(RampState::RUN), static_cast<int>(d.state()));
+    simulate(d, log);
+    TEST_ASSERT_EQUAL(50, log.back);
+    for (size_t i = 0; i + 1 < log.n; i++) TEST_ASSERT_EQUAL(250, gap(log, i));
+
+    // stop() halts mid move
+    d.move(1000, 1000, 1000, 1000);
+    for (int i = 0; i < 10; i++) d.isr([](bool) {});
+    d.stop();
+    TEST_ASSERT_FALSE(d.is_running());
+    TEST_ASSERT_FALSE(sim_timer::running);
+    TEST_ASSERT_EQUAL(-50 + 10, d.position());
+}
+
+// Test delays past the 16-bit period are kept whole, not clamped
+void test_speed_ramp_long_delays() {
+    RampDriver<sim_timer> d;
+    static run_log log;
+    log = run_log{};
+    d.move(5, 2, 0, 0); // 2 steps/s: 125000 ticks a step
+    simulate(d, log);
+    TEST_ASSERT_EQUAL(5, log.n);
+    for (size_t i = 0; i + 1 < log.n; i++) TEST_ASSERT_EQUAL(125000, gap(log, i));
+    TEST_ASSERT_EQUAL(125000, log.at[0]);
+
+    // a gentle ramp: the first step is 0.676 * f * sqrt(2 / a) away, the steps follow the ramp's delays
+    SpeedRamp r;
+    static uint32_t delays[40];
+    size_t n = 0;
+    for (uint32_t delay = r.plan(40, 20, 1, 1, sim_timer::frequency); delay; delay = r.next()) delays[n++] = delay;
+    TEST_ASSERT_TRUE(delays[0] > 0xFFFF);
+    log = run_log{};
+    d.move(40, 20, 1, 1);
+    simulate(d, log);
+    TEST_ASSERT_EQUAL(40, log.n);
+    TEST_ASSERT_EQUAL(delays[0], log.at[0]);
+    for (size_t i = 0; i + 1 < log.n; i++) TEST_ASSERT_EQUAL(delays[i + 1], gap(log, i));
+}
+
+// Test moves that start and end moving pick the curve up at the entry speed and leave at the exit speed
+void test_speed_ramp_entry_exit() {
+    SpeedRamp r;
+    static uint32_t gaps[2000];
+    size_t n = 0;
+    uint32_t delay = r.plan(2000, 1000, 2000, 500, 4000, sim_timer::frequency);
+    TEST_ASSERT_EQUAL(250, delay); // 1000 steps/s
+    for (; delay; delay = r.next()) gaps[n++] = delay;
+    TEST_ASSERT_EQUAL(2000, n);
+    TEST_ASSERT_EQUAL(125, gaps[1000]);          // cruising at 2000 steps/s
+    TEST_ASSERT_INT_WITHIN(25, 500, gaps[n - 1]); // 500 steps/s at the end
+    // (2000^2 - 1000^2) / 2a = 375 steps to speed up
+    size_t cruise = 0;
+    while (gaps[cruise] > 125) cruise++;
+    TEST_ASSERT_INT_WITHIN(5, 375, cruise);
+
+    // too short to cruise and entered at full speed: decelerates from the first step
+    n     = 0;
+    delay = r.plan(100, 2000, 2000, 0, 4000, sim_timer::frequency);
+    TEST_ASSERT_EQUAL(static_cast<int>(RampState::DECEL), static_cast<int>(r.state()));
+    for (; delay; delay = r.next()) gaps[n++] = delay;
+    TEST_ASSERT_EQUAL(100, n);
+    for (size_t i = 1; i < n; i++) TEST_ASSERT_TRUE(gaps[i] >= gaps[i - 1]);
+    // v^2 = 2000^2 - 2 * 4000 * 100 leaves 1789 steps/s, 140 ticks
+    TEST_ASSERT_INT_WITHIN(3, 140, gaps[n - 1]);
+}
+
+// Test the planner's integer square root
+void test_speed_ramp_isqrt() {
+    using firmware::step_motor::__details::isqrt;
+    TEST_ASSERT_EQUAL(0, isqrt(0));
+    TEST_ASSERT_EQUAL(1, isqrt(3));
+    TEST_ASSERT_EQUAL(2, isqrt(4));
+    TEST_ASSERT_EQUAL(65535, isqrt(4294967295ULL));
+    TEST_ASSERT_EQUAL(4000000000u, isqrt(16000000000000000000ULL));
+}
+
+// ==================== 性能测试 ====================
+
+// Cost of one ISR update of the recurrence
+void test_speed_ramp_performance() {
+    SpeedRamp r;
+#ifndef ARDUINO
+    const uint32_t n = 1000000;
+#else
+    const uint32_t n = 1000;
+#endif
+    unsigned long start = micros();
+    uint32_t sum        = 0;
+    for (uint32_t k = 0; k < 20; k++) {
+        r.plan(n / 20, 60000, 100, 100, sim_timer::frequency); // accelerating or decelerating the whole time
+        while (r.is_running()) sum += r.next();
+    }
+    unsigned long us = micros() - start;
+    bench_keep(sum);
+    bench_report("ramp update, ns per step", us * 1000.0 / n, "ns");
+}
+
+void test_speed_ramp() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_speed_ramp_non_blocking);
+    RUN_TEST(test_speed_ramp_exact_count);
+    RUN_TEST(test_speed_ramp_trapezoid);
+    RUN_TEST(test_speed_ramp_triangle);
+    RUN_TEST(test_speed_ramp_constant);
+    RUN_TEST(test_speed_ramp_long_delays);
+    RUN_TEST(test_speed_ramp_entry_exit);
+    RUN_TEST(test_speed_ramp_isqrt);
+
+    RUN_TEST(test_speed_ramp_performance);
+
+    UNITY_END();
+}
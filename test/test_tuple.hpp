@@ -8,14 +8,7 @@
     TEST_ASSERT_EQUAL_UINT((expected), (actual))
 
 // ==================== 测试辅助函数 ====================
-#ifndef ARDUINO
-// 非Arduino环境的时间函数替代
-unsigned long micros() {
-    return 0; // 简化版本，或者使用 chrono
-}
-#else
-#include <Arduino.h>
-#endif
+#include "test_bench.hpp"
 
 // ==================== 基本功能测试 ====================
 
@@ -178,6 +171,54 @@ void test_tuple_empty_base_optimization() {
     TEST_ASSERT_EQUAL_SIZE_T(1, sizeof(empty));
 }
 
+void test_tuple_ebo_sizeof() {
+    struct Empty {};
+    struct Empty2 {};
+
+    // 空类型不占空间
+    TEST_ASSERT_EQUAL_SIZE_T(sizeof(int), sizeof(msd::tuple<int, Empty>));
+    TEST_ASSERT_EQUAL_SIZE_T(sizeof(int), sizeof(msd::tuple<Empty, int, Empty2>));
+    TEST_ASSERT_EQUAL_SIZE_T(1, sizeof(msd::tuple<Empty>));
+
+    // 和等价struct一样大
+    struct Equivalent {
+        uint16_t a;
+        uint16_t b;
+        uint32_t c;
+    };
+    TEST_ASSERT_EQUAL_SIZE_T(sizeof(Equivalent), sizeof(msd::tuple<uint16_t, uint16_t, uint32_t>));
+}
+
+void test_tuple_member_order() {
+    // 元素按声明顺序排列
+    msd::tuple<uint8_t, uint8_t, uint8_t> t(1, 2, 3);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&t);
+
+    TEST_ASSERT_EQUAL_PTR(&msd::get<0>(t), p);
+    TEST_ASSERT_EQUAL_PTR(&msd::get<1>(t), p + 1);
+    TEST_ASSERT_EQUAL_PTR(&msd::get<2>(t), p + 2);
+}
+
+void test_tuple_trivially_copyable() {
+    struct Empty {};
+
+    TEST_ASSERT_TRUE((msd::is_trivially_copyable<msd::tuple<>>::value));
+    TEST_ASSERT_TRUE((msd::is_trivially_copyable<msd::tuple<int, double, char>>::value));
+    TEST_ASSERT_TRUE((msd::is_trivially_copyable<msd::tuple<int, Empty>>::value));
+    TEST_ASSERT_TRUE((msd::is_trivially_copyable<msd::tuple<int, msd::tuple<float, char>>>::value));
+
+    // 非平凡类型不能被当作平凡类型
+    struct NonTrivial {
+        int v;
+        NonTrivial() : v(0) {}
+        NonTrivial(const NonTrivial& o) : v(o.v + 1) {}
+    };
+    TEST_ASSERT_FALSE((msd::is_trivially_copyable<msd::tuple<int, NonTrivial>>::value));
+    msd::tuple<int, NonTrivial> a;
+    msd::tuple<int, NonTrivial> b(a);
+    TEST_ASSERT_EQUAL(1, msd::get<1>(b).v);
+}
+
 // ==================== 边界情况测试 ====================
 
 void test_tuple_large_tuple() {
@@ -284,6 +325,87 @@ void test_tuple_structure_bind() {
     TEST_ASSERT_EQUAL(20, b);
 }
 
+// ==================== apply / tie / tuple_cat / for_each ====================
+
+void test_tuple_apply() {
+    auto t = msd::make_tuple(1, 2, 3);
+
+    int sum = msd::apply([](int a, int b, int c) { return a + b + c; }, t);
+    TEST_ASSERT_EQUAL(6, sum);
+
+    // 通过引用修改
+    msd::apply([](int& a, int&, int& c) { a = 10, c = 30; }, t);
+    TEST_ASSERT_EQUAL(10, msd::get<0>(t));
+    TEST_ASSERT_EQUAL(30, msd::get<2>(t));
+
+    // 空tuple
+    TEST_ASSERT_EQUAL(7, msd::apply([]() { return 7; }, msd::tuple<>()));
+}
+
+void test_tuple_tie() {
+    int a    = 0;
+    double b = 0;
+    char c   = 0;
+
+    msd::tie(a, b, c) = msd::make_tuple(1, 2.5, 'C');
+    TEST_ASSERT_EQUAL(1, a);
+    TEST_ASSERT_EQUAL_DOUBLE(2.5, b);
+    TEST_ASSERT_EQUAL('C', c);
+
+    // ignore
+    int x = 0;
+    msd::tie(x, msd::ignore) = msd::make_tuple(42, 99);
+    TEST_ASSERT_EQUAL(42, x);
+
+    // tie 得到的是引用
+    auto t = msd::tie(a, b);
+    msd::get<0>(t) = 100;
+    TEST_ASSERT_EQUAL(100, a);
+}
+
+void test_tuple_cat() {
+    auto t = msd::tuple_cat(msd::make_tuple(1, 'a'), msd::tuple<>(), msd::make_tuple(2.5), msd::make_tuple(3, 4));
+
+    TEST_ASSERT_EQUAL_SIZE_T(5, msd::tuple_size<decltype(t)>::value);
+    TEST_ASSERT_TRUE((msd::is_same<decltype(t), msd::tuple<int, char, double, int, int>>::value));
+    TEST_ASSERT_EQUAL(1, msd::get<0>(t));
+    TEST_ASSERT_EQUAL('a', msd::get<1>(t));
+    TEST_ASSERT_EQUAL_DOUBLE(2.5, msd::get<2>(t));
+    TEST_ASSERT_EQUAL(3, msd::get<3>(t));
+    TEST_ASSERT_EQUAL(4, msd::get<4>(t));
+
+    // 边界
+    auto empty = msd::tuple_cat();
+    TEST_ASSERT_EQUAL_SIZE_T(0, msd::tuple_size<decltype(empty)>::value);
+    auto one = msd::tuple_cat(msd::make_tuple(9));
+    TEST_ASSERT_EQUAL(9, msd::get<0>(one));
+}
+
+void test_tuple_for_each() {
+    // 异构传感器记录
+    using SensorData = msd::tuple<uint16_t, int8_t, float, uint32_t>;
+    SensorData data(1000, -5, 0.5f, 4000UL);
+
+    double sum = 0;
+    msd::for_each(data, [&sum](auto v) { sum += v; });
+    TEST_ASSERT_EQUAL_DOUBLE(4995.5, sum);
+
+    // 通过引用修改
+    msd::for_each(data, [](auto& v) { v = v * 2; });
+    TEST_ASSERT_EQUAL(2000, msd::get<0>(data));
+    TEST_ASSERT_EQUAL(-10, msd::get<1>(data));
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, msd::get<2>(data));
+    TEST_ASSERT_EQUAL_UINT32(8000UL, msd::get<3>(data));
+
+    // 有状态函数对象
+    struct Counter {
+        int n = 0;
+        void operator()(...) { ++n; }
+    };
+    const SensorData& cdata = data;
+    TEST_ASSERT_EQUAL(4, msd::for_each(cdata, Counter{}).n);
+}
+
 void test_tuple() {
     UNITY_BEGIN();
 
@@ -313,6 +435,9 @@ void test_tuple() {
     // 内存布局
     RUN_TEST(test_tuple_memory_layout);
     RUN_TEST(test_tuple_empty_base_optimization);
+    RUN_TEST(test_tuple_ebo_sizeof);
+    RUN_TEST(test_tuple_member_order);
+    RUN_TEST(test_tuple_trivially_copyable);
 
     // 边界情况
     RUN_TEST(test_tuple_large_tuple);
@@ -330,5 +455,11 @@ void test_tuple() {
 
     RUN_TEST(test_tuple_structure_bind);
 
+    // apply / tie / tuple_cat / for_each
+    RUN_TEST(test_tuple_apply);
+    RUN_TEST(test_tuple_tie);
+    RUN_TEST(test_tuple_cat);
+    RUN_TEST(test_tuple_for_each);
+
     UNITY_END();
 }
\ No newline at end of file
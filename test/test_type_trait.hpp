@@ -399,6 +399,29 @@ void test_is_floating_point(void) {
 #endif
 }
 
+// 测试13b: is_signed / is_unsigned
+void test_is_signed(void) {
+#ifdef __cplusplus
+    using namespace msd;
+
+    TEST_ASSERT_TRUE(is_signed<int>::value);
+    TEST_ASSERT_TRUE(is_signed<const signed char>::value);
+    TEST_ASSERT_TRUE(is_signed<long long>::value);
+    TEST_ASSERT_TRUE(is_signed<double>::value);
+    TEST_ASSERT_FALSE(is_signed<unsigned>::value);
+    TEST_ASSERT_FALSE(is_signed<bool>::value);
+    TEST_ASSERT_FALSE(is_signed<int*>::value);
+
+    TEST_ASSERT_TRUE(is_unsigned<unsigned char>::value);
+    TEST_ASSERT_TRUE(is_unsigned<volatile uint32_t>::value);
+    TEST_ASSERT_TRUE(is_unsigned<bool>::value);
+    TEST_ASSERT_FALSE(is_unsigned<int>::value);
+    TEST_ASSERT_FALSE(is_unsigned<float>::value);
+
+    printf("✓ test_is_signed passed\n");
+#endif
+}
+
 // 测试14: is_same
 void test_is_same(void) {
 #ifdef __cplusplus
@@ -557,6 +580,26 @@ void test_is_nothrow_move_assignable(void) {
 #endif
 }
 
+// 测试19: integer_sequence
+void test_integer_sequence(void) {
+#ifdef __cplusplus
+    using namespace msd;
+
+    // 生成的序列
+    TEST_ASSERT_TRUE((is_same<make_index_sequence<0>, index_sequence<>>::value));
+    TEST_ASSERT_TRUE((is_same<make_index_sequence<1>, index_sequence<0>>::value));
+    TEST_ASSERT_TRUE((is_same<make_index_sequence<5>, index_sequence<0, 1, 2, 3, 4>>::value));
+    TEST_ASSERT_TRUE((is_same<make_integer_sequence<int, 3>, integer_sequence<int, 0, 1, 2>>::value));
+    TEST_ASSERT_TRUE((is_same<index_sequence_for<char, int, double>, index_sequence<0, 1, 2>>::value));
+
+    // 大小
+    TEST_ASSERT_EQUAL(0, make_index_sequence<0>::size());
+    TEST_ASSERT_EQUAL(100, make_index_sequence<100>::size());
+
+    printf("✓ test_integer_sequence passed\n");
+#endif
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -583,11 +626,13 @@ int test_type_traits(void) {
     RUN_TEST(msd_type_traits_unity_test::test_is_integral);
     RUN_TEST(msd_type_traits_unity_test::test_is_bool);
     RUN_TEST(msd_type_traits_unity_test::test_is_floating_point);
+    RUN_TEST(msd_type_traits_unity_test::test_is_signed);
     RUN_TEST(msd_type_traits_unity_test::test_is_same);
     RUN_TEST(msd_type_traits_unity_test::test_is_move_constructible);
     RUN_TEST(msd_type_traits_unity_test::test_is_nothrow_move_constructible);
     RUN_TEST(msd_type_traits_unity_test::test_is_move_assignable);
     RUN_TEST(msd_type_traits_unity_test::test_is_nothrow_move_assignable);
+    RUN_TEST(msd_type_traits_unity_test::test_integer_sequence);
 
     // 结束测试
     return UNITY_END();
@@ -0,0 +1,68 @@
+/*
+ * Turns a capture of the serial log back into text: binary frames are decoded with the string
+ * table of the firmware that sent them, text lines are passed through.
+ *
+ *     g++ -std=c++17 -Ilib/msd -Ilib/hardware tools/log_decode.cpp -o log_decode
+ *     log_decode .pio/build/uno/log_table.bin capture.bin      # or the capture on stdin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <arduino/logger/log_decoder.hpp>
+
+static firmware::log_decoder decoder;
+
+static char* read_file(const char* path, size_t& len) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return nullptr;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* data = static_cast<char*>(malloc(size > 0 ? static_cast<size_t>(size) : 1));
+    len        = data && size > 0 ? fread(data, 1, static_cast<size_t>(size), f) : 0;
+    fclose(f);
+    return data;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s log_table.bin [capture]\n", argv[0]);
+        return 2;
+    }
+
+    size_t table_len = 0;
+    char* table      = read_file(argv[1], table_len);
+    if (!table) {
+        fprintf(stderr, "can not read %s\n", argv[1]);
+        return 1;
+    }
+    decoder.load(table, table_len);
+    if (decoder.collisions())
+        fprintf(stderr, "warning: %zu formats share an id with another one, reword them\n", decoder.collisions());
+
+    FILE* in = argc > 2 ? fopen(argv[2], "rb") : stdin;
+    if (!in) {
+        fprintf(stderr, "can not read %s\n", argv[2]);
+        return 1;
+    }
+
+    uint8_t line[512];
+    char text[1024];
+    size_t len = 0;
+    int c;
+    while ((c = fgetc(in)) != EOF) {
+        if (c != '\n') {
+            if (len < sizeof(line)) line[len++] = static_cast<uint8_t>(c);
+            continue;
+        }
+        if (!firmware::log_decoder::is_frame(line, len)) printf("%.*s\n", static_cast<int>(len), reinterpret_cast<char*>(line));
+        else if (decoder.decode(line, len, text, sizeof(text))) printf("%s\n", text);
+        else printf("<undecodable frame, %zu bytes>\n", len);
+        len = 0;
+    }
+
+    if (in != stdin) fclose(in);
+    free(table);
+    return 0;
+}
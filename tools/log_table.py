@@ -0,0 +1,22 @@
+# PlatformIO post-build step: copy the binary log formats out of the firmware ELF.
+#
+# The formats of FIRMWARE_LOG_BIN live in the .fwlog section, which is kept in the ELF but never
+# flashed. This writes it to log_table.bin next to firmware.elf, the string table that
+# tools/log_decode reads.
+
+Import("env")
+
+
+def dump_log_table(source, target, env):
+    elf = str(target[0])
+    with open(elf, "rb") as f:
+        if b".fwlog\0" not in f.read():
+            return  # nothing logged through FIRMWARE_LOG_BIN
+    table = env.subst("$BUILD_DIR/log_table.bin")
+    scratch = env.subst("$BUILD_DIR/log_table.elf")
+    env.Execute(env.VerboseAction(
+        '"$OBJCOPY" --dump-section .fwlog="%s" "%s" "%s"' % (table, elf, scratch),
+        "Writing log string table %s" % table))
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", dump_log_table)